@@ -4,6 +4,12 @@
 #include <atomic>
 #include <memory>
 
+#include "utils/time/types.h"
+
+namespace events {
+class InlineEventLoop;
+}
+
 namespace market_stream {
 class SavedMarketStreamForwarder;
 }
@@ -24,9 +30,13 @@ class BenchmarkOrchestrator {
   BenchmarkOrchestrator &operator=(const BenchmarkOrchestrator &) = delete;
   BenchmarkOrchestrator &operator=(BenchmarkOrchestrator &&) = delete;
 
+  // With inline_event_loop set, all events caused by one forwarded item are
+  // processed on the Go() thread before the next item is read. Timed events of
+  // the loop run at their own time, before any later item is forwarded.
   BenchmarkOrchestrator(
       const std::shared_ptr<market_stream::SavedMarketStreamForwarder> &stream_forwarder,
-      bool enable_ts_jump = true);
+      bool enable_ts_jump = true,
+      const std::shared_ptr<events::InlineEventLoop> &inline_event_loop = nullptr);
   virtual ~BenchmarkOrchestrator();
 
   void Go();
@@ -34,12 +44,16 @@ class BenchmarkOrchestrator {
 
  private:
   void OnAllUnitsReady();
+  void MoveClockTo(utils::Timestamp ts);
+  // Runs the timed events of the loop due up to next_data_ts
+  void RunTimedEvents(utils::Timestamp next_data_ts);
 
   const bool is_enabled_ts_jump_;
 
   std::atomic<bool> is_stopped_;
   std::shared_ptr<utils::MockTimeProvider> mock_time_provider_;
   std::shared_ptr<market_stream::SavedMarketStreamForwarder> stream_forwarder_;
+  std::shared_ptr<events::InlineEventLoop> inline_event_loop_;
 };
 
 }  // namespace analyzer
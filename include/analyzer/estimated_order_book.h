@@ -0,0 +1,64 @@
+#ifndef INCLUDE_ANALYZER_ESTIMATED_ORDER_BOOK_H_
+#define INCLUDE_ANALYZER_ESTIMATED_ORDER_BOOK_H_
+
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include "analyzer/order_book_snapshot_provider.h"
+#include "events/event_hub.h"
+#include "market_stream/types/types.h"
+
+namespace analyzer {
+
+// First levels of the latest provider snapshot with the trades executed after it
+// taken out: a trade consumes the levels it went through and its quantity at its
+// price. Depth diffs come every 100 ms while trades come in real time, so this
+// is a fresher estimate of the top of the book. Every new snapshot replaces the
+// estimate, and only the trades newer than the snapshot are applied again.
+class EstimatedOrderBook {
+  using MQMarketStream = events::message_queues::MarketStream;
+  using MQMSEventHubHandler = events::EventHub<MQMarketStream>::Handler;
+
+ public:
+  EstimatedOrderBook() = delete;
+  EstimatedOrderBook(const EstimatedOrderBook &) = delete;
+  EstimatedOrderBook(EstimatedOrderBook &&) = delete;
+  EstimatedOrderBook &operator=(const EstimatedOrderBook &) = delete;
+  EstimatedOrderBook &operator=(EstimatedOrderBook &&) = delete;
+
+  // Readers take the latest provider snapshot with GetSnapshot() and trades the
+  // built one, neither waits for an update whatever wait_for_update of the
+  // provider is
+  EstimatedOrderBook(const std::weak_ptr<MQMSEventHubHandler> &event_handler,
+                     const std::shared_ptr<OrderBookSnapshotProvider> &snapshot_provider,
+                     std::size_t levels_count = 20);
+  ~EstimatedOrderBook() = default;
+
+  // At most levels_count levels per side, timestamps are the ones of the last
+  // applied trade or snapshot
+  market_stream::types::OrderBookDepth GetDepth();
+  market_stream::types::BestBidOffer GetBestBidOffer();
+
+ private:
+  void OnMarketStreamEvent(MQMarketStream::Event event, const void *data);
+
+  // Rebuilds the estimate if snapshot is newer than the estimated one
+  void Reconcile_locked(const OrderBookSnapshotPtr &snapshot);
+  void ApplyTrade_locked(const market_stream::types::Trade &trade);
+
+  std::shared_ptr<OrderBookSnapshotProvider> snapshot_provider_;
+  const std::size_t levels_count_;
+
+  std::mutex mutex_;
+  uint64_t snapshot_version_{0};
+  uint64_t snapshot_timestamp_{0};  // ms
+  market_stream::types::OrderBookDepth depth_;
+  // Trades newer than the snapshot, applied again when it is replaced. Bounded,
+  // the oldest are dropped if no newer snapshot comes.
+  std::deque<market_stream::types::Trade> trades_;
+};
+
+}  // namespace analyzer
+
+#endif  // INCLUDE_ANALYZER_ESTIMATED_ORDER_BOOK_H_
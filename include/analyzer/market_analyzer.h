@@ -29,9 +29,10 @@ class MarketAnalyzer {
   ~MarketAnalyzer() = default;
 
  private:
-  void OnMarketStreamEvent(MQ::Event event, const void *data);
-  void OnNewTrade(const market_stream::types::Trade &trade);
-  void OnOrderBookUpdate(const market_stream::types::OrderBook &update);
+  friend class events::TypedEventHandlerAccess;
+
+  void OnEvent(const market_stream::types::Trade &trade);
+  void OnEvent(const market_stream::types::OrderBook &update);
 
   std::shared_ptr<AnalyzerUnitState> unit_state_;
   std::shared_ptr<ITradingStrategy> strategy_;
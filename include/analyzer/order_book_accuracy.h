@@ -0,0 +1,52 @@
+#ifndef INCLUDE_ANALYZER_ORDER_BOOK_ACCURACY_H_
+#define INCLUDE_ANALYZER_ORDER_BOOK_ACCURACY_H_
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string>
+
+#include "market_stream/types/order_book_columns.h"
+
+namespace analyzer {
+
+// Accuracy of one side of the local book over the first levels of the reference
+struct OrderBookSideAccuracy {
+  std::size_t levels_count{0};  // reference levels compared
+  // Reference levels missing locally plus local levels missing in the reference
+  std::size_t price_mismatches{0};
+  // Levels with the same price and a different quantity
+  std::size_t quantity_mismatches{0};
+  // Reference index of the first mismatching level
+  std::optional<std::size_t> first_mismatch_level;
+  // Same as OrderBookLevels::CosineSimilarity, empty if either vector is zero
+  std::optional<double> similarity;
+};
+
+// Compares a local book against a reference one, e.g. a REST depth snapshot,
+// for all depth buckets in one merge walk per side, without allocations.
+struct OrderBookAccuracy {
+  static constexpr std::size_t kBucketsCount = 4;
+  static constexpr std::array<std::size_t, kBucketsCount> kLevelsCounts = {50, 100,
+                                                                           1000, 4000};
+  using SideBuckets = std::array<OrderBookSideAccuracy, kBucketsCount>;
+
+  uint64_t timestamp{0};  // ms, of the local book
+  SideBuckets bids;
+  SideBuckets asks;
+
+  // Bucket i covers the first kLevelsCounts[i] levels of the reference, or all of
+  // them if it is thinner
+  static void Compare(const market_stream::types::OrderBookLevels &local,
+                      const market_stream::types::OrderBookLevels &reference,
+                      SideBuckets *result);
+  static OrderBookAccuracy Compare(
+      const market_stream::types::OrderBookColumns &local,
+      const market_stream::types::OrderBookColumns &reference);
+
+  std::string ToJson() const;
+};
+
+}  // namespace analyzer
+
+#endif  // INCLUDE_ANALYZER_ORDER_BOOK_ACCURACY_H_
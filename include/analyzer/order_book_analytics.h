@@ -0,0 +1,72 @@
+#ifndef INCLUDE_ANALYZER_ORDER_BOOK_ANALYTICS_H_
+#define INCLUDE_ANALYZER_ORDER_BOOK_ANALYTICS_H_
+
+#include <optional>
+
+#include "analyzer/order_book_engine.h"
+#include "market_stream/types/types.h"
+
+namespace analyzer {
+
+// Queries over one side of the book answered from the running totals of its
+// levels: depth in O(1), cost to fill a quantity in O(log N). Views the levels,
+// which must outlive it.
+class OrderBookSideAnalytics {
+  using Items = market_stream::types::OrderBook::Items;
+
+ public:
+  OrderBookSideAnalytics() = delete;
+  // totals are the running totals of levels, e.g. maintained by OrderBookSide
+  OrderBookSideAnalytics(const Items *levels, OrderBookSideTotals &&totals);
+  // Calculates the running totals of levels
+  explicit OrderBookSideAnalytics(const Items *levels);
+
+  std::size_t size() const { return levels_->size(); }
+
+  // Total quantity of the first levels_count levels
+  double Depth(std::size_t levels_count) const;
+  // Total price of quantity taken from the best levels, i.e. of a market order
+  // of that quantity. Empty if the side is thinner.
+  std::optional<double> CostToFill(double quantity) const;
+  // Average price of the same market order
+  std::optional<double> AveragePriceToFill(double quantity) const;
+
+ private:
+  const Items *levels_;
+  const OrderBookSideTotals totals_;
+};
+
+class OrderBookAnalytics {
+ public:
+  OrderBookAnalytics() = delete;
+  OrderBookAnalytics(const OrderBookAnalytics &) = delete;
+  OrderBookAnalytics(OrderBookAnalytics &&) = delete;
+  OrderBookAnalytics &operator=(const OrderBookAnalytics &) = delete;
+  OrderBookAnalytics &operator=(OrderBookAnalytics &&) = delete;
+
+  // Views order_book, which must outlive it
+  OrderBookAnalytics(const market_stream::types::OrderBook *order_book,
+                     OrderBookSideTotals &&bids_totals,
+                     OrderBookSideTotals &&asks_totals);
+  explicit OrderBookAnalytics(const market_stream::types::OrderBook *order_book);
+  ~OrderBookAnalytics() = default;
+
+  const OrderBookSideAnalytics &bids() const { return bids_; }
+  const OrderBookSideAnalytics &asks() const { return asks_; }
+
+  // (bids depth - asks depth) / (bids depth + asks depth) over the first
+  // levels_count levels, in [-1, 1]. Empty if both sides are empty.
+  std::optional<double> Imbalance(std::size_t levels_count) const;
+  // Best prices weighted by the opposite best quantities, leans towards the side
+  // that is more likely to move. Empty if a side is empty.
+  std::optional<double> Microprice() const;
+
+ private:
+  const market_stream::types::OrderBook *order_book_;
+  const OrderBookSideAnalytics bids_;
+  const OrderBookSideAnalytics asks_;
+};
+
+}  // namespace analyzer
+
+#endif  // INCLUDE_ANALYZER_ORDER_BOOK_ANALYTICS_H_
@@ -0,0 +1,345 @@
+#ifndef INCLUDE_ANALYZER_ORDER_BOOK_ENGINE_H_
+#define INCLUDE_ANALYZER_ORDER_BOOK_ENGINE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "market_stream/types/types.h"
+
+namespace analyzer {
+
+// Quantity and notional of a level and all better levels. The quantity is a
+// double since the sum of many levels may not fit FixedPoint.
+struct OrderBookLevelTotals {
+  double quantity{0.0};
+  double notional{0.0};
+};
+
+using OrderBookSideTotals = std::vector<OrderBookLevelTotals>;
+
+// Sorted levels of one side and their running totals, counted from the first
+// level of the chunk
+struct OrderBookSideChunk {
+  market_stream::types::OrderBook::Items levels;
+  OrderBookSideTotals totals;
+};
+
+// Levels of one side at some moment. Shares the chunks of the side it was taken
+// from, which copies a chunk before changing it while it is shared, so taking it
+// costs one pointer per chunk and it stays valid while the side changes.
+class OrderBookSideLevels {
+  using Items = market_stream::types::OrderBook::Items;
+
+ public:
+  OrderBookSideLevels() = default;
+  OrderBookSideLevels(std::vector<std::shared_ptr<const OrderBookSideChunk>> &&chunks,
+                      std::size_t size)
+      : chunks_(std::move(chunks)), size_(size) {}
+
+  std::size_t size() const { return size_; }
+  // Copies at most levels_count best levels, reuses the capacity of items
+  void CopyTo(Items *items,
+              std::size_t levels_count = std::numeric_limits<std::size_t>::max()) const;
+  // Running totals of all levels, see OrderBookSide::totals. Summed from the
+  // totals kept by the chunks, the levels are not read.
+  void CopyTotalsTo(OrderBookSideTotals *totals) const;
+
+ private:
+  std::vector<std::shared_ptr<const OrderBookSideChunk>> chunks_;
+  std::size_t size_{0};
+};
+
+// One side of the book, best level first, updated in place by diffs. Levels are
+// kept in sorted chunks of kChunkLevels to 2 * kChunkLevels levels, found by a
+// binary search over the worst level of every chunk, so insert and erase shift
+// only the levels of one chunk and update only its totals. BetterPrice is
+// std::greater for bids and std::less for asks.
+template <typename BetterPrice>
+class OrderBookSide {
+  using Item = market_stream::types::OrderBook::Item;
+  using Items = market_stream::types::OrderBook::Items;
+
+ public:
+  static constexpr std::size_t kChunkLevels = 64;
+
+  OrderBookSide() = delete;
+  // Levels beyond max_levels are dropped
+  explicit OrderBookSide(std::size_t max_levels) : max_levels_(max_levels) {}
+
+  std::size_t size() const { return size_; }
+  bool empty() const { return 0 == size_; }
+  const Item &front() const { return chunks_.front()->levels.front(); }
+
+  // Zero quantity removes the level. Depth is bounded after the whole update,
+  // so levels removed by it make room for levels behind them.
+  void Apply(const Items &update) {
+    for (const auto &it : update) {
+      ApplyLevel(it);
+    }
+    while (size_ > max_levels_) {
+      const std::size_t excess = size_ - max_levels_;
+      if (chunks_.back()->levels.size() <= excess) {
+        size_ -= chunks_.back()->levels.size();
+        chunks_.pop_back();
+      } else {
+        OrderBookSideChunk &chunk = MutableChunk(chunks_.size() - 1);
+        chunk.levels.resize(chunk.levels.size() - excess);
+        chunk.totals.resize(chunk.levels.size());
+        size_ -= excess;
+      }
+    }
+  }
+
+  // Element i holds the totals of the first i + 1 levels. Updated on call from
+  // the first level changed since the previous one, by adding the totals kept
+  // by the chunks, so diffs cost nothing more until the totals are read.
+  const OrderBookSideTotals &totals() const {
+    UpdateTotals();
+    return totals_;
+  }
+
+  // Both sides must have the same max_levels
+  void Swap(OrderBookSide *other) {
+    chunks_.swap(other->chunks_);
+    std::swap(size_, other->size_);
+    totals_.swap(other->totals_);
+    std::swap(first_stale_total_, other->first_stale_total_);
+  }
+
+  // Copies at most levels_count best levels, reuses the capacity of items
+  void CopyTo(Items *items,
+              std::size_t levels_count = std::numeric_limits<std::size_t>::max()) const {
+    items->clear();
+    for (auto it = chunks_.begin(); chunks_.end() != it && items->size() < levels_count;
+         ++it) {
+      const auto &levels = (*it)->levels;
+      const std::size_t count = std::min(levels_count - items->size(), levels.size());
+      items->insert(items->end(), levels.begin(), levels.begin() + count);
+    }
+  }
+
+  // Levels as of now, see OrderBookSideLevels
+  OrderBookSideLevels levels() const {
+    return OrderBookSideLevels(std::vector<std::shared_ptr<const OrderBookSideChunk>>(
+                                   chunks_.begin(), chunks_.end()),
+                               size_);
+  }
+
+ private:
+  void ApplyLevel(const Item &item) {
+    // First chunk whose worst level is not better than the price
+    auto chunk_it = std::lower_bound(
+        chunks_.begin(), chunks_.end(), item.price,
+        [](const std::shared_ptr<OrderBookSideChunk> &chunk,
+           const market_stream::types::FixedPoint &price) {
+          return BetterPrice()(chunk->levels.back().price, price);
+        });
+    if (chunks_.end() == chunk_it) {
+      if (item.quantity.is_zero()) {
+        return;
+      }
+      // Worse than every level, appended to the last chunk
+      if (chunks_.empty()) {
+        chunks_.push_back(std::make_shared<OrderBookSideChunk>());
+      }
+      chunk_it = chunks_.end() - 1;
+    }
+    const std::size_t chunk_index = chunk_it - chunks_.begin();
+    const Items &levels = (*chunk_it)->levels;
+    auto it = std::lower_bound(
+        levels.begin(), levels.end(), item.price,
+        [](const Item &level, const market_stream::types::FixedPoint &price) {
+          return BetterPrice()(level.price, price);
+        });
+    const std::size_t offset = it - levels.begin();
+    if (levels.end() != it && it->price == item.price) {
+      if (item.quantity.is_zero()) {
+        EraseLevel(chunk_index, offset);
+      } else {
+        OrderBookSideChunk &chunk = MutableChunk(chunk_index);
+        chunk.levels[offset].quantity = item.quantity;
+        UpdateChunkTotals(&chunk, offset);
+      }
+    } else if (!item.quantity.is_zero()) {
+      InsertLevel(chunk_index, offset, item);
+    } else {
+      return;
+    }
+    MarkTotalsStale(chunk_index, offset);
+  }
+
+  void InsertLevel(std::size_t chunk_index, std::size_t offset, const Item &item) {
+    OrderBookSideChunk &chunk = MutableChunk(chunk_index);
+    chunk.levels.insert(chunk.levels.begin() + offset, item);
+    ++size_;
+    if (chunk.levels.size() > 2 * kChunkLevels) {
+      auto tail = std::make_shared<OrderBookSideChunk>();
+      tail->levels.assign(chunk.levels.begin() + kChunkLevels, chunk.levels.end());
+      UpdateChunkTotals(tail.get(), 0);
+      chunk.levels.resize(kChunkLevels);
+      chunks_.insert(chunks_.begin() + chunk_index + 1, std::move(tail));
+    }
+    UpdateChunkTotals(&chunk, std::min(offset, chunk.levels.size()));
+  }
+
+  void EraseLevel(std::size_t chunk_index, std::size_t offset) {
+    OrderBookSideChunk &chunk = MutableChunk(chunk_index);
+    chunk.levels.erase(chunk.levels.begin() + offset);
+    --size_;
+    if (chunk.levels.empty()) {
+      chunks_.erase(chunks_.begin() + chunk_index);
+      return;
+    }
+    if (chunk_index + 1 < chunks_.size() &&
+        chunk.levels.size() + chunks_[chunk_index + 1]->levels.size() <= kChunkLevels) {
+      // Keeps the chunks count, and so the cost of levels(), bounded
+      const auto &next = chunks_[chunk_index + 1]->levels;
+      chunk.levels.insert(chunk.levels.end(), next.begin(), next.end());
+      chunks_.erase(chunks_.begin() + chunk_index + 1);
+    }
+    UpdateChunkTotals(&chunk, offset);
+  }
+
+  // Copies the chunk first if levels taken before still share it
+  OrderBookSideChunk &MutableChunk(std::size_t chunk_index) {
+    auto &chunk = chunks_[chunk_index];
+    if (1 != chunk.use_count()) {
+      chunk = std::make_shared<OrderBookSideChunk>(*chunk);
+    } else {
+      // The last other owner may have been released on another thread, its reads
+      // of the chunk must happen before the changes
+      std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    return *chunk;
+  }
+
+  // Totals of the levels of the chunk better than first_level are kept
+  static void UpdateChunkTotals(OrderBookSideChunk *chunk, std::size_t first_level) {
+    chunk->totals.resize(chunk->levels.size());
+    for (std::size_t i = first_level; i < chunk->levels.size(); i++) {
+      OrderBookLevelTotals level_totals;
+      if (0 != i) {
+        level_totals = chunk->totals[i - 1];
+      }
+      const auto &level = chunk->levels[i];
+      const double quantity = level.quantity.ToDouble();
+      level_totals.quantity += quantity;
+      level_totals.notional += level.price.ToDouble() * quantity;
+      chunk->totals[i] = level_totals;
+    }
+  }
+
+  // Levels are counted only up to the first stale total, which is the top of the
+  // book for most diffs
+  void MarkTotalsStale(std::size_t chunk_index, std::size_t offset) {
+    std::size_t level = offset;
+    for (std::size_t i = 0; i < chunk_index && level < first_stale_total_; i++) {
+      level += chunks_[i]->levels.size();
+    }
+    first_stale_total_ = std::min(first_stale_total_, level);
+  }
+
+  // Totals of the levels better than the first changed one are kept
+  void UpdateTotals() const {
+    totals_.resize(size_);
+    std::size_t chunk_first_level = 0;
+    for (const auto &chunk : chunks_) {
+      const std::size_t chunk_end_level = chunk_first_level + chunk->levels.size();
+      OrderBookLevelTotals better_chunks_totals;
+      if (0 != chunk_first_level) {
+        better_chunks_totals = totals_[chunk_first_level - 1];
+      }
+      for (std::size_t i = std::max(first_stale_total_, chunk_first_level);
+           i < chunk_end_level; i++) {
+        const auto &chunk_totals = chunk->totals[i - chunk_first_level];
+        totals_[i].quantity = better_chunks_totals.quantity + chunk_totals.quantity;
+        totals_[i].notional = better_chunks_totals.notional + chunk_totals.notional;
+      }
+      chunk_first_level = chunk_end_level;
+    }
+    first_stale_total_ = std::numeric_limits<std::size_t>::max();
+  }
+
+  // No chunk is empty and every chunk has the totals of all its levels. Shared
+  // with the levels taken by levels(), changed by this side only.
+  std::vector<std::shared_ptr<OrderBookSideChunk>> chunks_;
+  std::size_t size_{0};
+  // Cache of totals(), not thread safe like the rest of the side
+  mutable OrderBookSideTotals totals_;
+  mutable std::size_t first_stale_total_{0};
+  const std::size_t max_levels_;
+};
+
+using OrderBookBids = OrderBookSide<std::greater<market_stream::types::FixedPoint>>;
+using OrderBookAsks = OrderBookSide<std::less<market_stream::types::FixedPoint>>;
+
+// Book at some moment, see OrderBookSideLevels
+struct OrderBookLevels {
+  uint64_t timestamp{0};
+  uint64_t received_timestamp{0};
+  OrderBookSideLevels bids;
+  OrderBookSideLevels asks;
+
+  void CopyTo(market_stream::types::OrderBook *order_book) const;
+};
+
+class OrderBookEngine {
+ public:
+  OrderBookEngine() = delete;
+  explicit OrderBookEngine(std::size_t max_levels)
+      : bids_(max_levels), asks_(max_levels) {}
+
+  void Apply(const market_stream::types::OrderBook &update) {
+    timestamp_ = update.timestamp;
+    received_timestamp_ = update.received_timestamp;
+    bids_.Apply(update.bids);
+    asks_.Apply(update.asks);
+  }
+
+  void CopyTo(market_stream::types::OrderBook *order_book) const {
+    order_book->timestamp = timestamp_;
+    order_book->received_timestamp = received_timestamp_;
+    bids_.CopyTo(&order_book->bids);
+    asks_.CopyTo(&order_book->asks);
+  }
+
+  // Replaces the book with the one built by other, e.g. aside while this one was
+  // still read. Both engines must have the same max_levels.
+  void Swap(OrderBookEngine *other) {
+    std::swap(timestamp_, other->timestamp_);
+    std::swap(received_timestamp_, other->received_timestamp_);
+    bids_.Swap(&other->bids_);
+    asks_.Swap(&other->asks_);
+  }
+
+  // Book as of now, cheap to take and valid while this one changes
+  OrderBookLevels levels() const {
+    return OrderBookLevels{timestamp_, received_timestamp_, bids_.levels(),
+                           asks_.levels()};
+  }
+
+  uint64_t timestamp() const { return timestamp_; }
+  uint64_t received_timestamp() const { return received_timestamp_; }
+  const OrderBookBids &bids() const { return bids_; }
+  const OrderBookAsks &asks() const { return asks_; }
+
+ private:
+  uint64_t timestamp_{0};
+  uint64_t received_timestamp_{0};
+  OrderBookBids bids_;
+  OrderBookAsks asks_;
+};
+
+// Previous per-diff algorithm: merges the update into a new copy of every level.
+// Kept as the reference for the engine benchmark and tests.
+market_stream::types::OrderBook::Items MergeOrderBookItems(
+    const market_stream::types::OrderBook::Items &old_items,
+    const market_stream::types::OrderBook::Items &update, bool is_items_order_increasing);
+
+}  // namespace analyzer
+
+#endif  // INCLUDE_ANALYZER_ORDER_BOOK_ENGINE_H_
@@ -0,0 +1,68 @@
+#ifndef INCLUDE_ANALYZER_ORDER_BOOK_HISTORY_H_
+#define INCLUDE_ANALYZER_ORDER_BOOK_HISTORY_H_
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "analyzer/order_book_engine.h"
+#include "market_stream/types/types.h"
+#include "utils/time/types.h"
+
+namespace analyzer {
+
+// Book states of the last duration by received timestamp: a full checkpoint
+// every checkpoint_interval updates and the diffs between checkpoints. A query
+// merges at most checkpoint_interval diffs into the nearest older checkpoint.
+class OrderBookHistory {
+ public:
+  OrderBookHistory() = delete;
+  OrderBookHistory(const OrderBookHistory &) = delete;
+  OrderBookHistory(OrderBookHistory &&) = delete;
+  OrderBookHistory &operator=(const OrderBookHistory &) = delete;
+  OrderBookHistory &operator=(OrderBookHistory &&) = delete;
+
+  // max_levels must be the one of the engine the updates are recorded from
+  OrderBookHistory(std::size_t max_levels, std::size_t checkpoint_interval);
+  ~OrderBookHistory() = default;
+
+  // Zero duration, the default, keeps nothing
+  void set_duration(utils::TimestampPrecision duration);  // ms
+
+  // update is a diff just merged into engine
+  void Record(const market_stream::types::OrderBook &update,
+              const OrderBookEngine &engine);
+  // engine holds a book that replaces the recorded one, e.g. after a resync
+  void RecordCheckpoint(const OrderBookEngine &engine);
+
+  // Book as of the last update received at or before ts, empty if ts is older
+  // than the kept history
+  std::optional<market_stream::types::OrderBook> GetSnapshotAt(utils::Timestamp ts) const;
+  // First levels_count levels of the same book
+  std::optional<market_stream::types::OrderBookDepth> GetTopNAt(
+      utils::Timestamp ts, std::size_t levels_count) const;
+
+ private:
+  struct Segment {
+    market_stream::types::OrderBook checkpoint;
+    std::vector<market_stream::types::OrderBook> diffs;
+  };
+
+  // Merges the history up to ts into an empty engine
+  bool Replay_locked(utils::Timestamp ts, OrderBookEngine *engine) const;
+  void StartSegment_locked(const OrderBookEngine &engine);
+  void DropOldSegments_locked();
+
+  const std::size_t max_levels_;
+  const std::size_t checkpoint_interval_;
+  std::atomic<utils::TimestampPrecision> duration_{0};
+
+  mutable std::mutex mutex_;
+  std::deque<Segment> segments_;
+};
+
+}  // namespace analyzer
+
+#endif  // INCLUDE_ANALYZER_ORDER_BOOK_HISTORY_H_
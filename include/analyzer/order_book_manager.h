@@ -0,0 +1,97 @@
+#ifndef INCLUDE_ANALYZER_ORDER_BOOK_MANAGER_H_
+#define INCLUDE_ANALYZER_ORDER_BOOK_MANAGER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "analyzer/order_book_engine.h"
+#include "analyzer/order_book_snapshot_provider.h"
+#include "market_stream/types/types.h"
+
+namespace analyzer {
+
+struct OrderBookManagerOptions {
+  std::size_t shards_count{0};  // 0 means one per hardware core, at most one per symbol
+  std::size_t max_levels{6000};
+  int first_cpu{-1};  // shard i worker is pinned to first_cpu + i, -1 to not pin
+};
+
+// Books of many symbols in one process. Symbols are spread over a fixed set of
+// shards by hash, each shard owns its books and one worker thread that applies
+// their diffs, so the thread count does not grow with the symbols count.
+class OrderBookManager {
+ public:
+  OrderBookManager() = delete;
+  OrderBookManager(const OrderBookManager &) = delete;
+  OrderBookManager(OrderBookManager &&) = delete;
+  OrderBookManager &operator=(const OrderBookManager &) = delete;
+  OrderBookManager &operator=(OrderBookManager &&) = delete;
+
+  explicit OrderBookManager(const std::vector<std::string> &symbols,
+                            const OrderBookManagerOptions &options = {});
+  ~OrderBookManager();
+
+  // Queues update to the shard of symbol, false if symbol is not managed or the
+  // manager is shut down
+  bool Apply(const std::string &symbol, market_stream::types::OrderBook &&update);
+
+  // Built by the first call after an update, its version is the count of the
+  // applied updates. nullptr if symbol is not managed.
+  OrderBookSnapshotPtr GetSnapshot(const std::string &symbol);
+  // Empty if symbol is not managed
+  std::optional<market_stream::types::BestBidOffer> GetBestBidOffer(
+      const std::string &symbol);
+
+  // Applies the queued updates and joins the workers, books stay readable but
+  // later updates are not applied
+  void Shutdown();
+
+  std::size_t shards_count() const { return shards_.size(); }
+
+ private:
+  struct Shard;
+
+  struct Book {
+    Book(Shard *_shard, std::size_t max_levels) : shard(_shard), engine(max_levels) {}
+
+    Shard *const shard;
+    // Taken by the shard worker per update and by readers, which copy the
+    // levels after releasing it
+    std::mutex mutex;
+    OrderBookEngine engine;
+    market_stream::types::BestBidOffer best_bid_offer;
+    OrderBookSnapshotPtr snapshot;
+    uint64_t version{0};
+  };
+
+  // Aligned, so workers of neighbour shards do not share cache lines
+  struct alignas(64) Shard {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::pair<Book *, market_stream::types::OrderBook>> updates;
+    bool is_stopped{false};
+    // Allocated in chunks, books of a shard stay close to each other
+    std::deque<Book> books;
+    std::thread thread;
+  };
+
+  void WorkerLoop(Shard *shard, int cpu, std::size_t shard_index);
+  static void ApplyUpdate(Book *book, const market_stream::types::OrderBook &update);
+  Book *FindBook(const std::string &symbol) const;
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+  // Filled by the constructor only, so read without a lock
+  std::unordered_map<std::string, Book *> books_;
+};
+
+}  // namespace analyzer
+
+#endif  // INCLUDE_ANALYZER_ORDER_BOOK_MANAGER_H_
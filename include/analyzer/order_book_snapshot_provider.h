@@ -1,23 +1,88 @@
-#ifndef INCLUDE_ANALYZER_MARKET_STREAM_PRINTER_H_
-#define INCLUDE_ANALYZER_MARKET_STREAM_PRINTER_H_
+#ifndef INCLUDE_ANALYZER_ORDER_BOOK_SNAPSHOT_PROVIDER_H_
+#define INCLUDE_ANALYZER_ORDER_BOOK_SNAPSHOT_PROVIDER_H_
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <ostream>
 #include <thread>
 #include <vector>
 
 #include "analyzer/observable_units.h"
+#include "analyzer/order_book_analytics.h"
+#include "analyzer/order_book_engine.h"
+#include "analyzer/order_book_history.h"
 #include "events/event_hub.h"
+#include "market_stream/types/order_book_columns.h"
 #include "market_stream/types/types.h"
+#include "utils/time/types.h"
 
 namespace analyzer {
 
+// Immutable order book of one version, shared by all readers of that version
+class OrderBookSnapshot {
+ public:
+  OrderBookSnapshot() = delete;
+  OrderBookSnapshot(const OrderBookSnapshot &) = delete;
+  OrderBookSnapshot(OrderBookSnapshot &&) = delete;
+  OrderBookSnapshot &operator=(const OrderBookSnapshot &) = delete;
+  OrderBookSnapshot &operator=(OrderBookSnapshot &&) = delete;
+
+  OrderBookSnapshot(uint64_t version, market_stream::types::OrderBook &&order_book)
+      : version_(version), order_book_(std::move(order_book)), analytics_(&order_book_) {}
+  // Takes the running totals kept by the engine instead of calculating them
+  OrderBookSnapshot(uint64_t version, market_stream::types::OrderBook &&order_book,
+                    OrderBookSideTotals &&bids_totals, OrderBookSideTotals &&asks_totals)
+      : version_(version),
+        order_book_(std::move(order_book)),
+        analytics_(&order_book_, std::move(bids_totals), std::move(asks_totals)) {}
+  ~OrderBookSnapshot() = default;
+
+  uint64_t version() const { return version_; }
+  utils::Timestamp received_timestamp() const { return order_book_.received_timestamp; }
+  const market_stream::types::OrderBook &order_book() const { return order_book_; }
+  // Depth, imbalance, microprice and cost to fill without walking the levels
+  const OrderBookAnalytics &analytics() const { return analytics_; }
+  // Built by the first caller for the order book kernels
+  const market_stream::types::OrderBookColumns &columns() const;
+
+ private:
+  const uint64_t version_;
+  const market_stream::types::OrderBook order_book_;
+  const OrderBookAnalytics analytics_;
+  mutable std::once_flag columns_once_;
+  mutable std::unique_ptr<const market_stream::types::OrderBookColumns> columns_;
+};
+
+using OrderBookSnapshotPtr = std::shared_ptr<const OrderBookSnapshot>;
+
+// Book of one version as published by the writer. Shares the levels and their
+// running totals with the writer instead of copying them, readers copy what they
+// need at their own pace.
+struct PublishedOrderBook {
+  uint64_t version;
+  OrderBookLevels levels;
+};
+
+using PublishedOrderBookPtr = std::shared_ptr<const PublishedOrderBook>;
+
+enum class OrderBookDiffMode {
+  kEager = 0,  // every diff is merged into the book on arrival
+  kLazy,       // diffs are buffered, the last quantity of a price wins, and merged
+               // at once when the book is read: by GetSnapshot or because
+               // OrderBookStream events have subscribers
+};
+
 class OrderBookSnapshotProvider {
   using MQMarketStream = events::message_queues::MarketStream;
   using MQOrderBookStream = events::message_queues::OrderBookStream;
   using MQMSEventHubHandler = events::EventHub<MQMarketStream>::Handler;
   using MQOSEventHubDispatcher = events::EventHub<MQOrderBookStream>::Dispatcher;
+  using MQOSEventHubHandler = events::EventHub<MQOrderBookStream>::Handler;
 
  public:
   OrderBookSnapshotProvider() = delete;
@@ -26,33 +91,130 @@ class OrderBookSnapshotProvider {
   OrderBookSnapshotProvider &operator=(const OrderBookSnapshotProvider &) = delete;
   OrderBookSnapshotProvider &operator=(OrderBookSnapshotProvider &&) = delete;
 
+  // wait_for_update must be false when the MarketStream hub is processed inline
+  // on the same thread as GetSnapshot callers: the awaited update is never forwarded
   OrderBookSnapshotProvider(
       const std::weak_ptr<MQMSEventHubHandler> &event_handler,
       const std::weak_ptr<MQOSEventHubDispatcher> &dispatcher,
-      const std::shared_ptr<OrderBookSnapshotProviderUnitState> &unit_state);
+      const std::shared_ptr<OrderBookSnapshotProviderUnitState> &unit_state,
+      bool wait_for_update = true,
+      OrderBookDiffMode diff_mode = OrderBookDiffMode::kEager);
+  // Mirrors snapshots built by another provider, e.g. in another process behind
+  // the shared memory bus, instead of building the book from MarketStream updates
+  OrderBookSnapshotProvider(
+      const std::weak_ptr<MQOSEventHubHandler> &snapshot_handler,
+      const std::shared_ptr<OrderBookSnapshotProviderUnitState> &unit_state,
+      bool wait_for_update = true);
   ~OrderBookSnapshotProvider() = default;
 
-  market_stream::types::OrderBook GetSnapshot(utils::Timestamp last_update_ts = 0);
+  // Waits for an update not older than last_update_ts if wait_for_update is set,
+  // otherwise returns the latest snapshot. Readers share the published snapshot,
+  // which is replaced, not modified, by updates. The first reader after an update
+  // builds it from the published book, the writer goes on meanwhile. Versions
+  // count the changes of the book, versions nobody read are skipped.
+  OrderBookSnapshotPtr GetSnapshot(utils::Timestamp last_update_ts = 0);
+  // Same as GetSnapshot, but waits for a version newer than the given one
+  OrderBookSnapshotPtr GetNextSnapshot(uint64_t version);
+  // Latest built snapshot. Never merges the pending diffs nor builds the snapshot
+  // of a changed book, so it may be older than GetSnapshot, but it is cheap
+  // enough to poll for a new version.
+  OrderBookSnapshotPtr GetBuiltSnapshot() const;
+  // Latest book, merges the pending diffs but copies nothing. Empty for a mirror.
+  PublishedOrderBookPtr GetPublishedBook();
+
+  // Enables kDepthChanged events. Every subscriber requests its own levels_count,
+  // the events carry the deepest one requested and subscribers read their first
+  // levels_count levels.
+  void RequestDepthLevels(std::size_t levels_count);
+
+  // Keeps the book states of the last duration for GetSnapshotAt and GetTopNAt,
+  // nothing is kept by default. Only books built from MarketStream updates are
+  // kept, in lazy mode one state per merge of the buffered diffs.
+  void KeepHistory(std::chrono::seconds duration);
+  // Book as of the last update received at or before ts, empty if ts is older
+  // than the kept history. Does not wait for updates.
+  std::optional<market_stream::types::OrderBook> GetSnapshotAt(utils::Timestamp ts);
+  // First levels_count levels of the same book
+  std::optional<market_stream::types::OrderBookDepth> GetTopNAt(
+      utils::Timestamp ts, std::size_t levels_count);
 
  private:
   void OnMarketStreamEvent(MQMarketStream::Event event, const void *data);
   void OnOrderBookUpdateEvent(market_stream::types::OrderBook update);
-
-  void PrepareItems(market_stream::types::OrderBook::Items *items,
-                    bool is_items_order_increaseing);
-  market_stream::types::OrderBook::Items UpdateOrderBookItems(
-      const market_stream::types::OrderBook::Items &old_items,
-      const market_stream::types::OrderBook::Items &update,
-      bool is_items_order_increaseing);
+  // Builds the fetched book aside and switches to it, readers see the old book
+  // until the switch and then a kOrderBookResynced event
+  void OnOrderBookResyncEvent(const market_stream::types::OrderBookResync &resync);
+  // Merges update into the book and publishes it. engine_mutex_ is held in lazy
+  // mode, the only one in which readers change the book.
+  void ApplyUpdate(const market_stream::types::OrderBook &update);
+  // Publishes the levels of the engine, wakes the parked readers and dispatches
+  // the events. The snapshot is built right away only for kNewSnapshotAvailable
+  // subscribers, otherwise by the first reader, so books nobody reads are never
+  // copied.
+  void PublishBook();
+  // Copies the book and installs the snapshot unless a newer one was installed
+  OrderBookSnapshotPtr BuildSnapshot(const PublishedOrderBook &book);
+  OrderBookSnapshotPtr InstallSnapshot(OrderBookSnapshotPtr snapshot);
+  void WakeParkedReaders();
+  void BufferDiff_locked(const market_stream::types::OrderBook &update);
+  void ApplyPendingDiffs_locked();
+  void MergePendingDiffs();
+  bool HasOrderBookStreamSubscribers() const;
+  void OnOrderBookStreamEvent(MQOrderBookStream::Event event, const void *data);
 
   bool CheckItemsOrder(const market_stream::types::OrderBook::Items &items,
                        bool is_items_order_increaseing);
   bool IsCurrentSnapshotActual_locked() const;
 
-  mutable std::mutex mutex_;
-  std::condition_variable cv_;
+  // Filled from the engine, not from the snapshot, so only the first levels are
+  // copied. Sent only when they differ from the previously sent ones.
+  void DispatchBestBidOffer(MQOSEventHubDispatcher *dispatcher);
+  void DispatchDepth(MQOSEventHubDispatcher *dispatcher);
 
-  market_stream::types::OrderBook order_book_;
+  // Merges the pending diffs and builds the snapshot if the book changed since
+  // the last one
+  OrderBookSnapshotPtr LoadSnapshot();
+  // Version of the latest book, built or not
+  uint64_t LatestVersion() const;
+  // Spins, then parks until is_ready accepts the published snapshot
+  template <typename Predicate>
+  OrderBookSnapshotPtr WaitForSnapshot(Predicate is_ready);
+
+  // Written by the event worker. In lazy mode also by readers merging the pending
+  // diffs, everything below is then under engine_mutex_.
+  OrderBookEngine engine_;
+  uint64_t version_{0};
+  market_stream::types::BestBidOffer best_bid_offer_;
+  market_stream::types::OrderBookDepth depth_;
+
+  const OrderBookDiffMode diff_mode_;
+  std::mutex engine_mutex_;
+  market_stream::types::OrderBook pending_update_;  // timestamps of the last diff
+  std::map<market_stream::types::FixedPoint, market_stream::types::FixedPoint,
+           std::greater<market_stream::types::FixedPoint>>
+      pending_bids_;
+  std::map<market_stream::types::FixedPoint, market_stream::types::FixedPoint>
+      pending_asks_;
+  // Checked by readers without engine_mutex_
+  std::atomic<bool> has_pending_diffs_{false};
+
+  std::atomic<std::size_t> depth_levels_{0};
+  // Locks itself, queried by readers
+  OrderBookHistory history_;
+
+  // Accessed with the std::atomic_ functions only
+  PublishedOrderBookPtr book_;
+  OrderBookSnapshotPtr snapshot_;
+  const bool wait_for_update_;
+  // Taken by readers building a snapshot, so the others wait for it instead of
+  // building the same one. Never taken by the writer.
+  std::mutex build_mutex_;
+
+  // Taken only by parked readers and by the writer if there are any. Taken after
+  // engine_mutex_, never before.
+  std::mutex wait_mutex_;
+  std::condition_variable cv_;
+  std::atomic<int> parked_readers_{0};
 
   std::weak_ptr<MQOSEventHubDispatcher> dispatcher_;
   std::shared_ptr<OrderBookSnapshotProviderUnitState> unit_state_;
@@ -60,4 +222,4 @@ class OrderBookSnapshotProvider {
 
 }  // namespace analyzer
 
-#endif  // INCLUDE_ANALYZER_MARKET_STREAM_PRINTER_H_
\ No newline at end of file
+#endif  // INCLUDE_ANALYZER_ORDER_BOOK_SNAPSHOT_PROVIDER_H_
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define INCLUDE_ANALYZER_ORDER_PLAN_MANAGER_H_
 
 #include <condition_variable>
+#include <future>
 #include <memory>
 #include <thread>
 
@@ -9,8 +10,13 @@
 #include "events/event_hub.h"
 #include "market_stream/types/types.h"
 #include "types/types.h"
+#include "utils/time/elapsed_time_meter.h"
 #include "utils/time/types.h"
 
+namespace events {
+class InlineEventLoop;
+}
+
 namespace analyzer {
 
 class OrderManager;
@@ -31,7 +37,8 @@ class OrderPlanManager {
       const std::weak_ptr<EventHubHandler> &event_handler,
       const std::shared_ptr<OrderManager> &order_manager,
       const std::shared_ptr<OrderPlanManagerUnitState> &unit_state,
-      const std::shared_ptr<BenchmarkDataCollector> &benchmark_data_collector);
+      const std::shared_ptr<BenchmarkDataCollector> &benchmark_data_collector,
+      const std::shared_ptr<events::InlineEventLoop> &inline_event_loop = nullptr);
   ~OrderPlanManager();
 
  private:
@@ -43,16 +50,41 @@ class OrderPlanManager {
     kSellOrderTimeout,
     COUNT
   };
+  enum class PendingOrderStatus { kPending = 0, kFinished, kExpired };
 
   void OnOrderPlanStreamEvent(MQ::Event event, const void *data);
-  void ProcessOrderPlan(types::OrderPlanInfo);
-  bool ExecOrder(const types::OrderInfo &order, utils::Timestamp expiration_ts,
-                 types::OrderResult *result);
+  void OrderPlansProcessThread();
+
+  // Both modes go through the same stages: StartOrderPlan places the buy order,
+  // then AdvanceOrderPlan is called every time the pending order is done and
+  // places the order of the next stage. Both return false once the plan is
+  // reported.
+  bool StartOrderPlan();
+  bool AdvanceOrderPlan(bool is_order_filled, const types::OrderResult &result);
+  // Returns false if the limit order has already expired
+  bool PlaceOrder(const types::OrderInfo &order, utils::Timestamp expiration_ts,
+                  OrderPlanStage stage);
+  void PlaceMarketSellOrder();
+  void CancelPendingOrder(std::chrono::seconds max_response_time,
+                          types::OrderResult *result);
   void SendReport(market_stream::types::DoubleType buy_price,
                   market_stream::types::DoubleType sold_price,
-                  utils::Timestamp start_time_ms, utils::TimestampPrecision duration_ms,
                   types::OrderPlanReport::Status status);
-  void OrderPlansProcessThread();
+  void FinishOrderPlan();
+
+  // Threaded mode, blocks until the pending order is done, returns true if filled
+  void ProcessOrderPlan();
+  bool WaitPendingOrder(types::OrderResult *result);
+
+  // With inline_event_loop set there is no processing thread. The pending order
+  // is polled when the loop is idle and once more at its expiration, which the
+  // loop runs before any later market event, so orders are placed, filled and
+  // expired in the order of recorded market events.
+  void StartOrderPlanInline();
+  void WaitPendingOrderInline();
+  void PollPendingOrderInline(uint64_t order_number);
+  // Cancels the pending limit order once it expires, result is set unless kPending
+  PendingOrderStatus PollPendingOrder(types::OrderResult *result);
 
   types::OrderPlanInfo current_order_info_;
   std::shared_ptr<OrderManager> order_manager_;
@@ -64,6 +96,17 @@ class OrderPlanManager {
   std::condition_variable cv_;
   std::thread order_plans_processing_thread_;
   std::atomic<bool> is_stopped_{false};
+
+  std::shared_ptr<events::InlineEventLoop> inline_event_loop_;
+  OrderPlanStage stage_{OrderPlanStage::kNotStarted};
+  utils::Timestamp order_plan_start_time_{0};
+  utils::ElapsedTimeMeter order_plan_elapsed_time_meter_;
+  // Tells the inline polls of an order done before from the current one
+  uint64_t pending_order_number_{0};
+  types::OrderInfo::Type pending_order_type_{types::OrderInfo::Type::LIMIT};
+  utils::Timestamp pending_order_expiration_ts_{0};
+  types::OrderResponse<std::future> pending_order_response_;
+  market_stream::types::DoubleType buy_price_;
 };
 
 }  // namespace analyzer
@@ -38,6 +38,7 @@ class RealMarketEmulator {
   struct Order {
     uint64_t id;
     types::OrderInfo info;
+    market_stream::types::FixedPoint price;  // info.price converted once on placement
     types::OrderResponse<std::promise> responce;
   };
   void OnOrderBookStreamEvent(MQ::Event event, const void *data);
@@ -48,8 +49,8 @@ class RealMarketEmulator {
   void OnOrderBookStreamEvent_locked(MQ::Event event, const void *data);
 
   std::vector<uint64_t> ProcessMarketTypeOrders();
-  std::vector<uint64_t> CheckAndUpdateOrders(market_stream::types::DoubleType max_buy,
-                                             market_stream::types::DoubleType min_sell);
+  std::vector<uint64_t> CheckAndUpdateOrders(market_stream::types::FixedPoint max_buy,
+                                             market_stream::types::FixedPoint min_sell);
   void RemoveFinishedOrders(const std::vector<uint64_t> &ids);
   std::vector<Order>::iterator FindOrderById(uint64_t order_id);
   bool CancelOrderById(uint64_t order_id);
@@ -57,8 +58,8 @@ class RealMarketEmulator {
   std::vector<Order> orders_;
 
   mutable std::mutex mutex_;
-  market_stream::types::DoubleType last_max_buy_;
-  market_stream::types::DoubleType last_min_sell_;
+  market_stream::types::FixedPoint last_max_buy_;
+  market_stream::types::FixedPoint last_min_sell_;
   std::shared_ptr<RealMarketEmulatorUnitState> unit_state_;
 };
 
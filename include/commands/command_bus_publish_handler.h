@@ -0,0 +1,45 @@
+/**
+ * @file command_bus_publish_handler.h
+ * @brief Declaration of the CommandBusPublishHandler interface.
+ */
+#ifndef INCLUDE_COMMAND_BUS_PUBLISH_HANDLER_H_
+#define INCLUDE_COMMAND_BUS_PUBLISH_HANDLER_H_
+
+#include <chrono>
+#include <string>
+
+#include "command_handler.h"
+
+namespace commands {
+
+/**
+ * @class CommandBusPublishHandler
+ * @brief Command handler for bus publish command: runs the market stream and the
+ * order book of a symbol once and publishes them to the local processes.
+ */
+class CommandBusPublishHandler : public CommandHandler {
+ public:
+  CommandBusPublishHandler() = delete;
+  CommandBusPublishHandler(const CommandBusPublishHandler &) = delete;
+  CommandBusPublishHandler(CommandBusPublishHandler &&) = delete;
+  CommandBusPublishHandler &operator=(const CommandBusPublishHandler &) = delete;
+  CommandBusPublishHandler &operator=(CommandBusPublishHandler &&) = delete;
+
+  CommandBusPublishHandler(int argc, const char *argv[]);
+  ~CommandBusPublishHandler() = default;
+
+  virtual void Run();
+
+  // Bus name used when none is given
+  static std::string DefaultBusName(const std::string &symbol);
+
+ private:
+  std::string symbol_;
+  std::string bus_name_;
+  std::string state_dir_;
+  std::chrono::seconds duration_;
+};
+
+}  // namespace commands
+
+#endif  // INCLUDE_COMMAND_BUS_PUBLISH_HANDLER_H_
@@ -0,0 +1,40 @@
+/**
+ * @file command_orderbook_bench_handler.h
+ * @brief Declaration of the CommandOrderBookBenchHandler interface.
+ */
+#ifndef INCLUDE_COMMAND_ORDERBOOK_BENCH_HANDLER_H_
+#define INCLUDE_COMMAND_ORDERBOOK_BENCH_HANDLER_H_
+
+#include <string>
+
+#include "command_handler.h"
+
+namespace commands {
+
+/**
+ * @class CommandOrderBookBenchHandler
+ * @brief Command handler for order book bench command: replays order book diffs
+ * of a recorded stream through the in-place engine and the previous merge and
+ * prints the time per diff of both.
+ */
+class CommandOrderBookBenchHandler : public CommandHandler {
+ public:
+  CommandOrderBookBenchHandler() = delete;
+  CommandOrderBookBenchHandler(const CommandOrderBookBenchHandler &) = delete;
+  CommandOrderBookBenchHandler(CommandOrderBookBenchHandler &&) = delete;
+  CommandOrderBookBenchHandler &operator=(const CommandOrderBookBenchHandler &) = delete;
+  CommandOrderBookBenchHandler &operator=(CommandOrderBookBenchHandler &&) = delete;
+
+  CommandOrderBookBenchHandler(int argc, const char *argv[]);
+  ~CommandOrderBookBenchHandler() = default;
+
+  virtual void Run();
+
+ private:
+  std::string saved_stream_dir_;
+  int rounds_;
+};
+
+}  // namespace commands
+
+#endif  // INCLUDE_COMMAND_ORDERBOOK_BENCH_HANDLER_H_
@@ -38,6 +38,8 @@ class CommandStrategyTestHandler : public CommandHandler {
   std::string saved_stream_path_;
   std::string output_json_dir_;
   bool disable_ts_jump_;
+  bool inline_events_;
+  std::string trace_dir_;  // empty if flight recorder is disabled
   bool output_json_;
   StrategyType strategy_;
 
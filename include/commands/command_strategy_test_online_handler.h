@@ -12,6 +12,7 @@
 #include "analyzer/observable_units.h"
 #include "command_handler.h"
 #include "commands/types.h"
+#include "events/event_hub.h"
 
 namespace commands {
 
@@ -41,6 +42,11 @@ class CommandStrategyTestOnlineHandler : public CommandHandler {
   std::string output_dir_;
   StrategyType strategy_;
   std::chrono::seconds duration_;
+  events::WaitStrategy wait_strategy_;
+  int analyzer_cpu_;
+  int snapshot_provider_cpu_;
+  std::string bus_name_;  // empty if the market stream is received directly
+  std::string trace_dir_;  // empty if flight recorder is disabled
 
   std::shared_ptr<analyzer::AnalyzerUnitState> analyzer_state_;
   std::shared_ptr<analyzer::OrderPlanManagerUnitState> order_plan_manager_state_;
@@ -34,6 +34,7 @@ class CommandStreamSaveHandler : public CommandHandler {
   bool print_stream_;
   std::string symbol_;
   std::string save_path_;
+  std::string state_dir_;
   std::chrono::seconds timer_;
 };
 
@@ -0,0 +1,39 @@
+/**
+ * @file command_trace_dump_handler.h
+ * @brief Declaration of the CommandTraceDumpHandler interface.
+ */
+#ifndef INCLUDE_COMMAND_TRACE_DUMP_HANDLER_H_
+#define INCLUDE_COMMAND_TRACE_DUMP_HANDLER_H_
+
+#include <string>
+
+#include "command_handler.h"
+
+namespace commands {
+
+/**
+ * @class CommandTraceDumpHandler
+ * @brief Command handler for trace dump command: prints event hub flight
+ * recorder file.
+ */
+class CommandTraceDumpHandler : public CommandHandler {
+ public:
+  CommandTraceDumpHandler() = delete;
+  CommandTraceDumpHandler(const CommandTraceDumpHandler &) = delete;
+  CommandTraceDumpHandler(CommandTraceDumpHandler &&) = delete;
+  CommandTraceDumpHandler &operator=(const CommandTraceDumpHandler &) = delete;
+  CommandTraceDumpHandler &operator=(CommandTraceDumpHandler &&) = delete;
+
+  CommandTraceDumpHandler(int argc, const char *argv[]);
+  ~CommandTraceDumpHandler() = default;
+
+  virtual void Run();
+
+ private:
+  std::string trace_file_;
+  int last_seconds_;  // 0 to print all records
+};
+
+}  // namespace commands
+
+#endif  // INCLUDE_COMMAND_TRACE_DUMP_HANDLER_H_
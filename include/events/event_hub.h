@@ -4,15 +4,27 @@
 #include <spdlog/spdlog.h>
 
 #include <atomic>
+#include <bitset>
 #include <condition_variable>
 #include <functional>
+#include <initializer_list>
 #include <memory>
 #include <queue>
+#include <sstream>
+#include <string>
 #include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "analyzer/observable_units.h"
 #include "events.h"
+#include "flight_recorder.h"
+#include "inline_event_loop.h"
+#include "metrics.h"
+#include "ring_buffer.h"
+#include "work_stealing_pool.h"
 
 #define SUBSCRIBE_TO_EVENT(event_handler_ptr, method_ptr)                             \
   do {                                                                                \
@@ -23,11 +35,176 @@
     }                                                                                 \
   } while (0)
 
+// Subscribes method_ptr only to the listed events, e.g.
+// SUBSCRIBE_TO_EVENTS(handler, &Foo::OnEvent, MQ::Event::kNewTradeEvent)
+#define SUBSCRIBE_TO_EVENTS(event_handler_ptr, method_ptr, ...)                       \
+  do {                                                                                \
+    auto event_handler_locked = event_handler_ptr.lock();                             \
+    if (event_handler_locked) {                                                       \
+      event_handler_locked->Subscribe(                                                \
+          std::bind(method_ptr, this, std::placeholders::_1, std::placeholders::_2),  \
+          {__VA_ARGS__});                                                             \
+    }                                                                                 \
+  } while (0)
+
+// Like SUBSCRIBE_TO_EVENTS, but only the latest not processed event of each
+// type is delivered
+#define SUBSCRIBE_TO_LATEST_EVENTS(event_handler_ptr, method_ptr, ...)                \
+  do {                                                                                \
+    auto event_handler_locked = event_handler_ptr.lock();                             \
+    if (event_handler_locked) {                                                       \
+      event_handler_locked->Subscribe(                                                \
+          std::bind(method_ptr, this, std::placeholders::_1, std::placeholders::_2),  \
+          {__VA_ARGS__}, events::DeliveryPolicy::kKeepLatest);                        \
+    }                                                                                 \
+  } while (0)
+
+// Subscribes the calling object by its typed OnEvent overloads, see
+// EventHub::Handler::SubscribeTyped
+#define SUBSCRIBE_TO_TYPED_EVENTS(event_handler_ptr)      \
+  do {                                                    \
+    auto event_handler_locked = event_handler_ptr.lock(); \
+    if (event_handler_locked) {                           \
+      event_handler_locked->SubscribeTyped(this);         \
+    }                                                     \
+  } while (0)
+
 namespace events {
 
 class TransportUnitStateImpl;
 extern std::unique_ptr<TransportUnitStateImpl> g_transport_unit_state_impl;
 
+enum class QueueType {
+  kBlocking = 0,   // mutex + condition variable protected queue of closures
+  kLockFreeRing,   // preallocated MPSC ring of typed event slots
+  kInline,         // no worker thread, events are posted to a shared InlineEventLoop
+  kThreadPool,     // no worker thread, queue is a serial strand on a WorkStealingPool
+};
+
+enum class DispatchMode {
+  kCopyPerSubscriber = 0,  // every subscriber queue gets own copy of the event
+  kSharedPayload,          // event copied once, subscribers share a const view
+};
+
+enum class DeliveryPolicy {
+  kQueueAll = 0,  // every event is delivered
+  kKeepLatest,    // one slot per event type, a not processed event is overwritten
+  kDropOldest,    // at most max_queued_events are kept, the oldest are dropped
+};
+
+enum class WaitStrategy {
+  kDefault = 0,    // kSpinThenPark for kLockFreeRing, kBlocking otherwise
+  kBlocking,       // park on the condition variable right away
+  kBusySpin,       // poll the queue, never give up the CPU
+  kSpinThenYield,  // poll the queue, then keep polling with yields in between
+  kSpinThenPark,   // poll the queue, then park on the condition variable
+};
+
+struct WorkerOptions {
+  WaitStrategy wait_strategy{WaitStrategy::kDefault};
+  int cpu{-1};              // CPU to pin the worker thread to, -1 to not pin
+  std::string thread_name;  // cut to 15 characters on Linux, empty to keep default
+};
+
+const std::size_t kDefaultRingCapacity = 1024;
+
+struct EventHubOptions {
+  QueueType queue_type{QueueType::kBlocking};
+  std::size_t ring_capacity{kDefaultRingCapacity};  // power of 2, kLockFreeRing only
+  DispatchMode dispatch_mode{DispatchMode::kCopyPerSubscriber};
+  std::shared_ptr<InlineEventLoop> inline_event_loop;  // kInline only
+  std::shared_ptr<WorkStealingPool> thread_pool;       // kThreadPool only
+  // Default for all handlers, used by kBlocking and kLockFreeRing only
+  WorkerOptions worker_options;
+  // Queue depth, wait and handle time per subscriber, see EventHub::GetMetrics
+  bool enable_metrics{false};
+  // Directory of the flight recorder file, see MakeFlightRecorderPath, with
+  // the last flight_recorder_capacity dispatch and dequeue records, empty to disable
+  std::string flight_recorder_dir;
+  std::size_t flight_recorder_capacity{kDefaultFlightRecorderCapacity};
+};
+
+// Applies WorkerOptions to the calling thread
+void SetupWorkerThread(const WorkerOptions &worker_options);
+
+// Number of events queued or being processed by the queues of one hub. The
+// counter is a plain atomic, the mutex is taken only when the hub becomes busy
+// or drained to update the transport unit state and wake up the waiters.
+class InFlightEvents {
+ public:
+  InFlightEvents(const InFlightEvents &) = delete;
+  InFlightEvents(InFlightEvents &&) = delete;
+  InFlightEvents &operator=(const InFlightEvents &) = delete;
+  InFlightEvents &operator=(InFlightEvents &&) = delete;
+
+  InFlightEvents();
+  ~InFlightEvents();
+
+  void Add() {
+    if (0 == count_.fetch_add(1, std::memory_order_acq_rel)) {
+      OnBusyChanged();
+    }
+  }
+
+  void Remove() {
+    if (1 == count_.fetch_sub(1, std::memory_order_acq_rel)) {
+      OnBusyChanged();
+    }
+  }
+
+  void WaitUntilDrained();
+
+  int count() const { return count_.load(std::memory_order_acquire); }
+
+ private:
+  void OnBusyChanged();
+
+  std::atomic<int> count_{0};
+  bool is_busy_{false};
+  std::mutex mutex_;
+  std::condition_variable drained_cv_;
+};
+
+// Tag parameter of a typed handler, needed only to tell apart events with the
+// same payload type, e.g. OnEvent(EventTag<MQ::Event::kNewTradeEvent>, const Trade &)
+template <auto event>
+using EventTag = std::integral_constant<decltype(event), event>;
+
+template <class MessageQueue>
+class EventHub;
+
+// Calls typed handlers of subscribers, a subscriber with private OnEvent
+// overloads declares it as a friend
+class TypedEventHandlerAccess {
+  template <class MessageQueue>
+  friend class EventHub;
+
+  // Tagged overload is preferred to the plain one
+  template <auto event, class Subscriber, class T>
+  static auto Call(Subscriber &subscriber, const T &data, int)
+      -> decltype(subscriber.OnEvent(EventTag<event>(), data)) {
+    return subscriber.OnEvent(EventTag<event>(), data);
+  }
+
+  template <auto event, class Subscriber, class T>
+  static auto Call(Subscriber &subscriber, const T &data, long)
+      -> decltype(subscriber.OnEvent(data)) {
+    return subscriber.OnEvent(data);
+  }
+
+  template <auto event, class Subscriber, class T>
+  static constexpr auto IsHandled(int)
+      -> decltype(Call<event>(std::declval<Subscriber &>(), std::declval<const T &>(), 0),
+                  bool()) {
+    return true;
+  }
+
+  template <auto event, class Subscriber, class T>
+  static constexpr bool IsHandled(long) {
+    return false;
+  }
+};
+
 template <class MessageQueue>
 class EventHub {
   using Event = typename MessageQueue::Event;
@@ -36,6 +213,7 @@ class EventHub {
   using EventType = typename MessageQueue::template EventTypeFromId<e>::type;
 
   using EventsHandleCallback = std::function<void(Event event, const void *data)>;
+  using EventsMask = std::bitset<static_cast<std::size_t>(Event::COUNT)>;
 
  public:
   EventHub(const EventHub &) = delete;
@@ -43,21 +221,140 @@ class EventHub {
   EventHub &operator=(const EventHub &) = delete;
   EventHub &operator=(EventHub &&) = delete;
 
-  EventHub() = default;
+  explicit EventHub(const EventHubOptions &options = EventHubOptions())
+      : options_(options),
+        flight_recorder_(options_.flight_recorder_dir.empty()
+                             ? nullptr
+                             : std::make_unique<FlightRecorder>(
+                                   MakeFlightRecorderPath(options_.flight_recorder_dir,
+                                                          MessageQueue::kClassName),
+                                   MessageQueue::kClassName,
+                                   options_.flight_recorder_capacity)) {
+    if (QueueType::kInline == options_.queue_type &&
+        nullptr == options_.inline_event_loop) {
+      spdlog::error("InlineEventLoop is required for QueueType::kInline");
+      exit(-1);
+    }
+    if (QueueType::kThreadPool == options_.queue_type &&
+        nullptr == options_.thread_pool) {
+      spdlog::error("WorkStealingPool is required for QueueType::kThreadPool");
+      exit(-1);
+    }
+    const std::size_t ring_capacity = options_.ring_capacity;
+    if (QueueType::kLockFreeRing == options_.queue_type &&
+        (ring_capacity < 2 || 0 != (ring_capacity & (ring_capacity - 1)))) {
+      spdlog::error("ring_capacity must be a power of 2 not less than 2, got {}",
+                    ring_capacity);
+      exit(-1);
+    }
+  }
   ~EventHub() { Shutdown(); }
 
   class Handler {
    public:
-    Handler(EventHub &event_hub) : event_hub_(event_hub) {}
+    Handler(EventHub &event_hub)
+        : event_hub_(event_hub), worker_options_(event_hub.options_.worker_options) {}
+    Handler(EventHub &event_hub, const WorkerOptions &worker_options)
+        : event_hub_(event_hub), worker_options_(worker_options) {}
 
+    // Subscribes to all events of MessageQueue
     void Subscribe(const EventsHandleCallback &cb) {
+      AddMessageQueue(cb, EventsMask().set());
+    }
+
+    // Queue receives only listed events, others are not even enqueued.
+    // max_queued_events is used by DeliveryPolicy::kDropOldest only.
+    void Subscribe(const EventsHandleCallback &cb, std::initializer_list<Event> events,
+                   DeliveryPolicy delivery_policy = DeliveryPolicy::kQueueAll,
+                   std::size_t max_queued_events = 1) {
+      EventsMask events_mask;
+      for (auto event : events) {
+        events_mask.set(static_cast<std::size_t>(event));
+      }
+      AddMessageQueue(cb, events_mask, delivery_policy, max_queued_events);
+    }
+
+    // Subscriber gets events by OnEvent overloads over the payload types,
+    // OnEvent(const EventType &) or OnEvent(EventTag<event>, const EventType &).
+    // Handlers are resolved at compile time: a subscriber without a handler for
+    // any event is a compile error, events without a handler are not enqueued.
+    // Queue still calls through one EventsHandleCallback, which jumps straight
+    // to the handler of the event, so the handler can be inlined there.
+    template <class Subscriber>
+    void SubscribeTyped(Subscriber *subscriber,
+                        DeliveryPolicy delivery_policy = DeliveryPolicy::kQueueAll,
+                        std::size_t max_queued_events = 1) {
+      using EventIds = std::make_index_sequence<static_cast<std::size_t>(Event::COUNT)>;
+      static_assert(IsAnyEventHandled<Subscriber>(EventIds()),
+                    "Subscriber has no OnEvent overload for events of MessageQueue");
+
+      AddMessageQueue(
+          [subscriber](Event event, const void *data) {
+            CallTypedHandler(subscriber, event, data, EventIds());
+          },
+          TypedEventsMask<Subscriber>(EventIds()), delivery_policy, max_queued_events);
+    }
+
+   private:
+    template <Event e, class Subscriber>
+    static constexpr bool IsEventHandled() {
+      return TypedEventHandlerAccess::IsHandled<e, Subscriber, EventType<e>>(0);
+    }
+
+    template <class Subscriber, std::size_t... ids>
+    static constexpr bool IsAnyEventHandled(std::index_sequence<ids...>) {
+      return (IsEventHandled<static_cast<Event>(ids), Subscriber>() || ...);
+    }
+
+    template <class Subscriber, std::size_t... ids>
+    static EventsMask TypedEventsMask(std::index_sequence<ids...>) {
+      EventsMask events_mask;
+      (events_mask.set(ids, IsEventHandled<static_cast<Event>(ids), Subscriber>()), ...);
+      return events_mask;
+    }
+
+    template <class Subscriber, std::size_t... ids>
+    static void CallTypedHandler(Subscriber *subscriber, Event event, const void *data,
+                                 std::index_sequence<ids...>) {
+      ((static_cast<Event>(ids) == event
+            ? CallTypedHandler<static_cast<Event>(ids)>(subscriber, data)
+            : void()),
+       ...);
+    }
+
+    template <Event e, class Subscriber>
+    static void CallTypedHandler(Subscriber *subscriber, const void *data) {
+      if constexpr (IsEventHandled<e, Subscriber>()) {
+        TypedEventHandlerAccess::Call<e>(
+            *subscriber, *static_cast<const EventType<e> *>(data), 0);
+      }
+    }
+
+    void AddMessageQueue(const EventsHandleCallback &cb, const EventsMask &events_mask,
+                         DeliveryPolicy delivery_policy = DeliveryPolicy::kQueueAll,
+                         std::size_t max_queued_events = 1) {
       spdlog::debug("Create new MessageQueueThread for MQ: {}", MessageQueue::kClassName);
-      auto message_queue = std::make_shared<MessageQueueThread>(cb);
+      std::unique_ptr<QueueMetrics> metrics;
+      if (event_hub_.options_.enable_metrics) {
+        auto subscriber = "#" + std::to_string(event_hub_.message_queues_.size());
+        if (!worker_options_.thread_name.empty()) {
+          subscriber += " " + worker_options_.thread_name;
+        }
+        metrics = std::make_unique<QueueMetrics>(MessageQueue::kClassName, subscriber,
+                                                 static_cast<std::size_t>(Event::COUNT));
+      }
+      auto message_queue = std::make_shared<MessageQueueThread>(
+          cb, events_mask, delivery_policy, max_queued_events,
+          event_hub_.options_.queue_type, event_hub_.options_.ring_capacity,
+          event_hub_.options_.inline_event_loop, event_hub_.options_.thread_pool,
+          worker_options_, event_hub_.in_flight_events_, std::move(metrics),
+          event_hub_.flight_recorder_.get(),
+          static_cast<uint32_t>(event_hub_.message_queues_.size()));
       event_hub_.message_queues_.push_back(message_queue);
     }
 
-   private:
     EventHub &event_hub_;
+    const WorkerOptions worker_options_;
   };
 
   class Dispatcher {
@@ -66,14 +363,53 @@ class EventHub {
 
     template <Event e>
     void DispatchEvent(const EventType<e> &event_data) {
+      if (DispatchMode::kSharedPayload == event_hub_.options_.dispatch_mode) {
+        DispatchSharedEvent<e>(std::make_shared<const EventType<e>>(event_data));
+        return;
+      }
       if (!event_hub_.event_hub_stopped_) {
+        const uint64_t sequence = RecordDispatch(e, &event_data);
         for (auto &it : event_hub_.message_queues_) {
-          it->template PushEvent<e>(event_data);
+          if (it->IsSubscribedTo(e)) {
+            it->template PushEvent<e>(event_data, sequence);
+          }
         }
       }
     }
 
+    // Payload is not copied, all subscribers get a pointer to the same object
+    template <Event e>
+    void DispatchSharedEvent(const std::shared_ptr<const EventType<e>> &event_data) {
+      if (!event_hub_.event_hub_stopped_) {
+        const uint64_t sequence = RecordDispatch(e, event_data.get());
+        for (auto &it : event_hub_.message_queues_) {
+          if (it->IsSubscribedTo(e)) {
+            it->template PushSharedEvent<e>(event_data, sequence);
+          }
+        }
+      }
+    }
+
+    // True if any subscription of the hub gets event e
+    bool HasSubscribers(Event e) const {
+      for (const auto &it : event_hub_.message_queues_) {
+        if (it->IsSubscribedTo(e)) {
+          return true;
+        }
+      }
+      return false;
+    }
+
    private:
+    // Returns 0 if the flight recorder is disabled
+    uint64_t RecordDispatch(Event event, const void *payload) {
+      if (nullptr == event_hub_.flight_recorder_) {
+        return 0;
+      }
+      return event_hub_.flight_recorder_->RecordDispatch(static_cast<uint16_t>(event),
+                                                         payload);
+    }
+
     EventHub &event_hub_;
   };
 
@@ -89,55 +425,195 @@ class EventHub {
     return handlers_.back();
   }
 
+  // Worker threads of this handler subscriptions use worker_options instead of
+  // the hub ones
+  std::weak_ptr<Handler> CreateHandler(const WorkerOptions &worker_options) {
+    handlers_.emplace_back(std::make_shared<Handler>(*this, worker_options));
+    return handlers_.back();
+  }
+
   void Shutdown() {
     spdlog::info("Stopping MessageQueueThreads...");
-    event_hub_stopped_ = true;
+    const bool was_stopped = event_hub_stopped_.exchange(true);
     for (auto &it : message_queues_) {
       it->Stop();
     }
     spdlog::info("Stopping MessageQueueThreads finished");
+
+    if (!was_stopped) {
+      for (const auto &it : GetMetrics()) {
+        std::stringstream ss;
+        ss << it;
+        spdlog::info("Queue metrics {}", ss.str());
+      }
+    }
   }
 
-  void WaitForAllEventsProcessed() {
-    bool is_all_events_processed = true;
-    do {
-      is_all_events_processed = true;
-      for (const auto &it : message_queues_) {
-        if (it->IsWorking()) {
-          is_all_events_processed = false;
-          break;
-        }
+  // One entry per subscription, empty unless EventHubOptions::enable_metrics
+  std::vector<QueueMetricsSnapshot> GetMetrics() const {
+    std::vector<QueueMetricsSnapshot> result;
+    for (const auto &it : message_queues_) {
+      if (nullptr != it->metrics()) {
+        result.push_back(it->metrics()->snapshot());
       }
-      std::this_thread::sleep_for(std::chrono::milliseconds(500));
-    } while (!is_all_events_processed);
+    }
+    return result;
   }
 
+  // Returns as soon as the last queued event of the hub is processed
+  void WaitForAllEventsProcessed() { in_flight_events_.WaitUntilDrained(); }
+
  private:
+  // Holds one payload per event type, so the slot can be reused for any event
+  // without reallocating its containers
+  template <class Sequence>
+  struct EventSlotPayloads;
+
+  template <std::size_t... ids>
+  struct EventSlotPayloads<std::index_sequence<ids...>> {
+    using type = std::tuple<EventType<static_cast<Event>(ids)>...>;
+  };
+
+  // Travels with a queued event to the subscriber queue consumer
+  struct EventStamp {
+    uint64_t sequence{0};                    // set only if flight recorder is enabled
+    MetricsClock::time_point enqueue_time;  // set only if metrics are enabled
+  };
+
+  struct EventSlot {
+    Event event;
+    bool is_conflated{false};  // payload is in the conflated slot of the event
+    const void *data{nullptr};
+    std::shared_ptr<const void> shared_data;
+    EventStamp stamp;
+    typename EventSlotPayloads<std::make_index_sequence<static_cast<std::size_t>(
+        Event::COUNT)>>::type payloads;
+  };
+
+  // Producers overwrite latest in place, the consumer swaps it with processing,
+  // so both keep their containers capacity
+  template <class T>
+  struct ConflatedSlot {
+    bool is_pending{false};
+    T latest;
+    std::shared_ptr<const T> latest_shared;  // used instead of latest for shared payloads
+    EventStamp latest_stamp;
+    T processing;
+  };
+
+  template <class Sequence>
+  struct ConflatedSlots;
+
+  template <std::size_t... ids>
+  struct ConflatedSlots<std::index_sequence<ids...>> {
+    using type = std::tuple<ConflatedSlot<EventType<static_cast<Event>(ids)>>...>;
+  };
+
   class MessageQueueThread {
    public:
-    MessageQueueThread(const EventsHandleCallback &cb)
-        : cb_(cb), thread_(std::bind(&MessageQueueThread::ThreadLoop, this)) {
+    MessageQueueThread(const EventsHandleCallback &cb, const EventsMask &events_mask,
+                       DeliveryPolicy delivery_policy, std::size_t max_queued_events,
+                       QueueType queue_type, std::size_t ring_capacity,
+                       const std::shared_ptr<InlineEventLoop> &inline_event_loop,
+                       const std::shared_ptr<WorkStealingPool> &thread_pool,
+                       const WorkerOptions &worker_options,
+                       InFlightEvents &in_flight_events,
+                       std::unique_ptr<QueueMetrics> metrics,
+                       FlightRecorder *flight_recorder, uint32_t queue_index)
+        : cb_(cb),
+          in_flight_events_(in_flight_events),
+          metrics_(std::move(metrics)),
+          flight_recorder_(flight_recorder),
+          queue_index_(queue_index),
+          events_mask_(events_mask),
+          delivery_policy_(delivery_policy),
+          max_queued_events_(max_queued_events),
+          conflated_slots_(DeliveryPolicy::kKeepLatest == delivery_policy
+                               ? std::make_unique<ConflatedSlotsType>()
+                               : nullptr),
+          ring_(QueueType::kLockFreeRing == queue_type
+                    ? std::make_unique<RingBuffer<EventSlot>>(ring_capacity)
+                    : nullptr),
+          inline_event_loop_(QueueType::kInline == queue_type ? inline_event_loop
+                                                               : nullptr),
+          thread_pool_(QueueType::kThreadPool == queue_type ? thread_pool : nullptr),
+          worker_options_(worker_options),
+          wait_strategy_(WaitStrategy::kDefault != worker_options.wait_strategy
+                             ? worker_options.wait_strategy
+                         : nullptr != ring_ ? WaitStrategy::kSpinThenPark
+                                            : WaitStrategy::kBlocking),
+          thread_(nullptr == inline_event_loop_ && nullptr == thread_pool_
+                      ? std::thread(std::bind(&MessageQueueThread::ThreadLoop, this))
+                      : std::thread()) {
       spdlog::debug("MessageQueueThread initialized");
     }
 
-    template <Event e>
-    void PushEvent(const EventType<e> &event_data) {
-      std::lock_guard<std::mutex> lock(mutex_);
+    bool IsSubscribedTo(Event event) const {
+      return events_mask_.test(static_cast<std::size_t>(event));
+    }
+
+    const QueueMetrics *metrics() const { return metrics_.get(); }
 
-      if (g_transport_unit_state_impl) {
-        g_transport_unit_state_impl->AddOneEvent();
+    template <Event e>
+    void PushEvent(const EventType<e> &event_data, uint64_t sequence) {
+      if (nullptr != conflated_slots_) {
+        PushConflatedEvent<e>(sequence, [&event_data](ConflatedSlot<EventType<e>> &slot) {
+          slot.latest = event_data;
+          slot.latest_shared.reset();
+        });
+        return;
+      }
+      if (nullptr != ring_) {
+        PushEventToRing<e>(event_data, Stamp(sequence));
+        return;
       }
 
-      events_queue_.push([this, event_data]() {
+      PushToEventsQueue([this, event_data, stamp = Stamp(sequence)]() {
         auto *event_data_ptr = &event_data;
-        cb_(e, static_cast<const void *>(event_data_ptr));
+        Invoke(e, static_cast<const void *>(event_data_ptr), stamp);
+      });
+    }
+
+    template <Event e>
+    void PushSharedEvent(const std::shared_ptr<const EventType<e>> &event_data,
+                         uint64_t sequence) {
+      if (nullptr != conflated_slots_) {
+        PushConflatedEvent<e>(sequence, [&event_data](ConflatedSlot<EventType<e>> &slot) {
+          slot.latest_shared = event_data;
+        });
+        return;
+      }
+      if (nullptr != ring_) {
+        PushToRing(Stamp(sequence), [&event_data](EventSlot &slot) {
+          slot.event = e;
+          slot.is_conflated = false;
+          slot.data = static_cast<const void *>(event_data.get());
+          slot.shared_data = event_data;
+        });
+        return;
+      }
+
+      PushToEventsQueue([this, event_data, stamp = Stamp(sequence)]() {
+        Invoke(e, static_cast<const void *>(event_data.get()), stamp);
       });
-      cv_.notify_one();
     }
 
     void Stop() {
       spdlog::debug("Stopping MessageQueueThread for MQ: {}", MessageQueue::kClassName);
-      is_stopped_ = true;
+      if (nullptr != inline_event_loop_) {
+        // Posted callbacks refer to this queue, so they must be done before it is gone
+        inline_event_loop_->RunUntilIdle();
+      }
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        is_stopped_ = true;
+        // Scheduled strand refers to this queue, so it must be done before it is
+        // gone. Unless a handler of the strand stops it: the strand goes on after
+        // the handler returns.
+        if (this != gRunningStrand) {
+          cv_.wait(lock, [this] { return !is_strand_scheduled_; });
+        }
+      }
       cv_.notify_one();
       if (thread_.joinable()) {
         thread_.join();
@@ -145,48 +621,360 @@ class EventHub {
       spdlog::debug("MessageQueueThread finished");
     }
 
-    bool IsWorking() const {
-      std::lock_guard<std::mutex> lock(mutex_);
-      return !events_queue_.empty() || is_processing_event_;
-    }
-
    private:
     using EventFunc = std::function<void()>;
+    using ConflatedSlotsType = typename ConflatedSlots<
+        std::make_index_sequence<static_cast<std::size_t>(Event::COUNT)>>::type;
 
-    void ThreadLoop() {
+    static const int kSpinCount = 128;
+    static const int kStrandBatchSize = 32;
+
+    // Queue whose strand runs on this thread
+    static inline thread_local const MessageQueueThread *gRunningStrand = nullptr;
+
+    void PushToEventsQueue(EventFunc &&event_func) {
+      if (nullptr != inline_event_loop_) {
+        PostToInlineEventLoop(std::move(event_func));
+        return;
+      }
+
+      std::unique_lock<std::mutex> lock(mutex_);
+
+      OnEventQueued();
+
+      if (DeliveryPolicy::kDropOldest == delivery_policy_) {
+        while (!events_queue_.empty() && events_queue_.size() >= max_queued_events_) {
+          events_queue_.pop();
+          queued_events_--;
+          OnEventDone();
+        }
+      }
+
+      events_queue_.push(std::move(event_func));
+      queued_events_++;
+      if (nullptr == thread_pool_) {
+        cv_.notify_one();
+      } else if (!is_strand_scheduled_) {
+        is_strand_scheduled_ = true;
+        if (!thread_pool_->Submit([this]() { RunStrand(); })) {
+          // Pool is shut down, the strand is drained by the dispatching thread
+          lock.unlock();
+          RunStrand();
+        }
+      }
+    }
+
+    // At most one RunStrand of a queue is submitted to the pool at a time, so
+    // the queue events are processed one by one in FIFO order. After a batch
+    // the strand is resubmitted to let other queues run, or goes on in place if
+    // the pool is shut down.
+    void RunStrand() {
+      const auto *previous_strand = gRunningStrand;
+      gRunningStrand = this;
       while (true) {
-        std::unique_lock<std::mutex> lock(mutex_);
-        is_processing_event_ = false;
-        cv_.wait(lock, [this] { return !events_queue_.empty() || is_stopped_; });
+        for (int i = 0; i < kStrandBatchSize; i++) {
+          if (!TryProcessEvent()) {
+            break;
+          }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (events_queue_.empty()) {
+          is_strand_scheduled_ = false;
+          cv_.notify_all();
+          break;
+        }
+        if (thread_pool_->Submit([this]() { RunStrand(); })) {
+          break;
+        }
+      }
+      gRunningStrand = previous_strand;
+    }
+
+    // Ring and inline queues are drained by the consumer only, so the events
+    // over the limit are skipped there instead of being removed on push
+    bool IsDroppedAsOldest(int pending_events) const {
+      return DeliveryPolicy::kDropOldest == delivery_policy_ &&
+             static_cast<std::size_t>(pending_events) > max_queued_events_;
+    }
+
+    // The event is put into its conflated slot, the queue gets a token only if
+    // the slot was not pending already
+    template <Event e, class Fill>
+    void PushConflatedEvent(uint64_t sequence, const Fill &fill) {
+      auto &slot = std::get<static_cast<std::size_t>(e)>(*conflated_slots_);
+      {
+        std::lock_guard<std::mutex> lock(conflated_mutex_);
+        fill(slot);
+        slot.latest_stamp = Stamp(sequence);
+        if (slot.is_pending) {
+          return;
+        }
+        slot.is_pending = true;
+      }
+
+      if (nullptr != ring_) {
+        PushToRing(EventStamp(), [](EventSlot &ring_slot) {
+          ring_slot.event = e;
+          ring_slot.is_conflated = true;
+          ring_slot.data = nullptr;
+        });
+        return;
+      }
+
+      PushToEventsQueue([this]() { ConsumeConflatedEvent<e>(); });
+    }
+
+    template <Event e>
+    void ConsumeConflatedEvent() {
+      auto &slot = std::get<static_cast<std::size_t>(e)>(*conflated_slots_);
+      std::shared_ptr<const EventType<e>> shared_data;
+      EventStamp stamp;
+      {
+        std::lock_guard<std::mutex> lock(conflated_mutex_);
+        slot.is_pending = false;
+        stamp = slot.latest_stamp;
+        if (nullptr != slot.latest_shared) {
+          shared_data = std::move(slot.latest_shared);
+          slot.latest_shared.reset();
+        } else if constexpr (std::is_swappable_v<EventType<e>>) {
+          std::swap(slot.latest, slot.processing);
+        } else {
+          slot.processing = slot.latest;
+        }
+      }
+      Invoke(e,
+             nullptr != shared_data ? static_cast<const void *>(shared_data.get())
+                                    : static_cast<const void *>(&slot.processing),
+             stamp);
+    }
+
+    template <std::size_t... ids>
+    void ConsumeConflatedEvent(Event event, std::index_sequence<ids...>) {
+      ((static_cast<Event>(ids) == event
+            ? ConsumeConflatedEvent<static_cast<Event>(ids)>()
+            : void()),
+       ...);
+    }
+
+    void PostToInlineEventLoop(EventFunc &&event_func) {
+      OnEventQueued();
+      inline_pending_events_++;
+
+      inline_event_loop_->Post([this, event_func = std::move(event_func)]() {
+        if (!IsDroppedAsOldest(inline_pending_events_)) {
+          event_func();
+        }
 
-        if (is_stopped_ && events_queue_.empty()) {
+        inline_pending_events_--;
+        OnEventDone();
+      });
+    }
+
+    void OnEventQueued() {
+      in_flight_events_.Add();
+      if (nullptr != metrics_) {
+        metrics_->OnEventQueued();
+      }
+    }
+
+    void OnEventDone() {
+      if (nullptr != metrics_) {
+        metrics_->OnEventDone();
+      }
+      in_flight_events_.Remove();
+    }
+
+    // Clock is read only if metrics are enabled
+    EventStamp Stamp(uint64_t sequence) const {
+      return {sequence,
+              nullptr != metrics_ ? MetricsClock::now() : MetricsClock::time_point()};
+    }
+
+    void Invoke(Event event, const void *data, const EventStamp &stamp) {
+      if (nullptr != flight_recorder_) {
+        flight_recorder_->RecordDequeue(static_cast<uint16_t>(event), stamp.sequence,
+                                        queue_index_);
+      }
+      if (nullptr == metrics_) {
+        cb_(event, data);
+        return;
+      }
+      const auto start_time = MetricsClock::now();
+      metrics_->RecordWaitTime(static_cast<std::size_t>(event),
+                               start_time - stamp.enqueue_time);
+      cb_(event, data);
+      metrics_->RecordHandleTime(MetricsClock::now() - start_time);
+    }
+
+    void ThreadLoop() {
+      SetupWorkerThread(worker_options_);
+      while (true) {
+        if (TryProcessEvent()) {
+          continue;
+        }
+        if (!WaitForEvents()) {
           return;
         }
+      }
+    }
 
-        is_processing_event_ = true;
+    // Returns false when there is no event to process
+    bool TryProcessEvent() {
+      if (nullptr != ring_) {
+        if (!ring_->TryPop([this](EventSlot &slot) { ProcessRingSlot(slot); })) {
+          return false;
+        }
+        ring_pending_events_--;
+      } else {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (events_queue_.empty()) {
+          return false;
+        }
 
-        auto event = events_queue_.front();
+        auto event = std::move(events_queue_.front());
         events_queue_.pop();
+        queued_events_--;
 
         lock.unlock();
 
         event();
+      }
 
-        if (g_transport_unit_state_impl) {
-          g_transport_unit_state_impl->RemoveOneEvent();
-        }
+      OnEventDone();
+      return true;
+    }
+
+    // Returns false when the queue is stopped and has no events left
+    bool WaitForEvents() {
+      switch (wait_strategy_) {
+        case WaitStrategy::kBusySpin:
+        case WaitStrategy::kSpinThenYield:
+          for (int i = 0; !HasEvents();) {
+            if (is_stopped_) {
+              return HasEvents();
+            }
+            if (i < kSpinCount) {
+              i++;
+            } else if (WaitStrategy::kSpinThenYield == wait_strategy_) {
+              std::this_thread::yield();
+            }
+          }
+          return true;
+
+        case WaitStrategy::kSpinThenPark:
+          for (int i = 0; i < kSpinCount && !is_stopped_; i++) {
+            if (HasEvents()) {
+              return true;
+            }
+          }
+          return Park();
+
+        default:
+          return Park();
+      }
+    }
+
+    bool Park() {
+      std::unique_lock<std::mutex> lock(mutex_);
+      is_consumer_parked_.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      cv_.wait(lock, [this] { return HasEvents_locked() || is_stopped_; });
+      is_consumer_parked_.store(false, std::memory_order_relaxed);
+
+      return HasEvents_locked() || !is_stopped_;
+    }
+
+    // Takes no lock, so spinning consumers do not contend with producers
+    bool HasEvents() const {
+      if (nullptr != ring_) {
+        return !ring_->empty();
+      }
+      return queued_events_.load(std::memory_order_acquire) > 0;
+    }
+
+    bool HasEvents_locked() const {
+      return nullptr != ring_ ? !ring_->empty() : !events_queue_.empty();
+    }
+
+    template <Event e>
+    void PushEventToRing(const EventType<e> &event_data, const EventStamp &stamp) {
+      PushToRing(stamp, [&event_data](EventSlot &slot) {
+        auto &payload = std::get<static_cast<std::size_t>(e)>(slot.payloads);
+        payload = event_data;
+        slot.event = e;
+        slot.is_conflated = false;
+        slot.data = static_cast<const void *>(&payload);
+      });
+    }
+
+    // Push path takes no lock: the slot is reserved with a CAS and filled in
+    // place. The mutex is touched only to wake up a parked consumer.
+    template <class Fill>
+    void PushToRing(const EventStamp &stamp, const Fill &fill) {
+      OnEventQueued();
+      ring_pending_events_++;
+
+      const auto fill_slot = [&fill, &stamp](EventSlot &slot) {
+        fill(slot);
+        slot.stamp = stamp;
+      };
+      while (!ring_->TryPush(fill_slot)) {
+        // Ring is full, let the consumer free a slot
+        std::this_thread::yield();
+      }
+
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (is_consumer_parked_.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cv_.notify_one();
       }
     }
 
+    void ProcessRingSlot(EventSlot &slot) {
+      if (slot.is_conflated) {
+        ConsumeConflatedEvent(
+            slot.event,
+            std::make_index_sequence<static_cast<std::size_t>(Event::COUNT)>());
+      } else if (!IsDroppedAsOldest(ring_pending_events_)) {
+        Invoke(slot.event, slot.data, slot.stamp);
+      }
+      slot.shared_data.reset();
+    }
+
     EventsHandleCallback cb_;
-    std::thread thread_;
+    InFlightEvents &in_flight_events_;
+    const std::unique_ptr<QueueMetrics> metrics_;
+    FlightRecorder *const flight_recorder_;
+    const uint32_t queue_index_;
+    const EventsMask events_mask_;
+    const DeliveryPolicy delivery_policy_;
+    const std::size_t max_queued_events_;
+    std::unique_ptr<ConflatedSlotsType> conflated_slots_;
+    std::mutex conflated_mutex_;
+    std::unique_ptr<RingBuffer<EventSlot>> ring_;
+    std::shared_ptr<InlineEventLoop> inline_event_loop_;
+    std::atomic<int> inline_pending_events_{0};
+    std::shared_ptr<WorkStealingPool> thread_pool_;
+    bool is_strand_scheduled_{false};
+    const WorkerOptions worker_options_;
+    const WaitStrategy wait_strategy_;
+    std::atomic<int> ring_pending_events_{0};
+    std::atomic<bool> is_consumer_parked_{false};
     std::atomic<bool> is_stopped_{false};
-    bool is_processing_event_{false};
     std::condition_variable cv_;
     mutable std::mutex mutex_;
     std::queue<EventFunc> events_queue_;
+    // Size of events_queue_, changed under mutex_ and polled without it
+    std::atomic<int> queued_events_{0};
+    // Must be the last member: the loop starts running in the constructor
+    std::thread thread_;
   };
 
+  const EventHubOptions options_;
+  // Must outlive message_queues_
+  InFlightEvents in_flight_events_;
+  const std::unique_ptr<FlightRecorder> flight_recorder_;
   std::shared_ptr<Dispatcher> dispatcher_;
   std::vector<std::shared_ptr<Handler>> handlers_;
   std::atomic<bool> event_hub_stopped_{false};
@@ -200,15 +988,17 @@ class TransportUnitStateImpl {
  public:
   TransportUnitStateImpl(const std::shared_ptr<analyzer::TransportUnitState> &unit_state);
 
-  void AddOneEvent();
-  void RemoveOneEvent();
+  // Called by InFlightEvents when a hub becomes busy or drained
+  void AddBusyHub();
+  void RemoveBusyHub();
 
+  // Sum of in flight events of all existing hubs
   int total_event_count() const;
 
  private:
   std::mutex mutex_;
   std::shared_ptr<analyzer::TransportUnitState> unit_state_;
-  int total_event_count_;
+  int busy_hubs_count_;
 };
 
 }  // namespace events
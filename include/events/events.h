@@ -23,23 +23,47 @@ namespace message_queues {
 struct MarketStream {
   MESSAGE_QUEUE("MarketStream")
 
-  enum class Event { kOrderBookUpdateEvent = 0, kNewTradeEvent, COUNT };
+  // kOrderBookResyncEvent replaces the book after a gap in kOrderBookUpdateEvent
+  enum class Event {
+    kOrderBookUpdateEvent = 0,
+    kNewTradeEvent,
+    kOrderBookResyncEvent,
+    COUNT
+  };
 };
 
 BIND_EVENT_TYPE(MarketStream, MarketStream::Event::kOrderBookUpdateEvent,
                 market_stream::types::OrderBook);
 BIND_EVENT_TYPE(MarketStream, MarketStream::Event::kNewTradeEvent,
                 market_stream::types::Trade);
+BIND_EVENT_TYPE(MarketStream, MarketStream::Event::kOrderBookResyncEvent,
+                market_stream::types::OrderBookResync);
 
 // OrderBookStream
 struct OrderBookStream {
   MESSAGE_QUEUE("OrderBookStream")
 
-  enum class Event { kNewSnapshotAvailable = 0, COUNT };
+  // kNewSnapshotAvailable ships the whole book on every update. kBestBidOfferChanged
+  // is sent only when the best levels change, kDepthChanged only when the first
+  // levels requested by subscribers change. kOrderBookResynced marks a book
+  // rebuilt after a gap, the snapshots around it are not diffs of each other.
+  enum class Event {
+    kNewSnapshotAvailable = 0,
+    kBestBidOfferChanged,
+    kDepthChanged,
+    kOrderBookResynced,
+    COUNT
+  };
 };
 
 BIND_EVENT_TYPE(OrderBookStream, OrderBookStream::Event::kNewSnapshotAvailable,
                 market_stream::types::OrderBook);
+BIND_EVENT_TYPE(OrderBookStream, OrderBookStream::Event::kBestBidOfferChanged,
+                market_stream::types::BestBidOffer);
+BIND_EVENT_TYPE(OrderBookStream, OrderBookStream::Event::kDepthChanged,
+                market_stream::types::OrderBookDepth);
+BIND_EVENT_TYPE(OrderBookStream, OrderBookStream::Event::kOrderBookResynced,
+                market_stream::types::OrderBookResyncMarker);
 
 // AnalyzerStream
 struct AnalyzerStream {
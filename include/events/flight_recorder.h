@@ -0,0 +1,89 @@
+#ifndef INCLUDE_EVENTS_FLIGHT_RECORDER_H_
+#define INCLUDE_EVENTS_FLIGHT_RECORDER_H_
+
+#include <atomic>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace events {
+
+const std::size_t kDefaultFlightRecorderCapacity = 64 * 1024;
+
+enum class FlightRecordType : uint8_t {
+  kDispatch = 0,  // event is dispatched to the hub
+  kDequeue,       // subscriber queue starts handling the event
+};
+
+struct FlightRecord {
+  uint64_t sequence;  // dispatch number of the event in the hub
+  int64_t time_ns;    // steady clock
+  uint64_t payload;   // payload address, the same for all subscribers of a shared one
+  uint32_t queue;     // subscriber queue index, kDequeue only
+  uint16_t event;
+  FlightRecordType type;
+  uint8_t reserved;
+};
+static_assert(sizeof(FlightRecord) == 32, "FlightRecord must stay compact");
+
+namespace flight_recorder_internal {
+struct Header;
+}  // namespace flight_recorder_internal
+
+// Appends records to a ring in a memory mapped file. The pages belong to the
+// file, so the last capacity records survive a crash of the process. Append is
+// one atomic increment and a record copy, any thread can record.
+class FlightRecorder {
+ public:
+  FlightRecorder() = delete;
+  FlightRecorder(const FlightRecorder &) = delete;
+  FlightRecorder(FlightRecorder &&) = delete;
+  FlightRecorder &operator=(const FlightRecorder &) = delete;
+  FlightRecorder &operator=(FlightRecorder &&) = delete;
+
+  // Existing file at path is overwritten
+  FlightRecorder(const std::string &path, const std::string &hub_name,
+                 std::size_t capacity);
+  ~FlightRecorder() = default;
+
+  // Returns the sequence of the dispatched event
+  uint64_t RecordDispatch(uint16_t event, const void *payload);
+  void RecordDequeue(uint16_t event, uint64_t sequence, uint32_t queue);
+
+ private:
+  void Append(const FlightRecord &record);
+
+  boost::interprocess::file_mapping file_;
+  boost::interprocess::mapped_region region_;
+  flight_recorder_internal::Header *header_;
+  std::atomic<uint64_t> next_sequence_{1};
+};
+
+// <dir>/<hub_name>.<pid>.<n>.trace, n counts the paths made by the process, so
+// hubs of the same type and processes sharing dir write to their own files
+std::string MakeFlightRecorderPath(const std::string &dir, const std::string &hub_name);
+
+// Reads back a recorder file, also one left by a crashed process
+class FlightRecording {
+ public:
+  explicit FlightRecording(const std::string &path);
+
+  const std::string &hub_name() const { return hub_name_; }
+  // Complete records in the order they were appended
+  const std::vector<FlightRecord> &records() const { return records_; }
+
+  std::chrono::system_clock::time_point ToSystemTime(int64_t time_ns) const;
+
+ private:
+  std::string hub_name_;
+  std::vector<FlightRecord> records_;
+  int64_t steady_to_system_ns_{0};
+};
+
+}  // namespace events
+
+#endif  // INCLUDE_EVENTS_FLIGHT_RECORDER_H_
@@ -0,0 +1,118 @@
+#ifndef INCLUDE_EVENTS_INLINE_EVENT_LOOP_H_
+#define INCLUDE_EVENTS_INLINE_EVENT_LOOP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+
+namespace events {
+
+// Run-to-completion FIFO of event callbacks shared by several EventHubs.
+// Nothing is processed until the owner calls RunUntilIdle, so events of all
+// hubs are handled one by one on the owner thread in the order they were posted.
+class InlineEventLoop {
+ public:
+  using EventFunc = std::function<void()>;
+
+  InlineEventLoop() = default;
+  InlineEventLoop(const InlineEventLoop &) = delete;
+  InlineEventLoop(InlineEventLoop &&) = delete;
+  InlineEventLoop &operator=(const InlineEventLoop &) = delete;
+  InlineEventLoop &operator=(InlineEventLoop &&) = delete;
+  ~InlineEventLoop() = default;
+
+  void Post(EventFunc &&event_func) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_queue_.push_back(std::move(event_func));
+  }
+
+  // Runs event_func once the queue drains in the next RunUntilIdle call, e.g. to
+  // poll for a result the events of that call may complete. Posting it again
+  // from event_func defers it to the call after.
+  void PostWhenIdle(EventFunc &&event_func) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_events_queue_.push_back(std::move(event_func));
+  }
+
+  // Runs event_func by the RunTimedEvents call for ts or later, e.g. to expire
+  // an order at its deadline. The owner calls it before handling anything newer
+  // than ts, so nothing newer can be seen by event_func.
+  void PostAt(uint64_t ts, EventFunc &&event_func) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    timed_events_.emplace(ts, std::move(event_func));
+  }
+
+  std::optional<uint64_t> NextTimedEventTs() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (timed_events_.empty()) {
+      return std::nullopt;
+    }
+    return timed_events_.begin()->first;
+  }
+
+  // Queues the events posted for ts or earlier, earliest first, and processes
+  // them like RunUntilIdle
+  std::size_t RunTimedEvents(uint64_t ts) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      const auto end = timed_events_.upper_bound(ts);
+      for (auto it = timed_events_.begin(); end != it; ++it) {
+        events_queue_.push_back(std::move(it->second));
+      }
+      timed_events_.erase(timed_events_.begin(), end);
+    }
+    return RunUntilIdle();
+  }
+
+  // Events posted by callbacks are processed in the same call.
+  // Returns the number of processed events.
+  std::size_t RunUntilIdle() {
+    if (is_running_) {
+      // Called from a callback, the outer call finishes the job
+      return 0;
+    }
+    is_running_ = true;
+    std::size_t processed_count = 0;
+    bool is_idle_events_posted = false;
+    while (true) {
+      EventFunc event_func;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (events_queue_.empty() && !is_idle_events_posted) {
+          is_idle_events_posted = true;
+          events_queue_.swap(idle_events_queue_);
+        }
+        if (events_queue_.empty()) {
+          break;
+        }
+        event_func = std::move(events_queue_.front());
+        events_queue_.pop_front();
+      }
+      event_func();
+      processed_count++;
+    }
+    is_running_ = false;
+    return processed_count;
+  }
+
+  bool empty() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return events_queue_.empty();
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  std::deque<EventFunc> events_queue_;
+  std::deque<EventFunc> idle_events_queue_;
+  // Equal timestamps keep the order they were posted in
+  std::multimap<uint64_t, EventFunc> timed_events_;
+  bool is_running_{false};
+};
+
+}  // namespace events
+
+#endif  // INCLUDE_EVENTS_INLINE_EVENT_LOOP_H_
@@ -0,0 +1,81 @@
+#ifndef INCLUDE_EVENTS_METRICS_H_
+#define INCLUDE_EVENTS_METRICS_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace events {
+
+using MetricsClock = std::chrono::steady_clock;
+
+struct LatencyHistogramSnapshot {
+  static const std::size_t kBucketsCount = 40;
+
+  // bucket i counts values in [2^(i-1), 2^i) ns, bucket 0 counts zeros
+  std::array<uint64_t, kBucketsCount> buckets{};
+  uint64_t count{0};
+  uint64_t sum_ns{0};
+  uint64_t max_ns{0};
+
+  // Upper bound of the bucket holding the given quantile, 0..1
+  uint64_t PercentileNs(double quantile) const;
+};
+
+// Power of 2 buckets of relaxed atomic counters, Record is wait-free
+class LatencyHistogram {
+ public:
+  void Record(std::chrono::nanoseconds value);
+  LatencyHistogramSnapshot snapshot() const;
+
+ private:
+  std::array<std::atomic<uint64_t>, LatencyHistogramSnapshot::kBucketsCount> buckets_{};
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> sum_ns_{0};
+  std::atomic<uint64_t> max_ns_{0};
+};
+
+struct QueueMetricsSnapshot {
+  std::string message_queue;
+  std::string subscriber;
+  int depth{0};
+  int max_depth{0};
+  // Enqueue to callback start time, indexed by MessageQueue::Event
+  std::vector<LatencyHistogramSnapshot> wait_time;
+  LatencyHistogramSnapshot handle_time;
+};
+
+// Metrics of one subscriber queue. Depth counts events queued or being processed.
+class QueueMetrics {
+ public:
+  QueueMetrics(const std::string &message_queue, const std::string &subscriber,
+               std::size_t events_count);
+
+  void OnEventQueued();
+  void OnEventDone() { depth_.fetch_sub(1, std::memory_order_relaxed); }
+
+  void RecordWaitTime(std::size_t event_index, std::chrono::nanoseconds value) {
+    wait_time_[event_index].Record(value);
+  }
+  void RecordHandleTime(std::chrono::nanoseconds value) { handle_time_.Record(value); }
+
+  QueueMetricsSnapshot snapshot() const;
+
+ private:
+  const std::string message_queue_;
+  const std::string subscriber_;
+  std::atomic<int> depth_{0};
+  std::atomic<int> max_depth_{0};
+  std::vector<LatencyHistogram> wait_time_;
+  LatencyHistogram handle_time_;
+};
+
+std::ostream &operator<<(std::ostream &os, const QueueMetricsSnapshot &o);
+
+}  // namespace events
+
+#endif  // INCLUDE_EVENTS_METRICS_H_
@@ -0,0 +1,102 @@
+#ifndef INCLUDE_EVENTS_RING_BUFFER_H_
+#define INCLUDE_EVENTS_RING_BUFFER_H_
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+
+namespace events {
+
+// Bounded multi-producer / single-consumer ring with preallocated slots.
+// Slots are filled and consumed in place, so a reused slot keeps the capacity of
+// its payload containers and no allocation happens per pushed element.
+template <class T>
+class RingBuffer {
+ public:
+  RingBuffer() = delete;
+  RingBuffer(const RingBuffer &) = delete;
+  RingBuffer(RingBuffer &&) = delete;
+  RingBuffer &operator=(const RingBuffer &) = delete;
+  RingBuffer &operator=(RingBuffer &&) = delete;
+
+  // capacity must be a power of two
+  explicit RingBuffer(std::size_t capacity)
+      : capacity_(capacity),
+        mask_(capacity - 1),
+        cells_(std::make_unique<Cell[]>(capacity)) {
+    assert(capacity >= 2 && (capacity & mask_) == 0 && "capacity must be power of 2");
+    for (std::size_t i = 0; i < capacity_; i++) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+  ~RingBuffer() = default;
+
+  // fill(T &slot) is called on the reserved slot before it is published.
+  // Returns false when the ring is full.
+  template <class Fill>
+  bool TryPush(Fill &&fill) {
+    Cell *cell;
+    std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      cell = &cells_[pos & mask_];
+      const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+      const auto diff =
+          static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+      if (0 == diff) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    fill(cell->data);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consume(T &slot) is called on the oldest slot, the slot is released to
+  // producers only after consume returns. Must be called from one thread only.
+  // Returns false when the ring is empty.
+  template <class Consume>
+  bool TryPop(Consume &&consume) {
+    Cell *cell = &cells_[dequeue_pos_ & mask_];
+    const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+    if (seq != dequeue_pos_ + 1) {
+      return false;
+    }
+    consume(cell->data);
+    cell->sequence.store(dequeue_pos_ + capacity_, std::memory_order_release);
+    ++dequeue_pos_;
+    return true;
+  }
+
+  bool empty() const {
+    const Cell &cell = cells_[dequeue_pos_ & mask_];
+    return cell.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1;
+  }
+
+  std::size_t capacity() const { return capacity_; }
+
+ private:
+  static constexpr std::size_t kCacheLineSize = 64;
+
+  struct alignas(kCacheLineSize) Cell {
+    std::atomic<std::size_t> sequence{0};
+    T data;
+  };
+
+  const std::size_t capacity_;
+  const std::size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+  alignas(kCacheLineSize) std::atomic<std::size_t> enqueue_pos_{0};
+  alignas(kCacheLineSize) std::size_t dequeue_pos_{0};
+};
+
+}  // namespace events
+
+#endif  // INCLUDE_EVENTS_RING_BUFFER_H_
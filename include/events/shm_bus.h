@@ -0,0 +1,245 @@
+#ifndef INCLUDE_EVENTS_SHM_BUS_H_
+#define INCLUDE_EVENTS_SHM_BUS_H_
+
+#include <spdlog/spdlog.h>
+
+#include <atomic>
+#include <boost/archive/archive_exception.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <chrono>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "event_hub.h"
+#include "shm_ring.h"
+
+namespace events {
+
+struct ShmBusOptions {
+  std::size_t capacity{1024};        // slots in the ring
+  std::size_t slot_size{64 * 1024};  // max serialized event size
+};
+
+// Slot size for queues carrying whole books, e.g. the 5000 levels per side REST
+// depth book. Each price and quantity is serialized as DoubleType, so such an
+// event takes about 1 MB.
+const std::size_t kBookShmBusSlotSize = 4 * 1024 * 1024;
+
+// Ring name of the MessageQueue events on the bus
+template <class MessageQueue>
+std::string ShmBusRingName(const std::string &bus_name) {
+  return bus_name + "." + MessageQueue::kClassName;
+}
+
+// Stream buffer over a fixed memory block, used to serialize events right into
+// the shared memory slot and to deserialize them right from it
+class MemoryStreamBuf : public std::streambuf {
+ public:
+  MemoryStreamBuf(char *data, std::size_t size) { setp(data, data + size); }
+  MemoryStreamBuf(const char *data, std::size_t size) {
+    auto *begin = const_cast<char *>(data);
+    setg(begin, begin, begin + size);
+  }
+
+  std::size_t written() const { return pptr() - pbase(); }
+};
+
+// Publishes all events of the hub the handler belongs to on the shared memory
+// bus. Serialization runs on the handler queue worker, the dispatcher does not
+// wait for it.
+template <class MessageQueue>
+class ShmBusPublisher {
+  using Event = typename MessageQueue::Event;
+  using EventHubHandler = typename EventHub<MessageQueue>::Handler;
+
+  template <Event e>
+  using EventType = typename MessageQueue::template EventTypeFromId<e>::type;
+
+ public:
+  ShmBusPublisher() = delete;
+  ShmBusPublisher(const ShmBusPublisher &) = delete;
+  ShmBusPublisher(ShmBusPublisher &&) = delete;
+  ShmBusPublisher &operator=(const ShmBusPublisher &) = delete;
+  ShmBusPublisher &operator=(ShmBusPublisher &&) = delete;
+
+  ShmBusPublisher(const std::weak_ptr<EventHubHandler> &event_handler,
+                  const std::string &bus_name,
+                  const ShmBusOptions &options = ShmBusOptions())
+      : ring_(ShmBusRingName<MessageQueue>(bus_name), options.capacity,
+              options.slot_size) {
+    SUBSCRIBE_TO_EVENT(event_handler, &ShmBusPublisher::OnEvent);
+  }
+  ~ShmBusPublisher() = default;
+
+ private:
+  void OnEvent(Event event, const void *data) {
+    const bool is_published =
+        ring_.Publish(static_cast<uint32_t>(event), [&](char *slot, std::size_t size) {
+          return Serialize(
+              event, data, slot, size,
+              std::make_index_sequence<static_cast<std::size_t>(Event::COUNT)>());
+        });
+    if (!is_published) {
+      spdlog::error("{} event {} does not fit into {} bytes bus slot",
+                    MessageQueue::kClassName, static_cast<int>(event), ring_.slot_size());
+    }
+  }
+
+  template <std::size_t... ids>
+  static std::size_t Serialize(Event event, const void *data, char *slot,
+                               std::size_t size, std::index_sequence<ids...>) {
+    std::size_t written = 0;
+    ((static_cast<Event>(ids) == event
+          ? void(written = Serialize<static_cast<Event>(ids)>(data, slot, size))
+          : void()),
+     ...);
+    return written;
+  }
+
+  template <Event e>
+  static std::size_t Serialize(const void *data, char *slot, std::size_t size) {
+    MemoryStreamBuf buf(slot, size);
+    try {
+      boost::archive::binary_oarchive archive(
+          buf, boost::archive::no_header | boost::archive::no_codecvt);
+      archive << *static_cast<const EventType<e> *>(data);
+    } catch (const boost::archive::archive_exception &) {
+      return 0;
+    }
+    return buf.written();
+  }
+
+  ShmRingWriter ring_;
+};
+
+// Reads events of another process from the shared memory bus and dispatches
+// them to a local hub, so its handlers are used the same way as for local
+// events. An event is deserialized once right from the shared memory slot and
+// dispatched as a shared payload to all the subscribers.
+template <class MessageQueue>
+class ShmBusSubscriber {
+  using Event = typename MessageQueue::Event;
+  using EventHubDispatcher = typename EventHub<MessageQueue>::Dispatcher;
+
+  template <Event e>
+  using EventType = typename MessageQueue::template EventTypeFromId<e>::type;
+
+ public:
+  ShmBusSubscriber() = delete;
+  ShmBusSubscriber(const ShmBusSubscriber &) = delete;
+  ShmBusSubscriber(ShmBusSubscriber &&) = delete;
+  ShmBusSubscriber &operator=(const ShmBusSubscriber &) = delete;
+  ShmBusSubscriber &operator=(ShmBusSubscriber &&) = delete;
+
+  // Exits if the publisher of bus_name is not running. WaitStrategy::kBusySpin
+  // polls the ring all the time, otherwise the reader sleeps when it is empty.
+  ShmBusSubscriber(const std::weak_ptr<EventHubDispatcher> &event_dispatcher,
+                   const std::string &bus_name,
+                   const WorkerOptions &worker_options = WorkerOptions())
+      : event_dispatcher_(event_dispatcher),
+        ring_(ShmBusRingName<MessageQueue>(bus_name)),
+        worker_options_(worker_options),
+        thread_(std::bind(&ShmBusSubscriber::ThreadLoop, this)) {}
+  ~ShmBusSubscriber() { Stop(); }
+
+  void Stop() {
+    is_stopped_ = true;
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+  // Events overwritten on the bus before this subscriber read them
+  uint64_t lagged_events() const { return lagged_events_; }
+
+ private:
+  static const int kSpinCount = 128;
+  static constexpr auto kSleepTime = std::chrono::microseconds(50);
+
+  using DispatchFunc = std::function<void()>;
+
+  void ThreadLoop() {
+    SetupWorkerThread(worker_options_);
+    int idle_count = 0;
+    while (!is_stopped_) {
+      DispatchFunc dispatch;
+      const auto result = ring_.TryRead([&](uint32_t tag, const char *data,
+                                            std::size_t size) {
+        dispatch = Deserialize(
+            static_cast<Event>(tag), data, size,
+            std::make_index_sequence<static_cast<std::size_t>(Event::COUNT)>());
+      });
+
+      switch (result) {
+        case ShmRingReader::ReadResult::kRead:
+          idle_count = 0;
+          if (dispatch) {
+            dispatch();
+          }
+          break;
+
+        case ShmRingReader::ReadResult::kLagged:
+          spdlog::warn("{} bus subscriber lagged, {} events skipped in total",
+                       MessageQueue::kClassName, ring_.lagged_messages());
+          lagged_events_ = ring_.lagged_messages();
+          break;
+
+        default:
+          if (WaitStrategy::kBusySpin != worker_options_.wait_strategy &&
+              ++idle_count > kSpinCount) {
+            std::this_thread::sleep_for(kSleepTime);
+          }
+          break;
+      }
+    }
+  }
+
+  template <std::size_t... ids>
+  DispatchFunc Deserialize(Event event, const char *data, std::size_t size,
+                           std::index_sequence<ids...>) {
+    DispatchFunc dispatch;
+    ((static_cast<Event>(ids) == event
+          ? void(dispatch = Deserialize<static_cast<Event>(ids)>(data, size))
+          : void()),
+     ...);
+    return dispatch;
+  }
+
+  // The slot may be overwritten while it is read, so garbage is not an error
+  // here: the ring reports it and the result is dropped
+  template <Event e>
+  DispatchFunc Deserialize(const char *data, std::size_t size) {
+    auto event_data = std::make_shared<EventType<e>>();
+    MemoryStreamBuf buf(data, size);
+    try {
+      boost::archive::binary_iarchive archive(
+          buf, boost::archive::no_header | boost::archive::no_codecvt);
+      archive >> *event_data;
+    } catch (const std::exception &) {
+      return DispatchFunc();
+    }
+    return [this, event_data = std::shared_ptr<const EventType<e>>(
+                      std::move(event_data))]() {
+      auto event_dispatcher_locked = event_dispatcher_.lock();
+      if (event_dispatcher_locked) {
+        event_dispatcher_locked->template DispatchSharedEvent<e>(event_data);
+      }
+    };
+  }
+
+  std::weak_ptr<EventHubDispatcher> event_dispatcher_;
+  ShmRingReader ring_;
+  const WorkerOptions worker_options_;
+  std::atomic<uint64_t> lagged_events_{0};
+  std::atomic<bool> is_stopped_{false};
+  // Must be the last member: the loop starts running in the constructor
+  std::thread thread_;
+};
+
+}  // namespace events
+
+#endif  // INCLUDE_EVENTS_SHM_BUS_H_
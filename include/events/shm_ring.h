@@ -0,0 +1,116 @@
+#ifndef INCLUDE_EVENTS_SHM_RING_H_
+#define INCLUDE_EVENTS_SHM_RING_H_
+
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace events {
+
+namespace shm_ring_internal {
+struct Header;
+struct Slot;
+}  // namespace shm_ring_internal
+
+// Single producer broadcast ring of fixed size slots in a named shared memory
+// segment. The producer never waits for readers: a slot is overwritten capacity
+// messages later. Every slot carries a sequence, so a reader that fell that far
+// behind, or whose slot got overwritten while it was being read, notices it.
+class ShmRingWriter {
+ public:
+  ShmRingWriter() = delete;
+  ShmRingWriter(const ShmRingWriter &) = delete;
+  ShmRingWriter(ShmRingWriter &&) = delete;
+  ShmRingWriter &operator=(const ShmRingWriter &) = delete;
+  ShmRingWriter &operator=(ShmRingWriter &&) = delete;
+
+  // A stale segment with the same name is replaced, the segment is removed
+  // when the writer is destroyed
+  ShmRingWriter(const std::string &name, std::size_t capacity, std::size_t slot_size);
+  ~ShmRingWriter();
+
+  // write(char *data, std::size_t slot_size) serializes the message in place and
+  // returns its size, 0 if it does not fit. Returns false if nothing was published.
+  template <class Write>
+  bool Publish(uint32_t tag, const Write &write) {
+    char *data = BeginWrite();
+    const std::size_t size = write(data, slot_size_);
+    if (0 == size) {
+      return false;
+    }
+    EndWrite(tag, size);
+    return true;
+  }
+
+  std::size_t slot_size() const { return slot_size_; }
+
+ private:
+  char *BeginWrite();
+  void EndWrite(uint32_t tag, std::size_t size);
+
+  const std::string name_;
+  const std::size_t slot_size_;
+  boost::interprocess::shared_memory_object shm_;
+  boost::interprocess::mapped_region region_;
+  shm_ring_internal::Header *header_;
+  shm_ring_internal::Slot *slot_{nullptr};  // slot being written
+  uint64_t sequence_{0};                    // sequence of the next message
+};
+
+class ShmRingReader {
+ public:
+  enum class ReadResult {
+    kEmpty = 0,  // no new message
+    kRead,       // message is read
+    kLagged,     // messages were overwritten before being read, reader skipped them
+  };
+
+  ShmRingReader() = delete;
+  ShmRingReader(const ShmRingReader &) = delete;
+  ShmRingReader(ShmRingReader &&) = delete;
+  ShmRingReader &operator=(const ShmRingReader &) = delete;
+  ShmRingReader &operator=(ShmRingReader &&) = delete;
+
+  // Reader starts from the next published message
+  explicit ShmRingReader(const std::string &name);
+  ~ShmRingReader() = default;
+
+  // read(uint32_t tag, const char *data, std::size_t size) gets the slot memory
+  // itself, nothing is copied. The slot may be overwritten meanwhile, so read must
+  // tolerate garbage and its result must be dropped unless kRead is returned.
+  template <class Read>
+  ReadResult TryRead(const Read &read) {
+    uint64_t slot_sequence = 0;
+    ReadResult result = BeginRead(&slot_sequence);
+    if (ReadResult::kRead != result) {
+      return result;
+    }
+    read(tag(), data(), size());
+    return EndRead(slot_sequence);
+  }
+
+  // Number of messages skipped since the reader was created
+  uint64_t lagged_messages() const { return lagged_messages_; }
+
+ private:
+  ReadResult BeginRead(uint64_t *slot_sequence);
+  ReadResult EndRead(uint64_t slot_sequence);
+  ReadResult SkipToLatest();
+
+  uint32_t tag() const;
+  const char *data() const;
+  std::size_t size() const;
+
+  boost::interprocess::shared_memory_object shm_;
+  boost::interprocess::mapped_region region_;
+  const shm_ring_internal::Header *header_;
+  const shm_ring_internal::Slot *slot_{nullptr};  // slot being read
+  uint64_t sequence_{0};                          // sequence of the next message
+  uint64_t lagged_messages_{0};
+};
+
+}  // namespace events
+
+#endif  // INCLUDE_EVENTS_SHM_RING_H_
@@ -0,0 +1,66 @@
+#ifndef INCLUDE_EVENTS_WORK_STEALING_POOL_H_
+#define INCLUDE_EVENTS_WORK_STEALING_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace events {
+
+// Fixed-size pool of worker threads, each with its own task deque. A task
+// submitted from a worker goes to that worker deque, other tasks are spread
+// round-robin. An idle worker steals from the back of other workers deques.
+// Tasks have no ordering guarantees, ordering is up to the submitter.
+class WorkStealingPool {
+ public:
+  using Task = std::function<void()>;
+
+  WorkStealingPool() = delete;
+  WorkStealingPool(const WorkStealingPool &) = delete;
+  WorkStealingPool(WorkStealingPool &&) = delete;
+  WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+  WorkStealingPool &operator=(WorkStealingPool &&) = delete;
+
+  // threads_count 0 means one thread per hardware core
+  explicit WorkStealingPool(std::size_t threads_count,
+                            const std::string &thread_name = "events.pool");
+  ~WorkStealingPool();
+
+  // Returns false and drops task if submitted from outside the pool after
+  // Shutdown, the submitter has to run it
+  bool Submit(Task &&task);
+
+  // Runs the tasks left and joins the worker threads
+  void Shutdown();
+
+  std::size_t threads_count() const { return workers_.size(); }
+
+ private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void WorkerLoop(std::size_t worker_index, const std::string &thread_name);
+  bool TryPopTask(std::size_t worker_index, Task *task);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<std::size_t> next_worker_{0};
+  std::atomic<int> pending_tasks_{0};
+  std::atomic<bool> is_stopped_{false};
+  std::atomic<int> idle_workers_{0};
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace events
+
+#endif  // INCLUDE_EVENTS_WORK_STEALING_POOL_H_
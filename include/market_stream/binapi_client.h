@@ -4,6 +4,8 @@
 #include <binapi/api.hpp>
 #include <binapi/websocket.hpp>
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <functional>
 #include <memory>
 #include <thread>
 
@@ -28,10 +30,19 @@ class BinAPIClient : public IBinAPIClient {
       const DepthUpdateRawCallback& depth_book_update_cb) override;
   void SubscribeToTradeStream(const TradeRawCallback& trade_cb) override;
   void GetDepthAsync(const DepthRawCallback& depth_callback) override;
+  void RunAfterRetryDelay(const std::function<void()>& func) override;
 
   void Run();
+  // Unsubscribes from the streams and joins the io thread, no callback is called
+  // after it returns
+  void Stop();
 
  private:
+  // Failed requests are sent again and a failed stream is reconnected after a
+  // delay instead of stopping the process
+  void RequestDepth(const DepthRawCallback& depth_callback);
+  void RunCombinedStream();
+
   std::atomic<bool> stop_monitor_thread_{false};
   bool run_ws_combined_stream_{false};
   std::thread monitor_thread_;
@@ -23,6 +23,8 @@ class IBinAPIClient {
       const DepthUpdateRawCallback& depth_book_update_cb) = 0;
   virtual void SubscribeToTradeStream(const TradeRawCallback& trade_cb) = 0;
   virtual void GetDepthAsync(const DepthRawCallback& depth_callback) = 0;
+  // Runs func on the client thread after a delay, e.g. to send a request again
+  virtual void RunAfterRetryDelay(const std::function<void()>& func) = 0;
   virtual void Run() = 0;
 
  protected:
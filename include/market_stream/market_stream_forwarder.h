@@ -27,16 +27,25 @@ class MarketStreamForwarder {
   MarketStreamForwarder &operator=(const MarketStreamForwarder &) = delete;
   MarketStreamForwarder &operator=(MarketStreamForwarder &&) = delete;
 
+  // If state_dir is set, the order book is written there by Stop and the next
+  // forwarder of the symbol resumes from it without a depth snapshot when it
+  // still chains to the live updates
   MarketStreamForwarder(const std::string &symbol,
-                        const std::weak_ptr<EventHubDispatcher> &event_dispatcher);
-  ~MarketStreamForwarder() = default;
+                        const std::weak_ptr<EventHubDispatcher> &event_dispatcher,
+                        const std::string &state_dir = "");
+  // Stops if Stop was not called
+  ~MarketStreamForwarder();
 
   virtual void Initialize();
   virtual void StartAsync();
+  // Stops the binapi client, then writes the order book state. Nothing is
+  // dispatched after it returns.
+  void Stop();
 
  protected:
   void OnTradeReceived(types::Trade &&trade);
   void OnOrderBookUpdate(types::OrderBook &&update);
+  void OnOrderBookResync(types::OrderBook &&order_book);
 
   std::shared_ptr<BinAPIClient> binapi_client_;
   std::unique_ptr<TradeStreamForwarder> trade_stream_;
@@ -45,7 +54,9 @@ class MarketStreamForwarder {
 
  private:
   std::string symbol_;
+  std::string state_dir_;
   std::atomic<bool> order_book_stream_started_{false};
+  bool is_stopped_{false};
 };
 
 }  // namespace market_stream
@@ -27,7 +27,11 @@ class MarketStreamPrinter {
   ~MarketStreamPrinter();
 
  private:
-  void OnMarketStreamEvent(MQ::Event event, const void *data);
+  friend class events::TypedEventHandlerAccess;
+
+  void OnEvent(const types::Trade &trade);
+  void OnEvent(const types::OrderBook &order_book);
+  void OnEvent(const types::OrderBookResync &resync);
 
   std::ostream &out_stream_;
 };
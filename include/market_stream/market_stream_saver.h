@@ -30,7 +30,11 @@ class MarketStreamSaver {
   static std::string filename();
 
  private:
-  void OnMarketStreamEvent(MQ::Event event, const void *data);
+  friend class events::TypedEventHandlerAccess;
+
+  void OnEvent(const types::Trade &trade);
+  void OnEvent(const types::OrderBook &order_book);
+  void OnEvent(const types::OrderBookResync &resync);
 
   std::ofstream file_;
   boost::filesystem::path file_path_;
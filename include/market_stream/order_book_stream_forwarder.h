@@ -3,10 +3,14 @@
 
 #include <binapi/types.hpp>
 #include <cctype>
+#include <deque>
 #include <functional>
 #include <memory>
-#include <vector>
+#include <mutex>
+#include <optional>
+#include <string>
 
+#include "analyzer/order_book_engine.h"
 #include "i_stream_forwarder.h"
 #include "types/types.h"
 
@@ -23,22 +27,52 @@ class OrderBookStreamForwarder : public IStreamForwarder {
   OrderBookStreamForwarder &operator=(OrderBookStreamForwarder &&) = delete;
 
   using OrderBookUpdateCallback = std::function<void(types::OrderBook &&)>;
+  // order_book_resync_cb gets the book fetched again after a gap in the update
+  // ids, the stream goes on with diffs over it. Without it the fetched book is
+  // sent to order_book_update_cb.
+  // If state_path is set, the forwarded book is kept and written there by
+  // SaveState. The next forwarder with that path starts from the written book
+  // instead of fetching a depth snapshot if the first update chains to it.
   OrderBookStreamForwarder(const std::shared_ptr<IBinAPIClient> &binapi_client,
-                           const OrderBookUpdateCallback &order_book_update_cb);
+                           const OrderBookUpdateCallback &order_book_update_cb,
+                           const OrderBookUpdateCallback &order_book_resync_cb = nullptr,
+                           const std::string &state_path = "");
   ~OrderBookStreamForwarder() = default;
 
   // IStreamForwarder
   virtual std::future<void> StartAsync() override;
 
+  // Writes the forwarded book to the state path, if any. No update may be
+  // received meanwhile, e.g. the binapi client is stopped.
+  void SaveState();
+
+  static bool WriteState(const std::string &path, const types::OrderBookState &state);
+  // Empty if there is no readable state at path
+  static std::optional<types::OrderBookState> ReadState(const std::string &path);
+
  protected:
   OrderBookUpdateCallback order_book_update_cb_;
+  OrderBookUpdateCallback order_book_resync_cb_;
 
  private:
   void OnBinAPIDepthUpdate(binapi::ws::diff_depths_t &&diff_depths);
   void OnBinAPIDepthRecieve(binapi::rest::depths_t &&depths);
+  // Drops the oldest buffered update if the buffer is full
+  void BufferUpdate(binapi::ws::diff_depths_t &&diff_depths);
   void ProcessBufferedUpdates();
+  // Buffers diff_depths and fetches the depth snapshot to start the stream from
+  void RequestDepthSnapshot(binapi::ws::diff_depths_t &&diff_depths);
+  // Starts the stream from the stored state and diff_depths, which is moved, if
+  // diff_depths chains to the state
+  bool ResumeFromStoredState(binapi::ws::diff_depths_t &diff_depths);
+  void OnStreamStarted();
 
-  std::vector<binapi::ws::diff_depths_t>::iterator SearchFirstRealUpdate(
+  void ForwardBook(types::OrderBook &&order_book, uint64_t last_update_id);
+  void ForwardDiff(binapi::ws::diff_depths_t &&diff_depths);
+  void KeepState(const types::OrderBook &update, uint64_t last_update_id,
+                 bool is_whole_book);
+
+  std::deque<binapi::ws::diff_depths_t>::iterator SearchFirstRealUpdate(
       uint64_t last_update_id);
 
   enum class InitStage {
@@ -49,10 +83,21 @@ class OrderBookStreamForwarder : public IStreamForwarder {
   };
 
   InitStage init_stage_;
+  // Depth snapshots fetched after the first one are resyncs
+  bool is_book_sent_{false};
+  bool is_stream_started_{false};
   uint64_t depth_last_update_id_{0};
   uint64_t previous_last_update_id_{0};
   std::shared_ptr<IBinAPIClient> binapi_client_;
-  std::vector<binapi::ws::diff_depths_t> depth_updates_buffer_;
+  std::deque<binapi::ws::diff_depths_t> depth_updates_buffer_;
+
+  const std::string state_path_;
+  // Read at construction, dropped once the first update is received
+  std::optional<types::OrderBookState> stored_state_;
+  // Forwarded book, written by the stream thread and read by SaveState
+  std::mutex state_mutex_;
+  std::unique_ptr<analyzer::OrderBookEngine> state_engine_;
+  uint64_t state_last_update_id_{0};
 };
 
 }  // namespace market_stream
@@ -0,0 +1,123 @@
+#ifndef INCLUDE_MARKET_STREAM_TYPES_FIXED_POINT_H_
+#define INCLUDE_MARKET_STREAM_TYPES_FIXED_POINT_H_
+
+#include <fmt/format.h>
+
+#include <binapi/types.hpp>
+#include <boost/serialization/level.hpp>
+#include <boost/serialization/split_member.hpp>
+#include <boost/serialization/tracking.hpp>
+#include <cstdint>
+#include <ostream>
+
+namespace market_stream {
+namespace types {
+
+using DoubleType = binapi::double_type;
+
+// Price or quantity as a count of 1e-8 units. Tick and step sizes of every
+// Binance symbol are multiples of 1e-8, so market data is represented exactly
+// and compared as plain integers. Conversion to DoubleType is left to the edges:
+// orders, reports and recordings. The single scale bounds values to
+// kMaxTicks / kScale, about 9.2e10: larger ones are logged as errors and
+// saturated to +-kMaxTicks by both conversions.
+class FixedPoint {
+ public:
+  static constexpr int kDecimals = 8;
+  static constexpr int64_t kScale = 100000000;
+  static constexpr int64_t kMaxTicks = INT64_MAX;
+
+  constexpr FixedPoint() = default;
+  FixedPoint(const DoubleType& value);
+  FixedPoint(double value);
+
+  static constexpr FixedPoint FromTicks(int64_t ticks) {
+    FixedPoint result;
+    result.ticks_ = ticks;
+    return result;
+  }
+
+  constexpr int64_t ticks() const { return ticks_; }
+  constexpr bool is_zero() const { return 0 == ticks_; }
+
+  DoubleType ToDecimal() const;
+  double ToDouble() const { return static_cast<double>(ticks_) / kScale; }
+
+  constexpr FixedPoint operator-() const { return FromTicks(-ticks_); }
+  constexpr FixedPoint& operator+=(FixedPoint other) {
+    ticks_ += other.ticks_;
+    return *this;
+  }
+  constexpr FixedPoint& operator-=(FixedPoint other) {
+    ticks_ -= other.ticks_;
+    return *this;
+  }
+
+  friend constexpr FixedPoint operator+(FixedPoint l, FixedPoint r) { return l += r; }
+  friend constexpr FixedPoint operator-(FixedPoint l, FixedPoint r) { return l -= r; }
+  friend constexpr bool operator==(FixedPoint l, FixedPoint r) {
+    return l.ticks_ == r.ticks_;
+  }
+  friend constexpr bool operator!=(FixedPoint l, FixedPoint r) {
+    return l.ticks_ != r.ticks_;
+  }
+  friend constexpr bool operator<(FixedPoint l, FixedPoint r) {
+    return l.ticks_ < r.ticks_;
+  }
+  friend constexpr bool operator>(FixedPoint l, FixedPoint r) {
+    return l.ticks_ > r.ticks_;
+  }
+  friend constexpr bool operator<=(FixedPoint l, FixedPoint r) {
+    return l.ticks_ <= r.ticks_;
+  }
+  friend constexpr bool operator>=(FixedPoint l, FixedPoint r) {
+    return l.ticks_ >= r.ticks_;
+  }
+
+  // Stored as DoubleType, so recordings made before FixedPoint stay readable
+  template <typename Archive>
+  void save(Archive& ar, const unsigned int version) const {
+    const DoubleType value = ToDecimal();
+    ar & value;
+  }
+  template <typename Archive>
+  void load(Archive& ar, const unsigned int version) {
+    DoubleType value;
+    ar & value;
+    *this = FixedPoint(value);
+  }
+  BOOST_SERIALIZATION_SPLIT_MEMBER()
+
+  // Respects stream precision and flags the same way DoubleType does
+  friend std::ostream& operator<<(std::ostream& os, FixedPoint o);
+
+ private:
+  int64_t ticks_{0};
+};
+
+}  // namespace types
+}  // namespace market_stream
+
+// No class info in archives: a FixedPoint is written exactly like a DoubleType
+BOOST_CLASS_IMPLEMENTATION(market_stream::types::FixedPoint,
+                           boost::serialization::object_serializable)
+BOOST_CLASS_TRACKING(market_stream::types::FixedPoint, boost::serialization::track_never)
+
+namespace fmt {
+template <>
+struct formatter<market_stream::types::FixedPoint> {
+  constexpr auto parse(format_parse_context& ctx) -> decltype(ctx.begin()) {
+    return ctx.begin();
+  }
+
+  template <typename FormatContext>
+  auto format(const market_stream::types::FixedPoint& value, FormatContext& ctx)
+      -> decltype(ctx.out()) {
+    return format_to(ctx.out(), "{}",
+                     value.ToDecimal().str(market_stream::types::FixedPoint::kDecimals,
+                                           std::ios::fixed));
+  }
+};
+}  // namespace fmt
+
+#endif  // INCLUDE_MARKET_STREAM_TYPES_FIXED_POINT_H_
@@ -0,0 +1,78 @@
+#ifndef INCLUDE_MARKET_STREAM_TYPES_ORDER_BOOK_COLUMNS_H_
+#define INCLUDE_MARKET_STREAM_TYPES_ORDER_BOOK_COLUMNS_H_
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "market_stream/types/types.h"
+
+namespace market_stream {
+namespace types {
+
+// One side of an order book as separate contiguous price and quantity tick
+// arrays, best level first. Scans over thousands of levels stay in cache and
+// are vectorised with AVX2 when built with ENABLE_AVX2, scalar otherwise.
+class OrderBookLevels {
+ public:
+  OrderBookLevels() = default;
+  OrderBookLevels(const OrderBookLevels&) = default;
+  OrderBookLevels& operator=(const OrderBookLevels&) = default;
+  OrderBookLevels(OrderBookLevels&&) = default;
+  OrderBookLevels& operator=(OrderBookLevels&&) = default;
+
+  // is_increasing is true for asks and false for bids
+  OrderBookLevels(const OrderBook::Items& items, bool is_increasing);
+
+  std::size_t size() const { return prices_.size(); }
+  bool empty() const { return prices_.empty(); }
+  bool is_increasing() const { return is_increasing_; }
+  FixedPoint price(std::size_t level) const {
+    return FixedPoint::FromTicks(prices_[level]);
+  }
+  FixedPoint quantity(std::size_t level) const {
+    return FixedPoint::FromTicks(quantities_[level]);
+  }
+
+  // Number of levels with a better price than the given one, i.e. the index the
+  // price would be inserted at
+  std::size_t CountLevelsBetterThan(FixedPoint price) const;
+  // Index of the level with the given price or size() if there is no such level
+  std::size_t FindLevel(FixedPoint price) const;
+
+  // Total quantity of the first levels_count levels. Totals may not fit into
+  // FixedPoint on low priced symbols, so they are given as double.
+  double Depth(std::size_t levels_count) const;
+  // Running total of quantity, element i is the depth of the first i + 1 levels
+  std::vector<double> CumulativeDepth() const;
+  // Index of the level at which the depth reaches volume, i.e. the worst level a
+  // market order of that volume would fill at, or size() if the side is thinner
+  std::size_t FindLevelForVolume(FixedPoint volume) const;
+
+  // Cosine similarity of quantities over the first levels_count levels of
+  // reference, local levels are matched by price and count as 0 when missing.
+  // Empty if either vector is zero.
+  static std::optional<double> CosineSimilarity(const OrderBookLevels& local,
+                                                const OrderBookLevels& reference,
+                                                std::size_t levels_count);
+
+ private:
+  std::vector<int64_t> prices_;
+  std::vector<int64_t> quantities_;
+  bool is_increasing_{true};
+};
+
+struct OrderBookColumns {
+  uint64_t timestamp{0};           // ms
+  uint64_t received_timestamp{0};  // ms
+  OrderBookLevels bids{{}, false};
+  OrderBookLevels asks{{}, true};
+
+  OrderBookColumns() = default;
+  explicit OrderBookColumns(const OrderBook& order_book);
+};
+
+}  // namespace types
+}  // namespace market_stream
+
+#endif  // INCLUDE_MARKET_STREAM_TYPES_ORDER_BOOK_COLUMNS_H_
@@ -6,16 +6,17 @@
 #include <binapi/types.hpp>
 #include <boost/archive/binary_iarchive.hpp>
 #include <boost/archive/binary_oarchive.hpp>
+#include <boost/serialization/split_member.hpp>
 #include <boost/serialization/vector.hpp>
 #include <cctype>
 #include <vector>
 
+#include "market_stream/types/fixed_point.h"
+
 namespace market_stream {
 namespace types {
 
-using DoubleType = binapi::double_type;
-
-enum class MarketDataType { ORDER_BOOK = 0, TRADE };
+enum class MarketDataType { ORDER_BOOK = 0, TRADE, ORDER_BOOK_RESYNC };
 template <class Archive>
 void serialize(Archive& ar, MarketDataType& type, const unsigned int version) {
   ar & type;
@@ -23,8 +24,8 @@ void serialize(Archive& ar, MarketDataType& type, const unsigned int version) {
 
 struct OrderBook {
   struct Item {
-    DoubleType price;
-    DoubleType quantity;
+    FixedPoint price;
+    FixedPoint quantity;
 
     Item() = default;
     Item(const Item&) = default;
@@ -32,7 +33,7 @@ struct OrderBook {
     Item(Item&&) = default;
     Item& operator=(Item&&) = default;
 
-    Item(DoubleType _price, DoubleType _quantity) : price(_price), quantity(_quantity) {}
+    Item(FixedPoint _price, FixedPoint _quantity) : price(_price), quantity(_quantity) {}
     Item(binapi::rest::depths_t::depth_t&& depth) noexcept;
     Item(binapi::ws::diff_depths_t::depth_t&& depth) noexcept;
 
@@ -69,9 +70,100 @@ struct OrderBook {
   friend std::ostream& operator<<(std::ostream& os, const Items& o);
 };
 
+// Best levels of both sides, a zero item stands for an empty side
+struct BestBidOffer {
+  uint64_t timestamp{0};           // ms
+  uint64_t received_timestamp{0};  // ms
+  OrderBook::Item bid;
+  OrderBook::Item ask;
+
+  template <typename Archive>
+  void serialize(Archive& ar, const unsigned int version) {
+    ar & timestamp & received_timestamp & bid & ask;
+  }
+
+  friend std::ostream& operator<<(std::ostream& os, const BestBidOffer& o);
+};
+
+// First levels of both sides, best level first
+struct OrderBookDepth {
+  uint64_t timestamp{0};           // ms
+  uint64_t received_timestamp{0};  // ms
+  OrderBook::Items bids;
+  OrderBook::Items asks;
+
+  template <typename Archive>
+  void serialize(Archive& ar, const unsigned int version) {
+    ar & timestamp & received_timestamp & bids & asks;
+  }
+
+  friend std::ostream& operator<<(std::ostream& os, const OrderBookDepth& o);
+};
+
+// Whole book fetched again after a gap in the update stream. Replaces the book
+// built so far, the updates that follow are diffs over it.
+struct OrderBookResync {
+  OrderBook order_book;
+
+  template <typename Archive>
+  void serialize(Archive& ar, const unsigned int version) {
+    ar & order_book;
+  }
+
+  friend std::ostream& operator<<(std::ostream& os, const OrderBookResync& o);
+};
+
+// Sent once the book is replaced by a resync, timestamps are the ones of the
+// fetched book
+struct OrderBookResyncMarker {
+  uint64_t timestamp{0};           // ms
+  uint64_t received_timestamp{0};  // ms
+
+  template <typename Archive>
+  void serialize(Archive& ar, const unsigned int version) {
+    ar & timestamp & received_timestamp;
+  }
+
+  friend std::ostream& operator<<(std::ostream& os, const OrderBookResyncMarker& o);
+};
+
+// Book of a live stream with the id of the last diff merged into it, kept to
+// resume the stream on the next start. Levels are stored as raw ticks, half
+// the size of the DoubleType kept by recordings.
+struct OrderBookState {
+  uint64_t last_update_id{0};
+  OrderBook order_book;
+
+  template <typename Archive>
+  void save(Archive& ar, const unsigned int version) const {
+    ar & last_update_id & order_book.timestamp & order_book.received_timestamp;
+    std::vector<int64_t> ticks = ToTicks(order_book.bids);
+    ar & ticks;
+    ticks = ToTicks(order_book.asks);
+    ar & ticks;
+  }
+
+  template <typename Archive>
+  void load(Archive& ar, const unsigned int version) {
+    ar & last_update_id & order_book.timestamp & order_book.received_timestamp;
+    std::vector<int64_t> ticks;
+    ar & ticks;
+    order_book.bids = FromTicks(ticks);
+    ar & ticks;
+    order_book.asks = FromTicks(ticks);
+  }
+
+  BOOST_SERIALIZATION_SPLIT_MEMBER()
+
+ private:
+  // Price and quantity of every level one after another
+  static std::vector<int64_t> ToTicks(const OrderBook::Items& items);
+  static OrderBook::Items FromTicks(const std::vector<int64_t>& ticks);
+};
+
 struct Trade {
-  DoubleType price;
-  DoubleType quantity;
+  FixedPoint price;
+  FixedPoint quantity;
   bool is_buyer_maker;
   uint64_t trade_timestamp;        // ms
   uint64_t event_timestamp;        // ms
@@ -100,6 +192,10 @@ struct Trade {
 bool operator==(const Trade& a, const Trade& b) noexcept;
 bool operator==(const OrderBook& a, const OrderBook& b) noexcept;
 bool operator==(const OrderBook::Item& a, const OrderBook::Item& b) noexcept;
+bool operator==(const BestBidOffer& a, const BestBidOffer& b) noexcept;
+bool operator==(const OrderBookDepth& a, const OrderBookDepth& b) noexcept;
+bool operator==(const OrderBookResyncMarker& a, const OrderBookResyncMarker& b) noexcept;
+bool operator==(const OrderBookState& a, const OrderBookState& b) noexcept;
 
 }  // namespace types
 }  // namespace market_stream
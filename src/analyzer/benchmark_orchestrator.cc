@@ -7,6 +7,7 @@
 #include <sstream>
 
 #include "analyzer/observable_units.h"
+#include "events/inline_event_loop.h"
 #include "market_stream/saved_market_stream_forwarder.h"
 #include "utils/time/global_clock.h"
 #include "utils/time/mock_time_provider.h"
@@ -15,10 +16,12 @@ namespace analyzer {
 
 BenchmarkOrchestrator::BenchmarkOrchestrator(
     const std::shared_ptr<market_stream::SavedMarketStreamForwarder> &stream_forwarder,
-    bool enable_ts_jump)
+    bool enable_ts_jump,
+    const std::shared_ptr<events::InlineEventLoop> &inline_event_loop)
     : is_stopped_(false),
       is_enabled_ts_jump_(enable_ts_jump),
-      stream_forwarder_(stream_forwarder) {
+      stream_forwarder_(stream_forwarder),
+      inline_event_loop_(inline_event_loop) {
   ObservableUnits::Instance().SubscribeToAllUnitsReady(
       std::bind(&BenchmarkOrchestrator::OnAllUnitsReady, this));
 }
@@ -41,13 +44,13 @@ void BenchmarkOrchestrator::Go() {
       utils::GlobalClock::Instance().SetTimeProvider(mock_time_provider_);
     }
 
+    if (nullptr != inline_event_loop_) {
+      RunTimedEvents(next_data_ts);
+    }
+
     spdlog::debug("current ts: {}, next data ts: {}",
                   utils::GlobalClock::Instance().Now(), next_data_ts);
-    if (is_enabled_ts_jump_ && ObservableUnits::Instance().GetBusyUnits().empty()) {
-      mock_time_provider_->JumpToTime(next_data_ts);
-    } else {
-      utils::GlobalClock::Instance().WaitUntil(next_data_ts);
-    }
+    MoveClockTo(next_data_ts);
 
     if (is_stopped_) {
       break;
@@ -61,12 +64,35 @@ void BenchmarkOrchestrator::Go() {
     }
 
     stream_forwarder_->ForwardNext();
+
+    if (nullptr != inline_event_loop_) {
+      inline_event_loop_->RunUntilIdle();
+    }
   }
   spdlog::warn("BenchmarkOrchestrator run finished");
 }
 
 void BenchmarkOrchestrator::Stop() { is_stopped_ = true; }
 
+void BenchmarkOrchestrator::MoveClockTo(utils::Timestamp ts) {
+  if (is_enabled_ts_jump_ && ObservableUnits::Instance().GetBusyUnits().empty()) {
+    mock_time_provider_->JumpToTime(ts);
+  } else {
+    utils::GlobalClock::Instance().WaitUntil(ts);
+  }
+}
+
+void BenchmarkOrchestrator::RunTimedEvents(utils::Timestamp next_data_ts) {
+  for (auto ts = inline_event_loop_->NextTimedEventTs();
+       ts && *ts <= next_data_ts && !is_stopped_;
+       ts = inline_event_loop_->NextTimedEventTs()) {
+    if (utils::GlobalClock::Instance().Now() < *ts) {
+      MoveClockTo(*ts);
+    }
+    inline_event_loop_->RunTimedEvents(*ts);
+  }
+}
+
 void BenchmarkOrchestrator::OnAllUnitsReady() {
   spdlog::info("OnAllUnitsReady");
   if (is_enabled_ts_jump_ && nullptr != mock_time_provider_) {
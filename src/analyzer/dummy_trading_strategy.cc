@@ -24,11 +24,11 @@ void DummyTradingStrategy::OrderBookUpdate(
 }
 void DummyTradingStrategy::DummyMethod(utils::Timestamp received_timestamp) {
   if (received_timestamp % 587 == 0 && last_sent_r_ts_ != received_timestamp) {
-    const auto order_book = order_book_snap_provider_->GetSnapshot(received_timestamp);
+    const auto snapshot = order_book_snap_provider_->GetSnapshot(received_timestamp);
     types::OrderPlanInfo order_plan;
-    order_plan.max_buy_price = order_book.bids.front().price;
+    order_plan.max_buy_price = snapshot->order_book().bids.front().price.ToDecimal();
     order_plan.quantity = 1;  // not used
-    order_plan.min_sell_price = order_book.bids.front().price * 1.0016;
+    order_plan.min_sell_price = order_plan.max_buy_price * 1.0016;
     order_plan.expiration_ts = received_timestamp + 60000;
     order_plan.expiration_buy_ts = received_timestamp + 10000;
     order_plan.expiration_sell_ts = received_timestamp + 60000;
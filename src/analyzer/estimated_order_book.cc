@@ -0,0 +1,120 @@
+#include "analyzer/estimated_order_book.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace analyzer {
+
+namespace {
+// About a minute of trades of a busy symbol
+const std::size_t gMaxTradesCount = 100000;
+
+// Removes the levels a trade at price went through and its quantity from the
+// level at price. is_better is true for prices better than the trade one.
+template <typename IsBetter>
+void ConsumeLevels(market_stream::types::OrderBook::Items *levels,
+                   market_stream::types::FixedPoint price,
+                   market_stream::types::FixedPoint quantity, IsBetter is_better) {
+  auto it = levels->begin();
+  while (levels->end() != it && is_better(it->price, price)) {
+    it++;
+  }
+  if (levels->end() != it && it->price == price) {
+    it->quantity -= quantity;
+    if (it->quantity <= market_stream::types::FixedPoint()) {
+      it++;
+    }
+  }
+  levels->erase(levels->begin(), it);
+}
+}  // namespace
+
+EstimatedOrderBook::EstimatedOrderBook(
+    const std::weak_ptr<MQMSEventHubHandler> &event_handler,
+    const std::shared_ptr<OrderBookSnapshotProvider> &snapshot_provider,
+    std::size_t levels_count)
+    : snapshot_provider_(snapshot_provider), levels_count_(levels_count) {
+  SUBSCRIBE_TO_EVENTS(event_handler, &EstimatedOrderBook::OnMarketStreamEvent,
+                      MQMarketStream::Event::kNewTradeEvent);
+}
+
+market_stream::types::OrderBookDepth EstimatedOrderBook::GetDepth() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Reconcile_locked(snapshot_provider_->GetSnapshot());
+  return depth_;
+}
+
+market_stream::types::BestBidOffer EstimatedOrderBook::GetBestBidOffer() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Reconcile_locked(snapshot_provider_->GetSnapshot());
+  market_stream::types::BestBidOffer best_bid_offer;
+  best_bid_offer.timestamp = depth_.timestamp;
+  best_bid_offer.received_timestamp = depth_.received_timestamp;
+  if (!depth_.bids.empty()) {
+    best_bid_offer.bid = depth_.bids.front();
+  }
+  if (!depth_.asks.empty()) {
+    best_bid_offer.ask = depth_.asks.front();
+  }
+  return best_bid_offer;
+}
+
+void EstimatedOrderBook::OnMarketStreamEvent(MQMarketStream::Event event,
+                                             const void *data) {
+  if (MQMarketStream::Event::kNewTradeEvent != event) {
+    return;
+  }
+  const auto &trade = *static_cast<const market_stream::types::Trade *>(data);
+  std::lock_guard<std::mutex> lock(mutex_);
+  // GetSnapshot would merge the diffs and copy the book on every trade, the
+  // estimate is brought up to date by the readers
+  Reconcile_locked(snapshot_provider_->GetBuiltSnapshot());
+  if (trade.trade_timestamp <= snapshot_timestamp_) {
+    // Already in the snapshot
+    return;
+  }
+  if (trades_.size() == gMaxTradesCount) {
+    trades_.pop_front();
+  }
+  trades_.push_back(trade);
+  ApplyTrade_locked(trade);
+}
+
+void EstimatedOrderBook::Reconcile_locked(const OrderBookSnapshotPtr &snapshot) {
+  if (snapshot->version() <= snapshot_version_) {
+    return;
+  }
+  snapshot_version_ = snapshot->version();
+  const auto &order_book = snapshot->order_book();
+  snapshot_timestamp_ = order_book.timestamp;
+  depth_.timestamp = order_book.timestamp;
+  depth_.received_timestamp = order_book.received_timestamp;
+  depth_.bids.assign(order_book.bids.begin(),
+                     order_book.bids.begin() +
+                         std::min(levels_count_, order_book.bids.size()));
+  depth_.asks.assign(order_book.asks.begin(),
+                     order_book.asks.begin() +
+                         std::min(levels_count_, order_book.asks.size()));
+
+  while (!trades_.empty() && trades_.front().trade_timestamp <= snapshot_timestamp_) {
+    trades_.pop_front();
+  }
+  for (const auto &it : trades_) {
+    ApplyTrade_locked(it);
+  }
+}
+
+void EstimatedOrderBook::ApplyTrade_locked(const market_stream::types::Trade &trade) {
+  // A buyer maker trade is a sell market order, it takes the bids
+  if (trade.is_buyer_maker) {
+    ConsumeLevels(&depth_.bids, trade.price, trade.quantity,
+                  std::greater<market_stream::types::FixedPoint>());
+  } else {
+    ConsumeLevels(&depth_.asks, trade.price, trade.quantity,
+                  std::less<market_stream::types::FixedPoint>());
+  }
+  depth_.timestamp = trade.trade_timestamp;
+  depth_.received_timestamp = trade.received_timestamp;
+}
+
+}  // namespace analyzer
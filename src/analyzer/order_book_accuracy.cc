@@ -0,0 +1,117 @@
+#include "analyzer/order_book_accuracy.h"
+
+#include <cmath>
+#include <nlohmann/json.hpp>
+
+namespace analyzer {
+
+namespace {
+using market_stream::types::FixedPoint;
+using market_stream::types::OrderBookLevels;
+
+bool IsBetter(FixedPoint level_price, FixedPoint price, bool is_increasing) {
+  return is_increasing ? level_price < price : level_price > price;
+}
+
+nlohmann::json SideToJson(const OrderBookAccuracy::SideBuckets &buckets) {
+  auto result = nlohmann::json::array();
+  for (const auto &bucket : buckets) {
+    nlohmann::json bucket_json = {
+        {"levels_count", bucket.levels_count},
+        {"price_mismatches", bucket.price_mismatches},
+        {"quantity_mismatches", bucket.quantity_mismatches},
+        {"first_mismatch_level", nullptr},
+        {"similarity", nullptr},
+    };
+    if (bucket.first_mismatch_level) {
+      bucket_json["first_mismatch_level"] = *bucket.first_mismatch_level;
+    }
+    if (bucket.similarity) {
+      bucket_json["similarity"] = *bucket.similarity;
+    }
+    result.push_back(std::move(bucket_json));
+  }
+  return result;
+}
+}  // namespace
+
+void OrderBookAccuracy::Compare(const OrderBookLevels &local,
+                                const OrderBookLevels &reference, SideBuckets *result) {
+  const bool is_increasing = reference.is_increasing();
+  // Running over the levels compared so far, copied out at each bucket boundary
+  OrderBookSideAccuracy running;
+  // Quantities are compared as raw ticks, the scale cancels out
+  double local_reference = 0.0;
+  double local_local = 0.0;
+  double reference_reference = 0.0;
+  auto mismatch = [&running](std::size_t level) {
+    ++running.price_mismatches;
+    if (!running.first_mismatch_level) {
+      running.first_mismatch_level = level;
+    }
+  };
+  auto store = [&](std::size_t bucket) {
+    (*result)[bucket] = running;
+    if (0.0 != local_local && 0.0 != reference_reference) {
+      (*result)[bucket].similarity =
+          local_reference / (std::sqrt(local_local) * std::sqrt(reference_reference));
+    }
+  };
+
+  std::size_t bucket = 0;
+  std::size_t j = 0;
+  for (std::size_t i = 0; i < reference.size() && bucket < kBucketsCount; i++) {
+    const FixedPoint price = reference.price(i);
+    while (j < local.size() && IsBetter(local.price(j), price, is_increasing)) {
+      mismatch(i);
+      ++j;
+    }
+    const FixedPoint reference_quantity = reference.quantity(i);
+    const auto reference_ticks = static_cast<double>(reference_quantity.ticks());
+    reference_reference += reference_ticks * reference_ticks;
+    if (j < local.size() && local.price(j) == price) {
+      const FixedPoint local_quantity = local.quantity(j);
+      const auto local_ticks = static_cast<double>(local_quantity.ticks());
+      local_reference += local_ticks * reference_ticks;
+      local_local += local_ticks * local_ticks;
+      if (local_quantity != reference_quantity) {
+        ++running.quantity_mismatches;
+        if (!running.first_mismatch_level) {
+          running.first_mismatch_level = i;
+        }
+      }
+      ++j;
+    } else {
+      mismatch(i);
+    }
+    running.levels_count = i + 1;
+    for (; bucket < kBucketsCount && kLevelsCounts[bucket] == i + 1; ++bucket) {
+      store(bucket);
+    }
+  }
+  // The reference is thinner than the remaining buckets
+  for (; bucket < kBucketsCount; ++bucket) {
+    store(bucket);
+  }
+}
+
+OrderBookAccuracy OrderBookAccuracy::Compare(
+    const market_stream::types::OrderBookColumns &local,
+    const market_stream::types::OrderBookColumns &reference) {
+  OrderBookAccuracy result;
+  result.timestamp = local.timestamp;
+  Compare(local.bids, reference.bids, &result.bids);
+  Compare(local.asks, reference.asks, &result.asks);
+  return result;
+}
+
+std::string OrderBookAccuracy::ToJson() const {
+  const nlohmann::json result = {
+      {"timestamp", timestamp},
+      {"bids", SideToJson(bids)},
+      {"asks", SideToJson(asks)},
+  };
+  return result.dump();
+}
+
+}  // namespace analyzer
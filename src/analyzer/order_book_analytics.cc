@@ -0,0 +1,96 @@
+#include "analyzer/order_book_analytics.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace analyzer {
+
+namespace {
+OrderBookSideTotals CalculateTotals(
+    const market_stream::types::OrderBook::Items &levels) {
+  OrderBookSideTotals totals;
+  totals.reserve(levels.size());
+  OrderBookLevelTotals level_totals;
+  for (const auto &it : levels) {
+    const double quantity = it.quantity.ToDouble();
+    level_totals.quantity += quantity;
+    level_totals.notional += it.price.ToDouble() * quantity;
+    totals.push_back(level_totals);
+  }
+  return totals;
+}
+}  // namespace
+
+OrderBookSideAnalytics::OrderBookSideAnalytics(const Items *levels,
+                                               OrderBookSideTotals &&totals)
+    : levels_(levels), totals_(std::move(totals)) {
+  assert(levels_->size() == totals_.size());
+}
+
+OrderBookSideAnalytics::OrderBookSideAnalytics(const Items *levels)
+    : OrderBookSideAnalytics(levels, CalculateTotals(*levels)) {}
+
+double OrderBookSideAnalytics::Depth(std::size_t levels_count) const {
+  levels_count = std::min(levels_count, size());
+  return 0 == levels_count ? 0.0 : totals_[levels_count - 1].quantity;
+}
+
+std::optional<double> OrderBookSideAnalytics::CostToFill(double quantity) const {
+  // First level at which the depth reaches quantity
+  const auto it = std::lower_bound(
+      totals_.begin(), totals_.end(), quantity,
+      [](const OrderBookLevelTotals &level_totals, double quantity) {
+        return level_totals.quantity < quantity;
+      });
+  if (totals_.end() == it) {
+    return std::nullopt;
+  }
+  const std::size_t level = it - totals_.begin();
+  OrderBookLevelTotals better_levels;
+  if (0 != level) {
+    better_levels = totals_[level - 1];
+  }
+  const double rest = quantity - better_levels.quantity;
+  return better_levels.notional + (*levels_)[level].price.ToDouble() * rest;
+}
+
+std::optional<double> OrderBookSideAnalytics::AveragePriceToFill(double quantity) const {
+  const auto cost = CostToFill(quantity);
+  if (!cost || quantity <= 0) {
+    return std::nullopt;
+  }
+  return *cost / quantity;
+}
+
+OrderBookAnalytics::OrderBookAnalytics(const market_stream::types::OrderBook *order_book,
+                                       OrderBookSideTotals &&bids_totals,
+                                       OrderBookSideTotals &&asks_totals)
+    : order_book_(order_book),
+      bids_(&order_book->bids, std::move(bids_totals)),
+      asks_(&order_book->asks, std::move(asks_totals)) {}
+
+OrderBookAnalytics::OrderBookAnalytics(const market_stream::types::OrderBook *order_book)
+    : order_book_(order_book), bids_(&order_book->bids), asks_(&order_book->asks) {}
+
+std::optional<double> OrderBookAnalytics::Imbalance(std::size_t levels_count) const {
+  const double bids_depth = bids_.Depth(levels_count);
+  const double asks_depth = asks_.Depth(levels_count);
+  if (0 == bids_depth + asks_depth) {
+    return std::nullopt;
+  }
+  return (bids_depth - asks_depth) / (bids_depth + asks_depth);
+}
+
+std::optional<double> OrderBookAnalytics::Microprice() const {
+  if (order_book_->bids.empty() || order_book_->asks.empty()) {
+    return std::nullopt;
+  }
+  const auto &bid = order_book_->bids.front();
+  const auto &ask = order_book_->asks.front();
+  const double bid_quantity = bid.quantity.ToDouble();
+  const double ask_quantity = ask.quantity.ToDouble();
+  return (bid.price.ToDouble() * ask_quantity + ask.price.ToDouble() * bid_quantity) /
+         (bid_quantity + ask_quantity);
+}
+
+}  // namespace analyzer
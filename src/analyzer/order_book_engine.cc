@@ -0,0 +1,77 @@
+#include "analyzer/order_book_engine.h"
+
+namespace analyzer {
+
+void OrderBookSideLevels::CopyTo(Items *items, std::size_t levels_count) const {
+  items->clear();
+  items->reserve(std::min(levels_count, size_));
+  for (auto it = chunks_.begin(); chunks_.end() != it && items->size() < levels_count;
+       ++it) {
+    const auto &levels = (*it)->levels;
+    const std::size_t count = std::min(levels_count - items->size(), levels.size());
+    items->insert(items->end(), levels.begin(), levels.begin() + count);
+  }
+}
+
+void OrderBookSideLevels::CopyTotalsTo(OrderBookSideTotals *totals) const {
+  totals->clear();
+  totals->reserve(size_);
+  for (const auto &chunk : chunks_) {
+    OrderBookLevelTotals better_chunks_totals;
+    if (!totals->empty()) {
+      better_chunks_totals = totals->back();
+    }
+    for (const auto &it : chunk->totals) {
+      totals->push_back({better_chunks_totals.quantity + it.quantity,
+                         better_chunks_totals.notional + it.notional});
+    }
+  }
+}
+
+void OrderBookLevels::CopyTo(market_stream::types::OrderBook *order_book) const {
+  order_book->timestamp = timestamp;
+  order_book->received_timestamp = received_timestamp;
+  bids.CopyTo(&order_book->bids);
+  asks.CopyTo(&order_book->asks);
+}
+
+market_stream::types::OrderBook::Items MergeOrderBookItems(
+    const market_stream::types::OrderBook::Items &old_items,
+    const market_stream::types::OrderBook::Items &update,
+    bool is_items_order_increasing) {
+  market_stream::types::OrderBook::Items new_items;
+  new_items.reserve(old_items.size());
+
+  auto old_items_it = old_items.begin();
+  for (const auto &it : update) {
+    bool is_found_place_to_insert = false;
+    while (old_items_it < old_items.end()) {
+      is_found_place_to_insert = is_items_order_increasing
+                                     ? old_items_it->price > it.price
+                                     : old_items_it->price < it.price;
+      is_found_place_to_insert =
+          is_found_place_to_insert || old_items_it->price == it.price;
+      if (is_found_place_to_insert) {
+        if (!it.quantity.is_zero()) {
+          new_items.push_back(it);
+        }
+        if (old_items_it->price == it.price) {
+          ++old_items_it;
+        }
+        break;
+      } else {
+        new_items.push_back(*old_items_it);
+      }
+      ++old_items_it;
+    }
+    if (!is_found_place_to_insert) {
+      new_items.push_back(it);
+    }
+  }
+  for (; old_items_it < old_items.end(); ++old_items_it) {
+    new_items.push_back(*old_items_it);
+  }
+  return new_items;
+}
+
+}  // namespace analyzer
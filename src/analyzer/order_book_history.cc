@@ -0,0 +1,114 @@
+#include "analyzer/order_book_history.h"
+
+#include <algorithm>
+
+namespace analyzer {
+
+OrderBookHistory::OrderBookHistory(std::size_t max_levels,
+                                   std::size_t checkpoint_interval)
+    : max_levels_(max_levels), checkpoint_interval_(checkpoint_interval) {}
+
+void OrderBookHistory::set_duration(utils::TimestampPrecision duration) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  duration_ = duration;
+  if (0 == duration) {
+    segments_.clear();
+  }
+}
+
+void OrderBookHistory::Record(const market_stream::types::OrderBook &update,
+                              const OrderBookEngine &engine) {
+  if (0 == duration_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (segments_.empty() || segments_.back().diffs.size() >= checkpoint_interval_) {
+    StartSegment_locked(engine);
+  } else {
+    segments_.back().diffs.push_back(update);
+  }
+  DropOldSegments_locked();
+}
+
+void OrderBookHistory::RecordCheckpoint(const OrderBookEngine &engine) {
+  if (0 == duration_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  StartSegment_locked(engine);
+  DropOldSegments_locked();
+}
+
+void OrderBookHistory::StartSegment_locked(const OrderBookEngine &engine) {
+  segments_.emplace_back();
+  engine.CopyTo(&segments_.back().checkpoint);
+  segments_.back().diffs.reserve(checkpoint_interval_);
+}
+
+void OrderBookHistory::DropOldSegments_locked() {
+  const auto &newest = segments_.back();
+  const utils::Timestamp newest_ts = newest.diffs.empty()
+                                         ? newest.checkpoint.received_timestamp
+                                         : newest.diffs.back().received_timestamp;
+  const utils::TimestampPrecision duration = duration_;
+  if (newest_ts < duration) {
+    return;
+  }
+  // The first segment is needed until the next one covers the oldest kept ts
+  while (segments_.size() > 1 &&
+         segments_[1].checkpoint.received_timestamp <= newest_ts - duration) {
+    segments_.pop_front();
+  }
+}
+
+bool OrderBookHistory::Replay_locked(utils::Timestamp ts, OrderBookEngine *engine) const {
+  const auto it = std::upper_bound(segments_.begin(), segments_.end(), ts,
+                                   [](utils::Timestamp ts, const Segment &segment) {
+                                     return ts < segment.checkpoint.received_timestamp;
+                                   });
+  if (segments_.begin() == it) {
+    return false;
+  }
+  const auto &segment = *std::prev(it);
+  engine->Apply(segment.checkpoint);
+  for (const auto &diff : segment.diffs) {
+    if (diff.received_timestamp > ts) {
+      break;
+    }
+    engine->Apply(diff);
+  }
+  return true;
+}
+
+std::optional<market_stream::types::OrderBook> OrderBookHistory::GetSnapshotAt(
+    utils::Timestamp ts) const {
+  OrderBookEngine engine(max_levels_);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!Replay_locked(ts, &engine)) {
+      return std::nullopt;
+    }
+  }
+  market_stream::types::OrderBook order_book;
+  engine.CopyTo(&order_book);
+  return order_book;
+}
+
+std::optional<market_stream::types::OrderBookDepth> OrderBookHistory::GetTopNAt(
+    utils::Timestamp ts, std::size_t levels_count) const {
+  OrderBookEngine engine(max_levels_);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!Replay_locked(ts, &engine)) {
+      return std::nullopt;
+    }
+  }
+  market_stream::types::OrderBookDepth depth;
+  depth.timestamp = engine.timestamp();
+  depth.received_timestamp = engine.received_timestamp();
+  engine.bids().CopyTo(&depth.bids, levels_count);
+  engine.asks().CopyTo(&depth.asks, levels_count);
+  return depth;
+}
+
+}  // namespace analyzer
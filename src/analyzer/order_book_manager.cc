@@ -0,0 +1,167 @@
+#include "analyzer/order_book_manager.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <functional>
+
+#include "events/event_hub.h"
+
+namespace analyzer {
+
+OrderBookManager::OrderBookManager(const std::vector<std::string> &symbols,
+                                   const OrderBookManagerOptions &options) {
+  std::size_t shards_count = 0 != options.shards_count
+                                 ? options.shards_count
+                                 : std::max(1u, std::thread::hardware_concurrency());
+  shards_count = std::max<std::size_t>(1, std::min(shards_count, symbols.size()));
+  for (std::size_t i = 0; i < shards_count; i++) {
+    shards_.push_back(std::make_unique<Shard>());
+  }
+  for (const auto &symbol : symbols) {
+    if (0 != books_.count(symbol)) {
+      continue;
+    }
+    auto &shard = *shards_[std::hash<std::string>()(symbol) % shards_count];
+    shard.books.emplace_back(&shard, options.max_levels);
+    auto &book = shard.books.back();
+    book.snapshot =
+        std::make_shared<const OrderBookSnapshot>(0, market_stream::types::OrderBook());
+    books_.emplace(symbol, &book);
+  }
+  for (std::size_t i = 0; i < shards_count; i++) {
+    const int cpu = options.first_cpu >= 0 ? options.first_cpu + static_cast<int>(i) : -1;
+    shards_[i]->thread =
+        std::thread(&OrderBookManager::WorkerLoop, this, shards_[i].get(), cpu, i);
+  }
+  spdlog::info("OrderBookManager initialized: {} symbols, {} shards", books_.size(),
+               shards_count);
+}
+
+OrderBookManager::~OrderBookManager() { Shutdown(); }
+
+bool OrderBookManager::Apply(const std::string &symbol,
+                             market_stream::types::OrderBook &&update) {
+  Book *book = FindBook(symbol);
+  if (nullptr == book) {
+    return false;
+  }
+  auto &shard = *book->shard;
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.is_stopped) {
+      return false;
+    }
+    shard.updates.emplace_back(book, std::move(update));
+  }
+  shard.cv.notify_one();
+  return true;
+}
+
+OrderBookSnapshotPtr OrderBookManager::GetSnapshot(const std::string &symbol) {
+  Book *book = FindBook(symbol);
+  if (nullptr == book) {
+    return nullptr;
+  }
+  OrderBookLevels levels;
+  uint64_t version = 0;
+  {
+    std::lock_guard<std::mutex> lock(book->mutex);
+    if (book->snapshot->version() == book->version) {
+      return book->snapshot;
+    }
+    // Shares the chunks of the engine, so the worker is held only for this
+    levels = book->engine.levels();
+    version = book->version;
+  }
+
+  market_stream::types::OrderBook order_book;
+  levels.CopyTo(&order_book);
+  // Totals kept by the engine, the analytics do not calculate them again
+  OrderBookSideTotals bids_totals, asks_totals;
+  levels.bids.CopyTotalsTo(&bids_totals);
+  levels.asks.CopyTotalsTo(&asks_totals);
+  auto snapshot = std::make_shared<const OrderBookSnapshot>(
+      version, std::move(order_book), std::move(bids_totals), std::move(asks_totals));
+
+  std::lock_guard<std::mutex> lock(book->mutex);
+  // Readers may build snapshots at once, the newest one stays
+  if (book->snapshot->version() < version) {
+    book->snapshot = std::move(snapshot);
+  }
+  return book->snapshot;
+}
+
+std::optional<market_stream::types::BestBidOffer> OrderBookManager::GetBestBidOffer(
+    const std::string &symbol) {
+  Book *book = FindBook(symbol);
+  if (nullptr == book) {
+    return std::nullopt;
+  }
+  std::lock_guard<std::mutex> lock(book->mutex);
+  return book->best_bid_offer;
+}
+
+void OrderBookManager::Shutdown() {
+  for (auto &it : shards_) {
+    {
+      std::lock_guard<std::mutex> lock(it->mutex);
+      it->is_stopped = true;
+    }
+    it->cv.notify_one();
+  }
+  for (auto &it : shards_) {
+    if (it->thread.joinable()) {
+      it->thread.join();
+    }
+  }
+}
+
+void OrderBookManager::WorkerLoop(Shard *shard, int cpu, std::size_t shard_index) {
+  events::WorkerOptions worker_options;
+  worker_options.cpu = cpu;
+  worker_options.thread_name = "books." + std::to_string(shard_index);
+  events::SetupWorkerThread(worker_options);
+
+  std::deque<std::pair<Book *, market_stream::types::OrderBook>> updates;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(shard->mutex);
+      shard->cv.wait(lock,
+                     [shard]() { return shard->is_stopped || !shard->updates.empty(); });
+      if (shard->updates.empty()) {
+        return;
+      }
+      // Whole batch is taken at once, the producers are not held while applying
+      std::swap(updates, shard->updates);
+    }
+    for (const auto &it : updates) {
+      ApplyUpdate(it.first, it.second);
+    }
+    updates.clear();
+  }
+}
+
+void OrderBookManager::ApplyUpdate(Book *book,
+                                   const market_stream::types::OrderBook &update) {
+  std::lock_guard<std::mutex> lock(book->mutex);
+  book->engine.Apply(update);
+  book->version++;
+
+  auto &best_bid_offer = book->best_bid_offer;
+  best_bid_offer.timestamp = book->engine.timestamp();
+  best_bid_offer.received_timestamp = book->engine.received_timestamp();
+  best_bid_offer.bid = book->engine.bids().empty()
+                           ? market_stream::types::OrderBook::Item()
+                           : book->engine.bids().front();
+  best_bid_offer.ask = book->engine.asks().empty()
+                           ? market_stream::types::OrderBook::Item()
+                           : book->engine.asks().front();
+}
+
+OrderBookManager::Book *OrderBookManager::FindBook(const std::string &symbol) const {
+  const auto it = books_.find(symbol);
+  return books_.end() == it ? nullptr : it->second;
+}
+
+}  // namespace analyzer
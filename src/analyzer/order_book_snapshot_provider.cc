@@ -5,7 +5,6 @@
 #include <sstream>
 
 #include "analyzer/scoped_unit_state.h"
-#include "utils/helpers.h"
 #include "utils/time/global_clock.h"
 #include "utils/time/types.h"
 
@@ -14,23 +13,192 @@ namespace analyzer {
 namespace {
 const std::size_t gMaxOrderBookLevelsHandleCount = 6000;
 const utils::TimestampPrecision gSnapshotLifeTime = 100;
+const int gSnapshotSpinCount = 1000;
+const std::size_t gHistoryCheckpointInterval = 100;
 }  // namespace
 
+const market_stream::types::OrderBookColumns &OrderBookSnapshot::columns() const {
+  std::call_once(columns_once_, [this]() {
+    columns_ =
+        std::make_unique<const market_stream::types::OrderBookColumns>(order_book_);
+  });
+  return *columns_;
+}
+
 OrderBookSnapshotProvider::OrderBookSnapshotProvider(
     const std::weak_ptr<MQMSEventHubHandler> &event_handler,
     const std::weak_ptr<MQOSEventHubDispatcher> &dispatcher,
-    const std::shared_ptr<OrderBookSnapshotProviderUnitState> &unit_state)
-    : dispatcher_(dispatcher), unit_state_(unit_state) {
-  SUBSCRIBE_TO_EVENT(event_handler, &OrderBookSnapshotProvider::OnMarketStreamEvent);
+    const std::shared_ptr<OrderBookSnapshotProviderUnitState> &unit_state,
+    bool wait_for_update, OrderBookDiffMode diff_mode)
+    : engine_(gMaxOrderBookLevelsHandleCount),
+      diff_mode_(diff_mode),
+      history_(gMaxOrderBookLevelsHandleCount, gHistoryCheckpointInterval),
+      snapshot_(std::make_shared<const OrderBookSnapshot>(
+          0, market_stream::types::OrderBook())),
+      wait_for_update_(wait_for_update),
+      dispatcher_(dispatcher),
+      unit_state_(unit_state) {
+  SUBSCRIBE_TO_EVENTS(event_handler, &OrderBookSnapshotProvider::OnMarketStreamEvent,
+                      MQMarketStream::Event::kOrderBookUpdateEvent,
+                      MQMarketStream::Event::kOrderBookResyncEvent);
 }
 
-market_stream::types::OrderBook OrderBookSnapshotProvider::GetSnapshot(
+OrderBookSnapshotProvider::OrderBookSnapshotProvider(
+    const std::weak_ptr<MQOSEventHubHandler> &snapshot_handler,
+    const std::shared_ptr<OrderBookSnapshotProviderUnitState> &unit_state,
+    bool wait_for_update)
+    : engine_(gMaxOrderBookLevelsHandleCount),
+      diff_mode_(OrderBookDiffMode::kEager),
+      history_(gMaxOrderBookLevelsHandleCount, gHistoryCheckpointInterval),
+      snapshot_(std::make_shared<const OrderBookSnapshot>(
+          0, market_stream::types::OrderBook())),
+      wait_for_update_(wait_for_update),
+      unit_state_(unit_state) {
+  SUBSCRIBE_TO_LATEST_EVENTS(snapshot_handler,
+                             &OrderBookSnapshotProvider::OnOrderBookStreamEvent,
+                             MQOrderBookStream::Event::kNewSnapshotAvailable);
+}
+
+OrderBookSnapshotPtr OrderBookSnapshotProvider::GetSnapshot(
     utils::Timestamp last_update_ts) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  cv_.wait(lock, [this, last_update_ts]() {
-    return last_update_ts <= order_book_.received_timestamp;
+  return WaitForSnapshot([last_update_ts](const OrderBookSnapshot &snapshot) {
+    return last_update_ts <= snapshot.received_timestamp();
   });
-  return order_book_;
+}
+
+OrderBookSnapshotPtr OrderBookSnapshotProvider::GetNextSnapshot(uint64_t version) {
+  return WaitForSnapshot([version](const OrderBookSnapshot &snapshot) {
+    return version < snapshot.version();
+  });
+}
+
+OrderBookSnapshotPtr OrderBookSnapshotProvider::GetBuiltSnapshot() const {
+  return std::atomic_load(&snapshot_);
+}
+
+PublishedOrderBookPtr OrderBookSnapshotProvider::GetPublishedBook() {
+  MergePendingDiffs();
+  return std::atomic_load(&book_);
+}
+
+void OrderBookSnapshotProvider::RequestDepthLevels(std::size_t levels_count) {
+  std::size_t depth_levels = depth_levels_.load();
+  while (depth_levels < levels_count &&
+         !depth_levels_.compare_exchange_weak(depth_levels, levels_count)) {
+  }
+}
+
+void OrderBookSnapshotProvider::KeepHistory(std::chrono::seconds duration) {
+  history_.set_duration(
+      std::chrono::duration_cast<utils::ChronoTimestampPrecision>(duration).count());
+}
+
+std::optional<market_stream::types::OrderBook> OrderBookSnapshotProvider::GetSnapshotAt(
+    utils::Timestamp ts) {
+  // Buffered diffs may be older than ts
+  MergePendingDiffs();
+  return history_.GetSnapshotAt(ts);
+}
+
+std::optional<market_stream::types::OrderBookDepth> OrderBookSnapshotProvider::GetTopNAt(
+    utils::Timestamp ts, std::size_t levels_count) {
+  MergePendingDiffs();
+  return history_.GetTopNAt(ts, levels_count);
+}
+
+template <typename Predicate>
+OrderBookSnapshotPtr OrderBookSnapshotProvider::WaitForSnapshot(Predicate is_ready) {
+  auto snapshot = LoadSnapshot();
+  if (!wait_for_update_) {
+    return snapshot;
+  }
+  for (int i = 0; i < gSnapshotSpinCount && !is_ready(*snapshot); i++) {
+    snapshot = LoadSnapshot();
+  }
+  if (is_ready(*snapshot)) {
+    return snapshot;
+  }
+
+  parked_readers_.fetch_add(1);
+  // Diffs buffered before the writer saw the parked reader are merged here, the
+  // later ones are merged by the writer
+  snapshot = LoadSnapshot();
+  while (!is_ready(*snapshot)) {
+    {
+      std::unique_lock<std::mutex> lock(wait_mutex_);
+      cv_.wait(lock,
+               [this, &snapshot]() { return snapshot->version() < LatestVersion(); });
+    }
+    snapshot = LoadSnapshot();
+  }
+  parked_readers_.fetch_sub(1, std::memory_order_relaxed);
+  return snapshot;
+}
+
+void OrderBookSnapshotProvider::MergePendingDiffs() {
+  if (has_pending_diffs_.load()) {
+    std::lock_guard<std::mutex> lock(engine_mutex_);
+    ApplyPendingDiffs_locked();
+  }
+}
+
+OrderBookSnapshotPtr OrderBookSnapshotProvider::LoadSnapshot() {
+  MergePendingDiffs();
+  auto snapshot = std::atomic_load(&snapshot_);
+  auto book = std::atomic_load(&book_);
+  if (nullptr == book || book->version <= snapshot->version()) {
+    return snapshot;
+  }
+  std::lock_guard<std::mutex> lock(build_mutex_);
+  snapshot = std::atomic_load(&snapshot_);
+  book = std::atomic_load(&book_);
+  if (book->version <= snapshot->version()) {
+    return snapshot;
+  }
+  return BuildSnapshot(*book);
+}
+
+uint64_t OrderBookSnapshotProvider::LatestVersion() const {
+  const auto book = std::atomic_load(&book_);
+  return nullptr != book ? book->version : std::atomic_load(&snapshot_)->version();
+}
+
+OrderBookSnapshotPtr OrderBookSnapshotProvider::BuildSnapshot(
+    const PublishedOrderBook &book) {
+  market_stream::types::OrderBook order_book;
+  book.levels.CopyTo(&order_book);
+  // Totals kept by the engine, the analytics do not calculate them again
+  OrderBookSideTotals bids_totals, asks_totals;
+  book.levels.bids.CopyTotalsTo(&bids_totals);
+  book.levels.asks.CopyTotalsTo(&asks_totals);
+
+  assert(CheckItemsOrder(order_book.bids, false));
+  assert(CheckItemsOrder(order_book.asks, true));
+
+  return InstallSnapshot(std::make_shared<const OrderBookSnapshot>(
+      book.version, std::move(order_book), std::move(bids_totals),
+      std::move(asks_totals)));
+}
+
+OrderBookSnapshotPtr OrderBookSnapshotProvider::InstallSnapshot(
+    OrderBookSnapshotPtr snapshot) {
+  // The writer and a reader may build snapshots at once, the newest one stays
+  auto installed = std::atomic_load(&snapshot_);
+  while (installed->version() < snapshot->version()) {
+    if (std::atomic_compare_exchange_weak(&snapshot_, &installed, snapshot)) {
+      return snapshot;
+    }
+  }
+  return installed;
+}
+
+void OrderBookSnapshotProvider::WakeParkedReaders() {
+  // Pairs with the increment in WaitForSnapshot: either the reader sees the new
+  // version before parking or the writer sees the parked reader
+  if (parked_readers_.load() > 0) {
+    std::lock_guard<std::mutex> lock(wait_mutex_);
+    cv_.notify_all();
+  }
 }
 
 void OrderBookSnapshotProvider::OnMarketStreamEvent(MQMarketStream::Event event,
@@ -42,6 +210,33 @@ void OrderBookSnapshotProvider::OnMarketStreamEvent(MQMarketStream::Event event,
     auto order_book_update = static_cast<const market_stream::types::OrderBook *>(data);
     OnOrderBookUpdateEvent(*order_book_update);
 
+    if (nullptr != unit_state_) {
+      unit_state_->SetReady();
+    }
+  } else if (MQMarketStream::Event::kOrderBookResyncEvent == event) {
+    if (nullptr != unit_state_) {
+      unit_state_->SetBusy();
+    }
+    OnOrderBookResyncEvent(
+        *static_cast<const market_stream::types::OrderBookResync *>(data));
+
+    if (nullptr != unit_state_) {
+      unit_state_->SetReady();
+    }
+  }
+}
+
+void OrderBookSnapshotProvider::OnOrderBookStreamEvent(MQOrderBookStream::Event event,
+                                                       const void *data) {
+  if (MQOrderBookStream::Event::kNewSnapshotAvailable == event) {
+    if (nullptr != unit_state_) {
+      unit_state_->SetBusy();
+    }
+    InstallSnapshot(std::make_shared<const OrderBookSnapshot>(
+        ++version_, market_stream::types::OrderBook(
+                        *static_cast<const market_stream::types::OrderBook *>(data))));
+    WakeParkedReaders();
+
     if (nullptr != unit_state_) {
       unit_state_->SetReady();
     }
@@ -50,107 +245,158 @@ void OrderBookSnapshotProvider::OnMarketStreamEvent(MQMarketStream::Event event,
 
 void OrderBookSnapshotProvider::OnOrderBookUpdateEvent(
     market_stream::types::OrderBook update) {
-  std::lock_guard<std::mutex> lock(mutex_);
+  // Readers never touch the book in eager mode
+  if (OrderBookDiffMode::kLazy != diff_mode_) {
+    ApplyUpdate(update);
+    return;
+  }
+  std::lock_guard<std::mutex> lock(engine_mutex_);
+  BufferDiff_locked(update);
+  // A parked reader or an event subscriber reads the book right away
+  if (parked_readers_.load() > 0 || HasOrderBookStreamSubscribers()) {
+    ApplyPendingDiffs_locked();
+  }
+}
 
-  // PrepareItems(&(update.bids), false);
-  // PrepareItems(&(update.asks), true);
+void OrderBookSnapshotProvider::OnOrderBookResyncEvent(
+    const market_stream::types::OrderBookResync &resync) {
+  OrderBookEngine engine(gMaxOrderBookLevelsHandleCount);
+  engine.Apply(resync.order_book);
 
-  order_book_.timestamp = update.timestamp;
-  order_book_.received_timestamp = update.received_timestamp;
-  order_book_.bids = UpdateOrderBookItems(order_book_.bids, update.bids, false);
-  order_book_.asks = UpdateOrderBookItems(order_book_.asks, update.asks, true);
-  order_book_.bids.resize(
-      std::min(gMaxOrderBookLevelsHandleCount, order_book_.bids.size()));
-  order_book_.asks.resize(
-      std::min(gMaxOrderBookLevelsHandleCount, order_book_.asks.size()));
+  std::lock_guard<std::mutex> lock(engine_mutex_);
+  // Buffered diffs are older than the fetched book
+  pending_bids_.clear();
+  pending_asks_.clear();
+  has_pending_diffs_.store(false);
+  engine_.Swap(&engine);
+  history_.RecordCheckpoint(engine_);
+  PublishBook();
 
-  assert(CheckItemsOrder(order_book_.bids, false));
-  assert(CheckItemsOrder(order_book_.asks, true));
+  auto dispatcher_lock = dispatcher_.lock();
+  if (dispatcher_lock) {
+    market_stream::types::OrderBookResyncMarker marker;
+    marker.timestamp = engine_.timestamp();
+    marker.received_timestamp = engine_.received_timestamp();
+    dispatcher_lock->DispatchEvent<MQOrderBookStream::Event::kOrderBookResynced>(marker);
+  }
+}
 
-  cv_.notify_all();
+void OrderBookSnapshotProvider::BufferDiff_locked(
+    const market_stream::types::OrderBook &update) {
+  pending_update_.timestamp = update.timestamp;
+  pending_update_.received_timestamp = update.received_timestamp;
+  for (const auto &it : update.bids) {
+    pending_bids_[it.price] = it.quantity;
+  }
+  for (const auto &it : update.asks) {
+    pending_asks_[it.price] = it.quantity;
+  }
+  has_pending_diffs_.store(true);
+}
+
+void OrderBookSnapshotProvider::ApplyPendingDiffs_locked() {
+  if (!has_pending_diffs_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  // Maps are ordered best price first, so the merged diff is a valid update.
+  // Depth is bounded once for all the buffered diffs, levels dropped by an
+  // earlier diff in eager mode may stay behind the last kept one.
+  pending_update_.bids.clear();
+  pending_update_.asks.clear();
+  for (const auto &it : pending_bids_) {
+    pending_update_.bids.emplace_back(it.first, it.second);
+  }
+  for (const auto &it : pending_asks_) {
+    pending_update_.asks.emplace_back(it.first, it.second);
+  }
+  pending_bids_.clear();
+  pending_asks_.clear();
+  has_pending_diffs_.store(false);
+  ApplyUpdate(pending_update_);
+}
+
+bool OrderBookSnapshotProvider::HasOrderBookStreamSubscribers() const {
+  auto dispatcher_lock = dispatcher_.lock();
+  if (!dispatcher_lock) {
+    return false;
+  }
+  using Event = MQOrderBookStream::Event;
+  return dispatcher_lock->HasSubscribers(Event::kNewSnapshotAvailable) ||
+         dispatcher_lock->HasSubscribers(Event::kBestBidOfferChanged) ||
+         (0 != depth_levels_.load(std::memory_order_relaxed) &&
+          dispatcher_lock->HasSubscribers(Event::kDepthChanged));
+}
+
+void OrderBookSnapshotProvider::ApplyUpdate(
+    const market_stream::types::OrderBook &update) {
+  engine_.Apply(update);
+  history_.Record(update, engine_);
+  PublishBook();
+}
+
+void OrderBookSnapshotProvider::PublishBook() {
+  const auto book = std::make_shared<const PublishedOrderBook>(
+      PublishedOrderBook{++version_, engine_.levels()});
+  std::atomic_store(&book_, book);
   auto dispatcher_lock = dispatcher_.lock();
+  if (dispatcher_lock &&
+      dispatcher_lock->HasSubscribers(MQOrderBookStream::Event::kNewSnapshotAvailable)) {
+    const auto snapshot = BuildSnapshot(*book);
+    // Subscribers share the book of the snapshot, it is not copied per queue
+    dispatcher_lock->DispatchSharedEvent<MQOrderBookStream::Event::kNewSnapshotAvailable>(
+        std::shared_ptr<const market_stream::types::OrderBook>(snapshot,
+                                                               &snapshot->order_book()));
+  }
+  // Parked readers build the snapshot themselves unless it was built above
+  WakeParkedReaders();
   if (dispatcher_lock) {
-    dispatcher_lock->DispatchEvent<MQOrderBookStream::Event::kNewSnapshotAvailable>(
-        order_book_);
-  }
-}
-
-void OrderBookSnapshotProvider::PrepareItems(
-    market_stream::types::OrderBook::Items *items, bool is_items_order_increasing) {
-  using Item = market_stream::types::OrderBook::Item;
-  std::sort(items->begin(), items->end(),
-            [is_items_order_increasing](const Item &l, const Item &r) {
-              return is_items_order_increasing ? l.price < r.price : l.price > r.price;
-            });
-
-  market_stream::types::OrderBook::Items new_items;
-  new_items.reserve(items->size());
-  for (int i = 0; i < static_cast<int>(items->size()); i++) {
-    new_items.push_back((*items)[i]);
-    if (i > 0 && (*items)[i - 1].price == new_items.back().price) {
-      if ((*items)[i - 1].quantity != new_items.back().quantity) {
-        spdlog::error("Failed pairs: {}, {}, failed q-s: {}, {}", (*items)[i].price.str(),
-                      (*items)[i - 1].price.str(), (*items)[i].quantity.str(),
-                      (*items)[i - 1].quantity.str());
-        assert(false);
-      }
-      new_items.pop_back();
-    }
+    DispatchBestBidOffer(dispatcher_lock.get());
+    DispatchDepth(dispatcher_lock.get());
   }
-  *items = std::move(new_items);
-}
-
-market_stream::types::OrderBook::Items OrderBookSnapshotProvider::UpdateOrderBookItems(
-    const market_stream::types::OrderBook::Items &old_items,
-    const market_stream::types::OrderBook::Items &update,
-    bool is_items_order_increasing) {
-  market_stream::types::OrderBook::Items new_items;
-  new_items.reserve(old_items.size());
-
-  auto old_items_it = old_items.begin();
-  for (const auto &it : update) {
-    bool is_found_place_to_insert = false;
-    while (old_items_it < old_items.end()) {
-      is_found_place_to_insert = is_items_order_increasing
-                                     ? old_items_it->price > it.price
-                                     : old_items_it->price < it.price;
-      is_found_place_to_insert = is_found_place_to_insert ||
-                                 utils::IsDoublesEqual(old_items_it->price, it.price);
-      if (is_found_place_to_insert) {
-        if (!utils::IsDoublesEqual(it.quantity, 0)) {
-          new_items.push_back(it);
-        }
-        if (utils::IsDoublesEqual(old_items_it->price, it.price)) {
-          ++old_items_it;
-        }
-        break;
-      } else {
-        new_items.push_back(*old_items_it);
-      }
-      ++old_items_it;
-    }
-    if (!is_found_place_to_insert) {
-      new_items.push_back(it);
-    }
+}
+
+void OrderBookSnapshotProvider::DispatchBestBidOffer(MQOSEventHubDispatcher *dispatcher) {
+  const market_stream::types::OrderBook::Item empty_side;
+  const auto &bid = engine_.bids().empty() ? empty_side : engine_.bids().front();
+  const auto &ask = engine_.asks().empty() ? empty_side : engine_.asks().front();
+  if (bid == best_bid_offer_.bid && ask == best_bid_offer_.ask) {
+    return;
+  }
+  best_bid_offer_.timestamp = engine_.timestamp();
+  best_bid_offer_.received_timestamp = engine_.received_timestamp();
+  best_bid_offer_.bid = bid;
+  best_bid_offer_.ask = ask;
+  dispatcher->DispatchEvent<MQOrderBookStream::Event::kBestBidOfferChanged>(
+      best_bid_offer_);
+}
+
+void OrderBookSnapshotProvider::DispatchDepth(MQOSEventHubDispatcher *dispatcher) {
+  const std::size_t depth_levels = depth_levels_.load(std::memory_order_relaxed);
+  if (0 == depth_levels) {
+    return;
   }
-  for (; old_items_it < old_items.end(); ++old_items_it) {
-    new_items.push_back(*old_items_it);
+  market_stream::types::OrderBookDepth depth;
+  engine_.bids().CopyTo(&depth.bids, depth_levels);
+  engine_.asks().CopyTo(&depth.asks, depth_levels);
+  if (depth.bids == depth_.bids && depth.asks == depth_.asks) {
+    return;
   }
-  return new_items;
+  depth.timestamp = engine_.timestamp();
+  depth.received_timestamp = engine_.received_timestamp();
+  depth_ = std::move(depth);
+  dispatcher->DispatchEvent<MQOrderBookStream::Event::kDepthChanged>(depth_);
 }
 
 bool OrderBookSnapshotProvider::CheckItemsOrder(
     const market_stream::types::OrderBook::Items &items, bool is_items_order_increasing) {
   for (int i = 0; i < static_cast<int>(items.size()) - 1; i++) {
-    bool is_pass = is_items_order_increasing ? items[i].price < items[i + 1].price
-                                             : items[i].price > items[i + 1].price;
-    is_pass = is_pass && !utils::IsDoublesEqual(items[i].price, items[i + 1].price);
+    const bool is_pass = is_items_order_increasing ? items[i].price < items[i + 1].price
+                                                   : items[i].price > items[i + 1].price;
     if (!is_pass) {
       std::stringstream ss;
       ss << items;
-      spdlog::error("Failed pairs: {}, {}, failed q-s: {}, {}", items[i].price.str(),
-                    items[i + 1].price.str(), items[i].quantity.str(),
-                    items[i + 1].quantity.str());
+      spdlog::error("Failed pairs: {}, {}, failed q-s: {}, {}", items[i].price,
+                    items[i + 1].price, items[i].quantity, items[i + 1].quantity);
       return false;
     }
   }
@@ -3,6 +3,7 @@
 #include "analyzer/benchmark_data_collector.h"
 #include "analyzer/order_manager.h"
 #include "analyzer/scoped_unit_state.h"
+#include "events/inline_event_loop.h"
 #include "utils/time/elapsed_time_meter.h"
 #include "utils/time/global_clock.h"
 
@@ -16,19 +17,25 @@ OrderPlanManager::OrderPlanManager(
     const std::weak_ptr<EventHubHandler> &event_handler,
     const std::shared_ptr<OrderManager> &order_manager,
     const std::shared_ptr<OrderPlanManagerUnitState> &unit_state,
-    const std::shared_ptr<BenchmarkDataCollector> &benchmark_data_collector)
+    const std::shared_ptr<BenchmarkDataCollector> &benchmark_data_collector,
+    const std::shared_ptr<events::InlineEventLoop> &inline_event_loop)
     : order_manager_(order_manager),
       unit_state_(unit_state),
-      benchmark_data_collector_(benchmark_data_collector) {
+      benchmark_data_collector_(benchmark_data_collector),
+      inline_event_loop_(inline_event_loop) {
   SUBSCRIBE_TO_EVENT(event_handler, &OrderPlanManager::OnOrderPlanStreamEvent);
-  order_plans_processing_thread_ =
-      std::thread(&OrderPlanManager::OrderPlansProcessThread, this);
+  if (nullptr == inline_event_loop_) {
+    order_plans_processing_thread_ =
+        std::thread(&OrderPlanManager::OrderPlansProcessThread, this);
+  }
 }
 
 OrderPlanManager::~OrderPlanManager() {
   is_stopped_ = true;
   cv_.notify_one();
-  order_plans_processing_thread_.detach();
+  if (order_plans_processing_thread_.joinable()) {
+    order_plans_processing_thread_.detach();
+  }
 }
 
 void OrderPlanManager::OnOrderPlanStreamEvent(MQ::Event event, const void *data) {
@@ -41,73 +48,100 @@ void OrderPlanManager::OnOrderPlanStreamEvent(MQ::Event event, const void *data)
   spdlog::info("New order plan recieved");
   if (order_plan_info_ == nullptr) {
     order_plan_info_ = std::make_shared<types::OrderPlanInfo>(*order_plan);
-    cv_.notify_one();
+    if (nullptr != inline_event_loop_) {
+      StartOrderPlanInline();
+    } else {
+      cv_.notify_one();
+    }
   } else {
     spdlog::warn("Drop order plan due to another in process");
   }
 }
 
-void OrderPlanManager::ProcessOrderPlan(types::OrderPlanInfo order_plan) {
-  ScopedUnitState<ObservableUnits::UnitId::kOrderPlanManager> scoped_state(unit_state_);
-
-  const auto order_plan_start_time = utils::GlobalClock::Instance().Now();
-  utils::ElapsedTimeMeter elapsed_time_meter;
+bool OrderPlanManager::StartOrderPlan() {
+  const auto &order_plan = *order_plan_info_;
+  order_plan_start_time_ = utils::GlobalClock::Instance().Now();
+  order_plan_elapsed_time_meter_ = utils::ElapsedTimeMeter();
 
   // If order plan expired
-  if (order_plan.expiration_ts <= order_plan_start_time) {
+  if (order_plan.expiration_ts <= order_plan_start_time_) {
     spdlog::warn("Order plan has expired");
-    SendReport(0, 0, order_plan_start_time, elapsed_time_meter.elapsed_time().count(),
-               types::OrderPlanReport::Status::kPlanExpired);
-    return;
+    SendReport(0, 0, types::OrderPlanReport::Status::kPlanExpired);
+    FinishOrderPlan();
+    return false;
   }
 
   spdlog::info("Starting processing...");
 
   types::OrderInfo buy_order;
-  types::OrderResult buy_order_result;
   buy_order.price = order_plan.max_buy_price;
   buy_order.side = types::OrderInfo::Side::BUY;
   buy_order.type = types::OrderInfo::Type::LIMIT;
-  if (!ExecOrder(buy_order, order_plan.expiration_buy_ts, &buy_order_result)) {
+  if (!PlaceOrder(buy_order, order_plan.expiration_buy_ts,
+                  OrderPlanStage::kBuyOrderPlaced)) {
     spdlog::warn("Failed execute BUY order");
-    SendReport(0, 0, order_plan_start_time, elapsed_time_meter.elapsed_time().count(),
-               types::OrderPlanReport::Status::kFailedToBuy);
-    spdlog::info("OrderPlan processing finished");
-    return;
+    SendReport(0, 0, types::OrderPlanReport::Status::kFailedToBuy);
+    FinishOrderPlan();
+    return false;
   }
-  spdlog::info("Buy stage success");
-
-  types::OrderInfo sell_order;
-  types::OrderResult sell_order_result;
-  sell_order.price = order_plan.min_sell_price;
-  sell_order.side = types::OrderInfo::Side::SELL;
-  sell_order.type = types::OrderInfo::Type::LIMIT;
-  if (!ExecOrder(sell_order, order_plan.expiration_sell_ts, &sell_order_result)) {
-    spdlog::warn("Failed execute SELL order");
-    types::OrderInfo sell_market_order;
-    sell_market_order.side = types::OrderInfo::Side::SELL;
-    sell_market_order.type = types::OrderInfo::Type::MARKET;
-    if (!ExecOrder(sell_market_order, 0, &sell_order_result)) {
-      spdlog::error("Unexpected ExecOrder result");
-      exit(-1);
+  return true;
+}
+
+bool OrderPlanManager::AdvanceOrderPlan(bool is_order_filled,
+                                        const types::OrderResult &result) {
+  const auto &order_plan = *order_plan_info_;
+  switch (stage_) {
+    case OrderPlanStage::kBuyOrderPlaced: {
+      if (!is_order_filled) {
+        spdlog::warn("Failed execute BUY order");
+        SendReport(0, 0, types::OrderPlanReport::Status::kFailedToBuy);
+        FinishOrderPlan();
+        return false;
+      }
+      spdlog::info("Buy stage success");
+      buy_price_ = result.price;
+
+      types::OrderInfo sell_order;
+      sell_order.price = order_plan.min_sell_price;
+      sell_order.side = types::OrderInfo::Side::SELL;
+      sell_order.type = types::OrderInfo::Type::LIMIT;
+      if (!PlaceOrder(sell_order, order_plan.expiration_sell_ts,
+                      OrderPlanStage::kSellOrderPlaced)) {
+        spdlog::warn("Failed execute SELL order");
+        PlaceMarketSellOrder();
+      }
+      return true;
     }
-    SendReport(buy_order_result.price, sell_order_result.price, order_plan_start_time,
-               elapsed_time_meter.elapsed_time().count(),
-               types::OrderPlanReport::Status::kFailedToProfitSell);
-    spdlog::info("OrderPlan processing finished");
-    return;
-  }
-  SendReport(buy_order_result.price, sell_order_result.price, order_plan_start_time,
-             elapsed_time_meter.elapsed_time().count(),
-             types::OrderPlanReport::Status::kOk);
-  spdlog::info("Sell stage success");
 
-  spdlog::info("OrderPlan processing finished");
+    case OrderPlanStage::kSellOrderPlaced:
+      if (!is_order_filled) {
+        spdlog::warn("Failed execute SELL order");
+        PlaceMarketSellOrder();
+        return true;
+      }
+      SendReport(buy_price_, result.price, types::OrderPlanReport::Status::kOk);
+      spdlog::info("Sell stage success");
+      FinishOrderPlan();
+      return false;
+
+    case OrderPlanStage::kSellOrderTimeout:
+      if (!is_order_filled) {
+        spdlog::error("Unexpected market order result");
+        exit(-1);
+      }
+      SendReport(buy_price_, result.price,
+                 types::OrderPlanReport::Status::kFailedToProfitSell);
+      FinishOrderPlan();
+      return false;
+
+    default:
+      spdlog::error("Unexpected order plan stage");
+      exit(-1);
+  }
 }
 
-bool OrderPlanManager::ExecOrder(const types::OrderInfo &order,
-                                 utils::Timestamp expiration_ts,
-                                 types::OrderResult *result) {
+bool OrderPlanManager::PlaceOrder(const types::OrderInfo &order,
+                                  utils::Timestamp expiration_ts, OrderPlanStage stage) {
   const auto now = utils::GlobalClock::Instance().Now();
   if (types::OrderInfo::Type::MARKET != order.type && now >= expiration_ts) {
     spdlog::warn("Order has expired");
@@ -116,52 +150,84 @@ bool OrderPlanManager::ExecOrder(const types::OrderInfo &order,
 
   spdlog::debug("placing order: side {}, type {}", static_cast<int>(order.side),
                 static_cast<int>(order.type));
-  auto order_response = order_manager_->PlaceOrder(order);
+  pending_order_response_ = order_manager_->PlaceOrder(order);
   spdlog::debug("order placed");
-  std::future_status order_result_status = std::future_status::ready;
-
-  if (types::OrderInfo::Type::LIMIT == order.type) {
-    auto time_left = utils::ChronoTimestampPrecision(expiration_ts - now);
-    order_result_status = order_response.order_result.wait_for(time_left);
-  } else {
-    order_response.order_result.wait();
-  }
+  pending_order_type_ = order.type;
+  pending_order_expiration_ts_ = expiration_ts;
+  pending_order_number_++;
+  stage_ = stage;
+  return true;
+}
 
-  if (std::future_status::timeout == order_result_status) {
-    spdlog::debug("order timeout, cancel it");
-    order_manager_->CancelOrder(order_response.order_id.get());
-    auto cancel_responce_status =
-        order_response.order_result.wait_for(kMaxCancelResponceTime);
-    *result = order_response.order_result.get();
-    if (cancel_responce_status == std::future_status::timeout) {
-      spdlog::error("Unexpected status or cancel timeout");
-      exit(-1);
-    }
+void OrderPlanManager::PlaceMarketSellOrder() {
+  types::OrderInfo sell_market_order;
+  sell_market_order.side = types::OrderInfo::Side::SELL;
+  sell_market_order.type = types::OrderInfo::Type::MARKET;
+  PlaceOrder(sell_market_order, 0, OrderPlanStage::kSellOrderTimeout);
+}
 
-    if (result->status != types::OrderResult::Status::kCanceled) {
-      spdlog::warn("Unexpected status for cancelation");
-    }
-    spdlog::debug("order canceled");
-    return false;
+void OrderPlanManager::CancelPendingOrder(std::chrono::seconds max_response_time,
+                                          types::OrderResult *result) {
+  spdlog::debug("order timeout, cancel it");
+  auto &order_result = pending_order_response_.order_result;
+  order_manager_->CancelOrder(pending_order_response_.order_id.get());
+  if (std::future_status::ready != order_result.wait_for(max_response_time)) {
+    spdlog::error("Unexpected status or cancel timeout");
+    exit(-1);
   }
-  *result = order_response.order_result.get();
-  return true;
+  *result = order_result.get();
+  if (result->status != types::OrderResult::Status::kCanceled) {
+    spdlog::warn("Unexpected status for cancelation");
+  }
+  spdlog::debug("order canceled");
 }
 
 void OrderPlanManager::SendReport(market_stream::types::DoubleType buy_price,
                                   market_stream::types::DoubleType sold_price,
-                                  utils::Timestamp start_time_ms,
-                                  utils::TimestampPrecision duration_ms,
                                   types::OrderPlanReport::Status status) {
   types::OrderPlanReport report;
   report.buy_price = buy_price;
   report.sold_price = sold_price;
-  report.start_ts = start_time_ms;
-  report.duration = duration_ms;
+  report.start_ts = order_plan_start_time_;
+  // Duration on the recorded clock in inline mode, so reports of the same stream
+  // are equal
+  report.duration = nullptr != inline_event_loop_
+                        ? utils::GlobalClock::Instance().Now() - order_plan_start_time_
+                        : order_plan_elapsed_time_meter_.elapsed_time().count();
   report.status = status;
   benchmark_data_collector_->AddOrderPlanReport(report);
 }
 
+void OrderPlanManager::FinishOrderPlan() {
+  stage_ = OrderPlanStage::kNotStarted;
+  spdlog::info("OrderPlan processing finished");
+}
+
+void OrderPlanManager::ProcessOrderPlan() {
+  ScopedUnitState<ObservableUnits::UnitId::kOrderPlanManager> scoped_state(unit_state_);
+  if (!StartOrderPlan()) {
+    return;
+  }
+  types::OrderResult result;
+  while (AdvanceOrderPlan(WaitPendingOrder(&result), result)) {
+  }
+}
+
+bool OrderPlanManager::WaitPendingOrder(types::OrderResult *result) {
+  auto &order_result = pending_order_response_.order_result;
+  if (types::OrderInfo::Type::LIMIT == pending_order_type_) {
+    const auto now = utils::GlobalClock::Instance().Now();
+    const auto time_left = utils::ChronoTimestampPrecision(
+        now < pending_order_expiration_ts_ ? pending_order_expiration_ts_ - now : 0);
+    if (std::future_status::timeout == order_result.wait_for(time_left)) {
+      CancelPendingOrder(kMaxCancelResponceTime, result);
+      return false;
+    }
+  }
+  *result = order_result.get();
+  return true;
+}
+
 void OrderPlanManager::OrderPlansProcessThread() {
   spdlog::info("OrderPlansProcessThread started");
   while (!is_stopped_) {
@@ -175,7 +241,7 @@ void OrderPlanManager::OrderPlansProcessThread() {
     lock.unlock();
 
     try {
-      ProcessOrderPlan(*order_plan_info_);
+      ProcessOrderPlan();
     } catch (const std::exception &e) {
       spdlog::error("An exception cought during plan processing: {}", e.what());
     }
@@ -184,4 +250,63 @@ void OrderPlanManager::OrderPlansProcessThread() {
   }
   spdlog::info("OrderPlansProcessThread finished");
 }
-}  // namespace analyzer
\ No newline at end of file
+
+void OrderPlanManager::StartOrderPlanInline() {
+  ScopedUnitState<ObservableUnits::UnitId::kOrderPlanManager> scoped_state(unit_state_);
+  if (StartOrderPlan()) {
+    WaitPendingOrderInline();
+  } else {
+    order_plan_info_ = nullptr;
+  }
+}
+
+void OrderPlanManager::WaitPendingOrderInline() {
+  const auto order_number = pending_order_number_;
+  // The result is filled by market events of this or a later item
+  inline_event_loop_->PostWhenIdle(
+      [this, order_number]() { PollPendingOrderInline(order_number); });
+  if (types::OrderInfo::Type::LIMIT == pending_order_type_) {
+    inline_event_loop_->PostAt(pending_order_expiration_ts_, [this, order_number]() {
+      PollPendingOrderInline(order_number);
+    });
+  }
+}
+
+void OrderPlanManager::PollPendingOrderInline(uint64_t order_number) {
+  if (order_number != pending_order_number_ || OrderPlanStage::kNotStarted == stage_) {
+    // The order was done by the other poll
+    return;
+  }
+  ScopedUnitState<ObservableUnits::UnitId::kOrderPlanManager> scoped_state(unit_state_);
+  types::OrderResult result;
+  const auto order_status = PollPendingOrder(&result);
+  if (PendingOrderStatus::kPending == order_status) {
+    inline_event_loop_->PostWhenIdle(
+        [this, order_number]() { PollPendingOrderInline(order_number); });
+    return;
+  }
+  if (AdvanceOrderPlan(PendingOrderStatus::kFinished == order_status, result)) {
+    WaitPendingOrderInline();
+  } else {
+    order_plan_info_ = nullptr;
+  }
+}
+
+OrderPlanManager::PendingOrderStatus OrderPlanManager::PollPendingOrder(
+    types::OrderResult *result) {
+  auto &order_result = pending_order_response_.order_result;
+  if (std::future_status::ready == order_result.wait_for(std::chrono::seconds(0))) {
+    *result = order_result.get();
+    return PendingOrderStatus::kFinished;
+  }
+  if (types::OrderInfo::Type::MARKET == pending_order_type_ ||
+      utils::GlobalClock::Instance().Now() < pending_order_expiration_ts_) {
+    return PendingOrderStatus::kPending;
+  }
+
+  // Cancelation is answered in place, no event of the loop can complete it later
+  CancelPendingOrder(std::chrono::seconds(0), result);
+  return PendingOrderStatus::kExpired;
+}
+
+}  // namespace analyzer
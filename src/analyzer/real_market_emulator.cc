@@ -17,7 +17,10 @@ RealMarketEmulator::RealMarketEmulator(
     const std::weak_ptr<EventHubHandler> &event_handler,
     const std::shared_ptr<RealMarketEmulatorUnitState> &unit_state)
     : last_max_buy_(-1), last_min_sell_(-1), unit_state_(unit_state) {
-  SUBSCRIBE_TO_EVENT(event_handler, &RealMarketEmulator::OnOrderBookStreamEvent);
+  // Only the best levels matter and only the newest of them, stale ones are
+  // overwritten while busy
+  SUBSCRIBE_TO_LATEST_EVENTS(event_handler, &RealMarketEmulator::OnOrderBookStreamEvent,
+                             MQ::Event::kBestBidOfferChanged);
 }
 
 types::OrderResponse<std::future> RealMarketEmulator::PlaceOrder(
@@ -40,7 +43,7 @@ std::size_t RealMarketEmulator::orders_count() const {
 }
 
 void RealMarketEmulator::OnOrderBookStreamEvent(MQ::Event event, const void *data) {
-  if (MQ::Event::kNewSnapshotAvailable != event) {
+  if (MQ::Event::kBestBidOfferChanged != event) {
     spdlog::error("unknown event type");
     return;
   }
@@ -55,6 +58,7 @@ types::OrderResponse<std::future> RealMarketEmulator::PlaceOrder_locked(
   Order order;
   order.id = ++unique_id_iterator;
   order.info = order_info;
+  order.price = order_info.price;
   responce.order_id = order.responce.order_id.get_future();
   responce.order_result = order.responce.order_result.get_future();
 
@@ -62,9 +66,15 @@ types::OrderResponse<std::future> RealMarketEmulator::PlaceOrder_locked(
 
   orders_.emplace_back(std::move(order));
 
-  // For order type MARKET
-  auto finished_market_orders = ProcessMarketTypeOrders();
-  RemoveFinishedOrders(finished_market_orders);
+  // Orders are checked again only when the best prices change, so market orders
+  // and limit orders already crossing the known best prices are filled right away
+  std::vector<uint64_t> finished_orders;
+  if (last_max_buy_ < 0 || last_min_sell_ < 0) {
+    finished_orders = ProcessMarketTypeOrders();
+  } else {
+    finished_orders = CheckAndUpdateOrders(last_max_buy_, last_min_sell_);
+  }
+  RemoveFinishedOrders(finished_orders);
 
   return responce;
 }
@@ -79,11 +89,16 @@ std::size_t RealMarketEmulator::orders_count_locked() const { return orders_.siz
 
 void RealMarketEmulator::OnOrderBookStreamEvent_locked(MQ::Event event,
                                                        const void *data) {
-  auto order_book = static_cast<const market_stream::types::OrderBook *>(data);
+  auto best_bid_offer = static_cast<const market_stream::types::BestBidOffer *>(data);
   spdlog::debug("OrderBookStreamEvent: recieved_ts={}, current_ts={}",
-                order_book->received_timestamp, utils::GlobalClock::Instance().Now());
-  last_max_buy_ = order_book->bids.front().price;
-  last_min_sell_ = order_book->asks.front().price;
+                best_bid_offer->received_timestamp, utils::GlobalClock::Instance().Now());
+  // An empty side keeps its last known price
+  if (!best_bid_offer->bid.quantity.is_zero()) {
+    last_max_buy_ = best_bid_offer->bid.price;
+  }
+  if (!best_bid_offer->ask.quantity.is_zero()) {
+    last_min_sell_ = best_bid_offer->ask.price;
+  }
   auto finished_orders = CheckAndUpdateOrders(last_max_buy_, last_min_sell_);
   RemoveFinishedOrders(finished_orders);
 }
@@ -100,8 +115,9 @@ std::vector<uint64_t> RealMarketEmulator::ProcessMarketTypeOrders() {
       types::OrderResult result;
       result.status = types::OrderResult::Status::kOk;
       result.order_id = it.id;
-      result.price =
-          types::OrderInfo::Side::BUY == it.info.side ? last_max_buy_ : last_min_sell_;
+      result.price = (types::OrderInfo::Side::BUY == it.info.side ? last_max_buy_
+                                                                  : last_min_sell_)
+                         .ToDecimal();
       result.quantity = it.info.quantity;
       it.responce.order_result.set_value(result);
       finished_orders.push_back(it.id);
@@ -112,13 +128,13 @@ std::vector<uint64_t> RealMarketEmulator::ProcessMarketTypeOrders() {
 }
 
 std::vector<uint64_t> RealMarketEmulator::CheckAndUpdateOrders(
-    market_stream::types::DoubleType max_buy, market_stream::types::DoubleType min_sell) {
+    market_stream::types::FixedPoint max_buy, market_stream::types::FixedPoint min_sell) {
   std::vector<uint64_t> finished_orders = ProcessMarketTypeOrders();
   for (auto &it : orders_) {
     const bool is_finished_as_buy_order =
-        types::OrderInfo::Side::BUY == it.info.side && it.info.price >= max_buy;
+        types::OrderInfo::Side::BUY == it.info.side && it.price >= max_buy;
     const bool is_finished_as_sell_order =
-        types::OrderInfo::Side::SELL == it.info.side && it.info.price <= min_sell;
+        types::OrderInfo::Side::SELL == it.info.side && it.price <= min_sell;
     if (is_finished_as_buy_order || is_finished_as_sell_order) {
       spdlog::info("Found finished limit order {}", it.id);
       types::OrderResult result;
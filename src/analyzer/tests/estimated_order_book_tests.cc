@@ -0,0 +1,129 @@
+#include <gmock/gmock.h>
+
+#include <memory>
+
+#include "analyzer/estimated_order_book.h"
+#include "analyzer/order_book_snapshot_provider.h"
+#include "events/event_hub.h"
+#include "market_stream/types/types.h"
+
+namespace analyzer {
+
+namespace {
+using market_stream::types::OrderBook;
+using market_stream::types::Trade;
+
+class EstimatedOrderBookFixture : public ::testing::Test {
+ protected:
+  using MQMarketStream = events::message_queues::MarketStream;
+  using MQOrderBookStream = events::message_queues::OrderBookStream;
+
+  EstimatedOrderBookFixture() {
+    snapshot_provider_ = std::make_shared<OrderBookSnapshotProvider>(
+        market_stream_event_hub_.CreateHandler(), order_book_event_hub_.dispatcher(),
+        nullptr, false);
+    estimated_order_book_ = std::make_unique<EstimatedOrderBook>(
+        market_stream_event_hub_.CreateHandler(), snapshot_provider_);
+  }
+
+  void TearDown() override {
+    market_stream_event_hub_.Shutdown();
+    order_book_event_hub_.Shutdown();
+  }
+
+  void SendUpdate(const OrderBook &update) {
+    market_stream_event_hub_.dispatcher().lock()->DispatchEvent<
+        MQMarketStream::Event::kOrderBookUpdateEvent>(update);
+    market_stream_event_hub_.WaitForAllEventsProcessed();
+  }
+
+  void SendTrade(double price, double quantity, bool is_buyer_maker,
+                 uint64_t trade_timestamp) {
+    Trade trade;
+    trade.price = price;
+    trade.quantity = quantity;
+    trade.is_buyer_maker = is_buyer_maker;
+    trade.trade_timestamp = trade_timestamp;
+    trade.event_timestamp = trade_timestamp;
+    market_stream_event_hub_.dispatcher().lock()->DispatchEvent<
+        MQMarketStream::Event::kNewTradeEvent>(trade);
+    market_stream_event_hub_.WaitForAllEventsProcessed();
+  }
+
+  events::EventHub<MQMarketStream> market_stream_event_hub_;
+  events::EventHub<MQOrderBookStream> order_book_event_hub_;
+  std::shared_ptr<OrderBookSnapshotProvider> snapshot_provider_;
+  std::unique_ptr<EstimatedOrderBook> estimated_order_book_;
+};
+}  // namespace
+
+TEST_F(EstimatedOrderBookFixture, GivenSnapshot_WhenTradesExecuted_ThenTouchConsumed) {
+  // Given
+  OrderBook update;
+  update.timestamp = 1000;
+  update.bids = {{100, 2}, {99, 3}};
+  update.asks = {{101, 1}, {102, 5}};
+  SendUpdate(update);
+
+  // When
+  SendTrade(100, 1.5, true, 1010);
+  SendTrade(102, 2, false, 1020);
+
+  // Then
+  const auto depth = estimated_order_book_->GetDepth();
+  EXPECT_EQ(depth.bids, OrderBook::Items({{100, 0.5}, {99, 3}}));
+  EXPECT_EQ(depth.asks, OrderBook::Items({{102, 3}}));
+  EXPECT_EQ(depth.timestamp, 1020);
+  const auto best_bid_offer = estimated_order_book_->GetBestBidOffer();
+  EXPECT_EQ(best_bid_offer.bid, OrderBook::Item(100, 0.5));
+  EXPECT_EQ(best_bid_offer.ask, OrderBook::Item(102, 3));
+}
+
+TEST_F(EstimatedOrderBookFixture, GivenDiffs_WhenTradesExecuted_ThenSnapshotBuiltOnRead) {
+  // Given
+  OrderBook update;
+  update.timestamp = 1000;
+  update.bids = {{100, 2}, {99, 3}};
+  update.asks = {{101, 1}, {102, 5}};
+  SendUpdate(update);
+
+  // When
+  SendTrade(100, 1.5, true, 1010);
+  update.timestamp = 1020;
+  update.bids = {{98, 1}};
+  update.asks = {};
+  SendUpdate(update);
+  SendTrade(101, 0.5, false, 1030);
+
+  // Then
+  EXPECT_EQ(snapshot_provider_->GetBuiltSnapshot()->version(), 0);
+  const auto depth = estimated_order_book_->GetDepth();
+  EXPECT_EQ(snapshot_provider_->GetBuiltSnapshot()->version(), 2);
+  EXPECT_EQ(depth.bids, OrderBook::Items({{100, 2}, {99, 3}, {98, 1}}));
+  EXPECT_EQ(depth.asks, OrderBook::Items({{101, 0.5}, {102, 5}}));
+}
+
+TEST_F(EstimatedOrderBookFixture,
+       GivenTrades_WhenNextDiffReceived_ThenNewerTradesApplied) {
+  // Given
+  OrderBook update;
+  update.timestamp = 1000;
+  update.bids = {{100, 2}, {99, 3}};
+  update.asks = {{101, 1}, {102, 5}};
+  SendUpdate(update);
+  SendTrade(100, 1.5, true, 1010);
+  SendTrade(102, 2, false, 1020);
+
+  // When
+  update.timestamp = 1015;
+  update.bids = {{100, 0.7}};
+  update.asks = {};
+  SendUpdate(update);
+
+  // Then
+  const auto depth = estimated_order_book_->GetDepth();
+  EXPECT_EQ(depth.bids, OrderBook::Items({{100, 0.7}, {99, 3}}));
+  EXPECT_EQ(depth.asks, OrderBook::Items({{102, 3}}));
+}
+
+}  // namespace analyzer
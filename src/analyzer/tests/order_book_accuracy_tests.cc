@@ -0,0 +1,88 @@
+#include <gmock/gmock.h>
+
+#include <nlohmann/json.hpp>
+
+#include "analyzer/order_book_accuracy.h"
+#include "market_stream/types/order_book_columns.h"
+#include "market_stream/types/types.h"
+
+namespace analyzer {
+
+namespace {
+using market_stream::types::OrderBook;
+using market_stream::types::OrderBookColumns;
+using market_stream::types::OrderBookLevels;
+
+OrderBook::Items MakeLevels(int first_price, int step, std::size_t levels_count) {
+  OrderBook::Items result;
+  for (std::size_t i = 0; i < levels_count; i++) {
+    result.emplace_back(first_price + step * static_cast<int>(i), 1 + i % 3);
+  }
+  return result;
+}
+}  // namespace
+
+TEST(OrderBookAccuracy, GivenMismatchingLevels_WhenCompared_ThenCountedPerBucket) {
+  // Given
+  const auto reference_items = MakeLevels(10000, -1, 200);
+  auto local_items = reference_items;
+  local_items[10].quantity = 7;                 // quantity mismatch in first 50
+  local_items.erase(local_items.begin() + 60);  // missing level in first 100
+  local_items.insert(local_items.begin() + 150, OrderBook::Item(9849.5, 1));
+  const OrderBookLevels reference(reference_items, false);
+  const OrderBookLevels local(local_items, false);
+
+  // When
+  OrderBookAccuracy::SideBuckets buckets;
+  OrderBookAccuracy::Compare(local, reference, &buckets);
+
+  // Then
+  EXPECT_EQ(buckets[0].levels_count, 50);
+  EXPECT_EQ(buckets[0].quantity_mismatches, 1);
+  EXPECT_EQ(buckets[0].price_mismatches, 0);
+  EXPECT_EQ(buckets[0].first_mismatch_level, 10);
+  EXPECT_EQ(buckets[1].levels_count, 100);
+  EXPECT_EQ(buckets[1].quantity_mismatches, 1);
+  EXPECT_EQ(buckets[1].price_mismatches, 1);
+  // Thinner reference, the last buckets cover all of it
+  for (std::size_t i = 2; i < OrderBookAccuracy::kBucketsCount; i++) {
+    EXPECT_EQ(buckets[i].levels_count, 200);
+    EXPECT_EQ(buckets[i].quantity_mismatches, 1);
+    EXPECT_EQ(buckets[i].price_mismatches, 2);
+  }
+  for (std::size_t i = 0; i < OrderBookAccuracy::kBucketsCount; i++) {
+    const auto expected = OrderBookLevels::CosineSimilarity(
+        local, reference, OrderBookAccuracy::kLevelsCounts[i]);
+    ASSERT_TRUE(buckets[i].similarity);
+    EXPECT_DOUBLE_EQ(*buckets[i].similarity, *expected);
+  }
+}
+
+TEST(OrderBookAccuracy, GivenEqualBooks_WhenCompared_ThenJsonReportsNoMismatches) {
+  // Given
+  OrderBook order_book;
+  order_book.timestamp = 1000;
+  order_book.bids = MakeLevels(100, -1, 60);
+  order_book.asks = MakeLevels(101, 1, 60);
+  const OrderBookColumns columns(order_book);
+
+  // When
+  const auto accuracy = OrderBookAccuracy::Compare(columns, columns);
+
+  // Then
+  const auto json = nlohmann::json::parse(accuracy.ToJson());
+  EXPECT_EQ(json["timestamp"], 1000);
+  for (const auto &side : {json["bids"], json["asks"]}) {
+    ASSERT_EQ(side.size(), OrderBookAccuracy::kBucketsCount);
+    EXPECT_EQ(side[0]["levels_count"], 50);
+    EXPECT_EQ(side[1]["levels_count"], 60);
+    for (const auto &bucket : side) {
+      EXPECT_EQ(bucket["price_mismatches"], 0);
+      EXPECT_EQ(bucket["quantity_mismatches"], 0);
+      EXPECT_TRUE(bucket["first_mismatch_level"].is_null());
+      EXPECT_DOUBLE_EQ(bucket["similarity"].get<double>(), 1.0);
+    }
+  }
+}
+
+}  // namespace analyzer
@@ -0,0 +1,115 @@
+#include <gmock/gmock.h>
+
+#include <random>
+
+#include "analyzer/order_book_analytics.h"
+#include "analyzer/order_book_engine.h"
+#include "market_stream/types/types.h"
+
+namespace analyzer {
+
+namespace {
+using market_stream::types::FixedPoint;
+using market_stream::types::OrderBook;
+}  // namespace
+
+TEST(OrderBookAnalytics, GivenOrderBook_WhenQueried_ThenCalculatedFromBestLevels) {
+  // Given
+  OrderBook order_book;
+  order_book.bids = {{100, 1}, {99, 2}, {98, 4}};
+  order_book.asks = {{101, 3}, {102, 1}};
+
+  // When
+  const OrderBookAnalytics analytics(&order_book);
+
+  // Then
+  EXPECT_DOUBLE_EQ(analytics.bids().Depth(0), 0);
+  EXPECT_DOUBLE_EQ(analytics.bids().Depth(2), 3);
+  EXPECT_DOUBLE_EQ(analytics.bids().Depth(10), 7);
+  EXPECT_DOUBLE_EQ(*analytics.bids().CostToFill(1), 100);
+  EXPECT_DOUBLE_EQ(*analytics.bids().CostToFill(2.5), 100 + 99 * 1.5);
+  EXPECT_DOUBLE_EQ(*analytics.asks().AveragePriceToFill(4), (101 * 3 + 102) / 4.0);
+  EXPECT_FALSE(analytics.asks().CostToFill(4.5));
+  EXPECT_DOUBLE_EQ(*analytics.Imbalance(1), (1 - 3) / 4.0);
+  EXPECT_DOUBLE_EQ(*analytics.Imbalance(2), (3 - 4) / 7.0);
+  EXPECT_DOUBLE_EQ(*analytics.Microprice(), (100 * 3 + 101 * 1) / 4.0);
+}
+
+TEST(OrderBookAnalytics, GivenEmptySide_WhenQueried_ThenNoValue) {
+  // Given
+  OrderBook order_book;
+  order_book.bids = {{100, 1}};
+
+  // When
+  const OrderBookAnalytics analytics(&order_book);
+
+  // Then
+  EXPECT_FALSE(analytics.Microprice());
+  EXPECT_FALSE(analytics.asks().CostToFill(1));
+  EXPECT_DOUBLE_EQ(*analytics.Imbalance(5), 1);
+  const OrderBook empty_order_book;
+  EXPECT_FALSE(OrderBookAnalytics(&empty_order_book).Imbalance(5));
+}
+
+TEST(OrderBookAnalytics, GivenLowPricedSymbolLevels_WhenQueried_ThenNoOverflow) {
+  // Given
+  OrderBook update;
+  // Each quantity is about half of the FixedPoint range
+  update.bids = {{0.003, 5e10}, {0.002, 5e10}, {0.001, 5e10}};
+  OrderBookEngine engine(10);
+  engine.Apply(update);
+  OrderBook order_book;
+  engine.CopyTo(&order_book);
+
+  // When
+  const OrderBookAnalytics analytics(&order_book,
+                                     OrderBookSideTotals(engine.bids().totals()),
+                                     OrderBookSideTotals(engine.asks().totals()));
+
+  // Then
+  EXPECT_DOUBLE_EQ(analytics.bids().Depth(3), 1.5e11);
+  EXPECT_DOUBLE_EQ(*analytics.bids().CostToFill(1.2e11),
+                   0.003 * 5e10 + 0.002 * 5e10 + 0.001 * 2e10);
+  EXPECT_DOUBLE_EQ(*analytics.Imbalance(3), 1);
+}
+
+TEST(OrderBookAnalytics, GivenEngineTotals_WhenDiffsApplied_ThenSameAsCalculated) {
+  // Given
+  std::mt19937 random(7);
+  std::uniform_int_distribution<int64_t> price_distribution(1000, 1100);
+  std::uniform_int_distribution<int64_t> quantity_distribution(0, 5);
+  OrderBookEngine engine(40);
+  OrderBook order_book;
+
+  for (int i = 0; i < 500; i++) {
+    OrderBook update;
+    const int64_t bid_price = price_distribution(random);
+    const int64_t ask_price = bid_price + 200;
+    update.bids = {{FixedPoint::FromTicks(bid_price),
+                    FixedPoint::FromTicks(quantity_distribution(random))}};
+    update.asks = {{FixedPoint::FromTicks(ask_price),
+                    FixedPoint::FromTicks(quantity_distribution(random))}};
+
+    // When
+    engine.Apply(update);
+    engine.CopyTo(&order_book);
+    const OrderBookAnalytics maintained(&order_book,
+                                        OrderBookSideTotals(engine.bids().totals()),
+                                        OrderBookSideTotals(engine.asks().totals()));
+    const OrderBookAnalytics calculated(&order_book);
+
+    // Then
+    for (std::size_t level = 0; level <= order_book.bids.size(); level++) {
+      const auto depth = calculated.bids().Depth(level);
+      ASSERT_EQ(maintained.bids().Depth(level), depth);
+      ASSERT_EQ(maintained.bids().CostToFill(depth), calculated.bids().CostToFill(depth));
+    }
+    for (std::size_t level = 0; level <= order_book.asks.size(); level++) {
+      const auto depth = calculated.asks().Depth(level);
+      ASSERT_EQ(maintained.asks().Depth(level), depth);
+      ASSERT_EQ(maintained.asks().CostToFill(depth), calculated.asks().CostToFill(depth));
+    }
+  }
+}
+
+}  // namespace analyzer
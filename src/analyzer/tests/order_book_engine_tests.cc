@@ -0,0 +1,163 @@
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <random>
+
+#include "analyzer/order_book_engine.h"
+#include "market_stream/types/types.h"
+
+namespace analyzer {
+
+namespace {
+using market_stream::types::FixedPoint;
+using market_stream::types::OrderBook;
+
+// Sorted diff around the top of the book, with removals of present and absent levels
+OrderBook::Items MakeDiff(std::mt19937 &random, bool is_increasing) {
+  std::uniform_int_distribution<int64_t> price_distribution(1000, 1200);
+  std::uniform_int_distribution<int64_t> quantity_distribution(0, 3);
+  std::vector<int64_t> prices(8);
+  for (auto &it : prices) {
+    it = price_distribution(random);
+  }
+  std::sort(prices.begin(), prices.end());
+  prices.erase(std::unique(prices.begin(), prices.end()), prices.end());
+  if (!is_increasing) {
+    std::reverse(prices.begin(), prices.end());
+  }
+  OrderBook::Items diff;
+  for (auto it : prices) {
+    diff.emplace_back(FixedPoint::FromTicks(it),
+                      FixedPoint::FromTicks(quantity_distribution(random)));
+  }
+  return diff;
+}
+}  // namespace
+
+TEST(OrderBookEngine, GivenDiffs_WhenApplied_ThenSameBookAsMerge) {
+  // Given
+  const std::size_t max_levels = 50;
+  std::mt19937 random(42);
+  OrderBookEngine engine(max_levels);
+  OrderBook::Items merged_bids, merged_asks;
+  OrderBook order_book;
+
+  for (int i = 0; i < 1000; i++) {
+    OrderBook update;
+    update.timestamp = i;
+    update.received_timestamp = i + 10;
+    update.bids = MakeDiff(random, false);
+    update.asks = MakeDiff(random, true);
+
+    // When
+    engine.Apply(update);
+    merged_bids = MergeOrderBookItems(merged_bids, update.bids, false);
+    merged_asks = MergeOrderBookItems(merged_asks, update.asks, true);
+    // Merge keeps removals of levels behind its last one, the engine never stores them
+    const auto is_removed = [](const OrderBook::Item &item) {
+      return item.quantity.is_zero();
+    };
+    merged_bids.erase(std::remove_if(merged_bids.begin(), merged_bids.end(), is_removed),
+                      merged_bids.end());
+    merged_asks.erase(std::remove_if(merged_asks.begin(), merged_asks.end(), is_removed),
+                      merged_asks.end());
+    merged_bids.resize(std::min(max_levels, merged_bids.size()));
+    merged_asks.resize(std::min(max_levels, merged_asks.size()));
+
+    // Then
+    engine.CopyTo(&order_book);
+    ASSERT_EQ(order_book.bids, merged_bids);
+    ASSERT_EQ(order_book.asks, merged_asks);
+    EXPECT_EQ(order_book.timestamp, update.timestamp);
+    EXPECT_EQ(order_book.received_timestamp, update.received_timestamp);
+  }
+}
+
+TEST(OrderBookEngine, GivenTakenLevels_WhenDiffsApplied_ThenLevelsUnchanged) {
+  // Given
+  std::mt19937 random(42);
+  OrderBookEngine engine(150);
+  OrderBook taken_book, order_book;
+
+  for (int i = 0; i < 300; i++) {
+    OrderBook update;
+    update.timestamp = i;
+    update.bids = MakeDiff(random, false);
+    update.asks = MakeDiff(random, true);
+    engine.Apply(update);
+    const auto levels = engine.levels();
+    engine.CopyTo(&taken_book);
+
+    // When
+    update.bids = MakeDiff(random, false);
+    update.asks = MakeDiff(random, true);
+    engine.Apply(update);
+
+    // Then
+    levels.CopyTo(&order_book);
+    ASSERT_EQ(order_book.bids, taken_book.bids);
+    ASSERT_EQ(order_book.asks, taken_book.asks);
+    EXPECT_EQ(order_book.timestamp, i);
+  }
+}
+
+TEST(OrderBookEngine, GivenTakenLevels_WhenDiffsApplied_ThenTotalsTakenWithLevels) {
+  // Given
+  std::mt19937 random(7);
+  OrderBookEngine engine(150);
+  OrderBook order_book;
+  OrderBookSideTotals taken_totals, totals;
+
+  for (int i = 0; i < 300; i++) {
+    OrderBook update;
+    update.bids = MakeDiff(random, false);
+    update.asks = MakeDiff(random, true);
+    engine.Apply(update);
+    const auto levels = engine.levels();
+    taken_totals = engine.bids().totals();
+
+    // When
+    update.bids = MakeDiff(random, false);
+    engine.Apply(update);
+
+    // Then
+    levels.bids.CopyTotalsTo(&totals);
+    levels.bids.CopyTo(&order_book.bids);
+    ASSERT_EQ(totals.size(), order_book.bids.size());
+    double quantity = 0, notional = 0;
+    for (std::size_t level = 0; level < totals.size(); level++) {
+      ASSERT_EQ(totals[level].quantity, taken_totals[level].quantity);
+      ASSERT_EQ(totals[level].notional, taken_totals[level].notional);
+      quantity += order_book.bids[level].quantity.ToDouble();
+      notional += order_book.bids[level].price.ToDouble() *
+                  order_book.bids[level].quantity.ToDouble();
+      // Summed per chunk first, so only close to the sum level by level
+      ASSERT_NEAR(totals[level].quantity, quantity, quantity * 1e-12);
+      ASSERT_NEAR(totals[level].notional, notional, notional * 1e-12);
+    }
+  }
+}
+
+TEST(OrderBookEngine, GivenFullSide_WhenWorseLevelAdded_ThenDepthBounded) {
+  // Given
+  OrderBookEngine engine(2);
+  OrderBook update;
+  update.bids = {{121, 1}, {120, 2}};
+  update.asks = {{122, 1}, {123, 2}};
+  engine.Apply(update);
+
+  // When
+  update.bids = {{122, 5}, {119, 3}};
+  update.asks = {{121.5, 5}, {124, 3}};
+  engine.Apply(update);
+
+  // Then
+  OrderBook order_book;
+  engine.CopyTo(&order_book);
+  EXPECT_EQ(order_book.bids, OrderBook::Items({{122, 5}, {121, 1}}));
+  EXPECT_EQ(order_book.asks, OrderBook::Items({{121.5, 5}, {122, 1}}));
+  EXPECT_EQ(engine.bids().size(), 2);
+  EXPECT_EQ(engine.asks().size(), 2);
+}
+
+}  // namespace analyzer
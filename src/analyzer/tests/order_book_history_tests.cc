@@ -0,0 +1,84 @@
+#include <gmock/gmock.h>
+
+#include <random>
+#include <vector>
+
+#include "analyzer/order_book_engine.h"
+#include "analyzer/order_book_history.h"
+#include "market_stream/types/types.h"
+
+namespace analyzer {
+
+namespace {
+using market_stream::types::FixedPoint;
+using market_stream::types::OrderBook;
+
+OrderBook MakeUpdate(std::mt19937 &random, utils::Timestamp received_timestamp) {
+  std::uniform_int_distribution<int64_t> price_distribution(1000, 1050);
+  std::uniform_int_distribution<int64_t> quantity_distribution(0, 4);
+  OrderBook update;
+  update.timestamp = received_timestamp - 5;
+  update.received_timestamp = received_timestamp;
+  const int64_t bid_price = price_distribution(random);
+  update.bids = {{FixedPoint::FromTicks(bid_price),
+                  FixedPoint::FromTicks(quantity_distribution(random))}};
+  update.asks = {{FixedPoint::FromTicks(bid_price + 100),
+                  FixedPoint::FromTicks(quantity_distribution(random))}};
+  return update;
+}
+}  // namespace
+
+TEST(OrderBookHistory, GivenRecordedUpdates_WhenQueriedAt_ThenBookOfLastUpdateBefore) {
+  // Given
+  const std::size_t max_levels = 20;
+  std::mt19937 random(3);
+  OrderBookEngine engine(max_levels);
+  OrderBookHistory history(max_levels, 7);
+  history.set_duration(100000);
+  std::vector<OrderBook> books;
+
+  // When
+  for (int i = 1; i <= 100; i++) {
+    const auto update = MakeUpdate(random, i * 10);
+    engine.Apply(update);
+    history.Record(update, engine);
+    books.emplace_back();
+    engine.CopyTo(&books.back());
+  }
+
+  // Then
+  EXPECT_FALSE(history.GetSnapshotAt(9));
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(*history.GetSnapshotAt(books[i].received_timestamp), books[i]);
+    ASSERT_EQ(*history.GetSnapshotAt(books[i].received_timestamp + 9), books[i]);
+  }
+  const auto depth = history.GetTopNAt(555, 2);
+  ASSERT_TRUE(depth);
+  EXPECT_EQ(depth->received_timestamp, 550);
+  const auto &bids = books[54].bids;
+  const auto bids_count = std::min<std::size_t>(2, bids.size());
+  EXPECT_EQ(depth->bids, OrderBook::Items(bids.begin(), bids.begin() + bids_count));
+}
+
+TEST(OrderBookHistory, GivenDuration_WhenHistoryGrows_ThenOlderStatesDropped) {
+  // Given
+  const std::size_t max_levels = 20;
+  std::mt19937 random(5);
+  OrderBookEngine engine(max_levels);
+  OrderBookHistory history(max_levels, 4);
+  history.set_duration(200);
+
+  // When
+  for (int i = 1; i <= 100; i++) {
+    const auto update = MakeUpdate(random, i * 10);
+    engine.Apply(update);
+    history.Record(update, engine);
+  }
+
+  // Then
+  EXPECT_TRUE(history.GetSnapshotAt(800));
+  EXPECT_FALSE(history.GetSnapshotAt(700));
+  EXPECT_EQ(history.GetSnapshotAt(5000)->received_timestamp, 1000);
+}
+
+}  // namespace analyzer
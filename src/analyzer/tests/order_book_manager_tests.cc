@@ -0,0 +1,83 @@
+#include <gmock/gmock.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "analyzer/order_book_engine.h"
+#include "analyzer/order_book_manager.h"
+#include "market_stream/types/types.h"
+
+namespace analyzer {
+
+namespace {
+using market_stream::types::FixedPoint;
+using market_stream::types::OrderBook;
+}  // namespace
+
+TEST(OrderBookManager, GivenSymbols_WhenUpdatesApplied_ThenEveryBookKeptSeparately) {
+  // Given
+  const std::vector<std::string> symbols = {"ETHBTC", "LTCBTC", "BNBBTC", "NEOBTC",
+                                            "BTCUSDT"};
+  OrderBookManagerOptions options;
+  options.shards_count = 2;
+  options.max_levels = 10;
+  OrderBookManager manager(symbols, options);
+  std::map<std::string, std::unique_ptr<OrderBookEngine>> engines;
+  for (const auto &symbol : symbols) {
+    engines[symbol] = std::make_unique<OrderBookEngine>(options.max_levels);
+  }
+
+  // When
+  for (int i = 0; i < 200; i++) {
+    const auto &symbol = symbols[i % symbols.size()];
+    OrderBook update;
+    update.received_timestamp = i;
+    update.bids = {{FixedPoint::FromTicks(1000 + i % 7), FixedPoint::FromTicks(i % 3)}};
+    update.asks = {{FixedPoint::FromTicks(1100 + i % 11), FixedPoint::FromTicks(i % 4)}};
+    engines[symbol]->Apply(update);
+    ASSERT_TRUE(manager.Apply(symbol, std::move(update)));
+  }
+  manager.Shutdown();
+
+  // Then
+  EXPECT_EQ(manager.shards_count(), 2);
+  for (const auto &symbol : symbols) {
+    OrderBook expected;
+    engines[symbol]->CopyTo(&expected);
+    const auto snapshot = manager.GetSnapshot(symbol);
+    ASSERT_NE(snapshot, nullptr);
+    EXPECT_EQ(snapshot->order_book(), expected);
+    EXPECT_EQ(snapshot->version(), 40);
+    EXPECT_EQ(manager.GetSnapshot(symbol), snapshot);
+    const auto best_bid_offer = manager.GetBestBidOffer(symbol);
+    ASSERT_TRUE(best_bid_offer);
+    EXPECT_EQ(best_bid_offer->bid, expected.bids.front());
+    EXPECT_EQ(best_bid_offer->ask, expected.asks.front());
+    EXPECT_EQ(best_bid_offer->received_timestamp, expected.received_timestamp);
+  }
+  EXPECT_FALSE(manager.Apply("XRPBTC", OrderBook()));
+  EXPECT_EQ(manager.GetSnapshot("XRPBTC"), nullptr);
+  EXPECT_FALSE(manager.GetBestBidOffer("XRPBTC"));
+}
+
+TEST(OrderBookManager, GivenShutDownManager_WhenUpdateApplied_ThenRejected) {
+  // Given
+  OrderBookManager manager({"ETHBTC"});
+  OrderBook update;
+  update.bids = {{100, 1}};
+  ASSERT_TRUE(manager.Apply("ETHBTC", OrderBook(update)));
+  manager.Shutdown();
+
+  // When
+  update.bids = {{101, 2}};
+  const bool is_applied = manager.Apply("ETHBTC", std::move(update));
+
+  // Then
+  EXPECT_FALSE(is_applied);
+  const auto snapshot = manager.GetSnapshot("ETHBTC");
+  EXPECT_EQ(snapshot->version(), 1);
+  EXPECT_EQ(snapshot->order_book().bids, OrderBook::Items({{100, 1}}));
+}
+
+}  // namespace analyzer
@@ -1,5 +1,7 @@
 #include <gmock/gmock.h>
 
+#include <future>
+
 #include "analyzer/benchmark_orchestrator.h"
 #include "analyzer/order_book_snapshot_provider.h"
 #include "analyzer/scoped_unit_state.h"
@@ -39,7 +41,8 @@ TEST(OrderBookSnapshotProvider,
   order_book_event_hub.CreateHandler().lock()->Subscribe(
       [&dispatcher_snapshot](MQOrderBookStream::Event event, const void* data) {
         dispatcher_snapshot = *static_cast<const market_stream::types::OrderBook*>(data);
-      });
+      },
+      {MQOrderBookStream::Event::kNewSnapshotAvailable});
 
   // When
   fake_forwarder->Start();
@@ -48,7 +51,7 @@ TEST(OrderBookSnapshotProvider,
   auto order_book_snapshot = ob_provider.GetSnapshot();
 
   // Then
-  fake_forwarder->VerifyOrderBookHandle(order_book_snapshot);
+  fake_forwarder->VerifyOrderBookHandle(order_book_snapshot->order_book());
   fake_forwarder->VerifyOrderBookHandle(dispatcher_snapshot);
 }
 
@@ -83,7 +86,474 @@ TEST(OrderBookSnapshotProvider,
   auto order_book_snapshot = ob_provider.GetSnapshot(155466);
 
   // Then
-  fake_forwarder->VerifyOrderBookHandle(order_book_snapshot);
+  fake_forwarder->VerifyOrderBookHandle(order_book_snapshot->order_book());
+}
+
+TEST(OrderBookSnapshotProvider,
+     GivenMirrorProvider_WhenSnapshotsDispatched_ThenMirrorHasSameOrderBook) {
+  using MQMarketStream = events::message_queues::MarketStream;
+  using MQOrderBookStream = events::message_queues::OrderBookStream;
+
+  // Given
+  events::EventHub<MQMarketStream> market_stream_event_hub;
+  events::EventHub<MQOrderBookStream> order_book_event_hub;
+
+  std::shared_ptr<FakeMarketStreamForwarder> fake_forwarder =
+      std::make_shared<FakeMarketStreamForwarder>(market_stream_event_hub.dispatcher());
+  fake_forwarder->Initialize();
+  analyzer::OrderBookSnapshotProvider ob_provider(market_stream_event_hub.CreateHandler(),
+                                                  order_book_event_hub.dispatcher(),
+                                                  nullptr);
+  analyzer::OrderBookSnapshotProvider mirror_ob_provider(
+      order_book_event_hub.CreateHandler(), nullptr);
+
+  // When
+  fake_forwarder->Start();
+  market_stream_event_hub.Shutdown();
+  order_book_event_hub.Shutdown();
+
+  // Then
+  fake_forwarder->VerifyOrderBookHandle(mirror_ob_provider.GetSnapshot()->order_book());
+}
+
+TEST(OrderBookSnapshotProvider,
+     GivenSnapshotHandle_WhenOrderBookUpdated_ThenHandleKeptAndNextVersionReceived) {
+  using MQMarketStream = events::message_queues::MarketStream;
+  using MQOrderBookStream = events::message_queues::OrderBookStream;
+
+  // Given
+  events::EventHub<MQMarketStream> market_stream_event_hub;
+  events::EventHub<MQOrderBookStream> order_book_event_hub;
+  analyzer::OrderBookSnapshotProvider ob_provider(market_stream_event_hub.CreateHandler(),
+                                                  order_book_event_hub.dispatcher(),
+                                                  nullptr);
+  const auto initial_snapshot = ob_provider.GetSnapshot();
+  auto next_snapshot_future = std::async(std::launch::async, [&]() {
+    return ob_provider.GetNextSnapshot(initial_snapshot->version());
+  });
+  market_stream::types::OrderBook update;
+  update.received_timestamp = 123466;
+  update.bids = {{121, 3.5}, {120, 22}};
+  update.asks = {{122.2, 443.45}};
+
+  // When
+  market_stream_event_hub.dispatcher().lock()->DispatchEvent<
+      MQMarketStream::Event::kOrderBookUpdateEvent>(update);
+  const auto next_snapshot = next_snapshot_future.get();
+  update.received_timestamp = 123566;
+  update.bids = {{121, 0.0}};
+  market_stream_event_hub.dispatcher().lock()->DispatchEvent<
+      MQMarketStream::Event::kOrderBookUpdateEvent>(update);
+  const auto last_snapshot = ob_provider.GetSnapshot(123566);
+  market_stream_event_hub.Shutdown();
+  order_book_event_hub.Shutdown();
+
+  // Then
+  EXPECT_TRUE(initial_snapshot->order_book().bids.empty());
+  EXPECT_EQ(next_snapshot->version(), initial_snapshot->version() + 1);
+  EXPECT_EQ(next_snapshot->received_timestamp(), 123466);
+  EXPECT_EQ(next_snapshot->order_book().bids.size(), 2);
+  EXPECT_EQ(last_snapshot->version(), next_snapshot->version() + 1);
+  EXPECT_EQ(last_snapshot->order_book().bids.size(), 1);
+  EXPECT_EQ(last_snapshot->columns().bids.size(), 1);
+}
+
+TEST(OrderBookSnapshotProvider,
+     GivenDepthRequested_WhenDeepLevelUpdated_ThenOnlyDepthEventSent) {
+  using MQMarketStream = events::message_queues::MarketStream;
+  using MQOrderBookStream = events::message_queues::OrderBookStream;
+
+  // Given
+  events::EventHub<MQMarketStream> market_stream_event_hub;
+  events::EventHub<MQOrderBookStream> order_book_event_hub;
+  analyzer::OrderBookSnapshotProvider ob_provider(market_stream_event_hub.CreateHandler(),
+                                                  order_book_event_hub.dispatcher(),
+                                                  nullptr);
+  ob_provider.RequestDepthLevels(3);
+  ob_provider.RequestDepthLevels(2);
+  std::vector<market_stream::types::BestBidOffer> best_bid_offers;
+  std::vector<market_stream::types::OrderBookDepth> depths;
+  order_book_event_hub.CreateHandler().lock()->Subscribe(
+      [&](MQOrderBookStream::Event event, const void* data) {
+        if (MQOrderBookStream::Event::kBestBidOfferChanged == event) {
+          best_bid_offers.push_back(
+              *static_cast<const market_stream::types::BestBidOffer*>(data));
+        } else {
+          depths.push_back(
+              *static_cast<const market_stream::types::OrderBookDepth*>(data));
+        }
+      },
+      {MQOrderBookStream::Event::kBestBidOfferChanged,
+       MQOrderBookStream::Event::kDepthChanged});
+  const auto dispatch_update = [&](const market_stream::types::OrderBook& update) {
+    market_stream_event_hub.dispatcher().lock()->DispatchEvent<
+        MQMarketStream::Event::kOrderBookUpdateEvent>(update);
+    market_stream_event_hub.WaitForAllEventsProcessed();
+  };
+  market_stream::types::OrderBook update;
+  update.bids = {{121, 3.5}, {120, 22}, {119, 1}, {118, 4}};
+  update.asks = {{122.2, 443.45}};
+
+  // When
+  dispatch_update(update);
+  update.bids = {{118, 5}};
+  update.asks = {};
+  dispatch_update(update);
+  update.bids = {{119, 2}};
+  dispatch_update(update);
+  update.bids = {{121, 1}};
+  dispatch_update(update);
+  market_stream_event_hub.Shutdown();
+  order_book_event_hub.Shutdown();
+
+  // Then
+  ASSERT_EQ(best_bid_offers.size(), 2);
+  EXPECT_EQ(best_bid_offers[0].bid, market_stream::types::OrderBook::Item(121, 3.5));
+  EXPECT_EQ(best_bid_offers[0].ask, market_stream::types::OrderBook::Item(122.2, 443.45));
+  EXPECT_EQ(best_bid_offers[1].bid, market_stream::types::OrderBook::Item(121, 1));
+  ASSERT_EQ(depths.size(), 3);
+  EXPECT_EQ(depths[0].bids,
+            market_stream::types::OrderBook::Items({{121, 3.5}, {120, 22}, {119, 1}}));
+  EXPECT_EQ(depths[0].asks, market_stream::types::OrderBook::Items({{122.2, 443.45}}));
+  EXPECT_EQ(depths[1].bids,
+            market_stream::types::OrderBook::Items({{121, 3.5}, {120, 22}, {119, 2}}));
+  EXPECT_EQ(depths[2].bids.front(), market_stream::types::OrderBook::Item(121, 1));
+}
+
+TEST(OrderBookSnapshotProvider,
+     GivenLazyDiffMode_WhenDiffsNotRead_ThenMergedOnceOnGetSnapshot) {
+  using MQMarketStream = events::message_queues::MarketStream;
+  using MQOrderBookStream = events::message_queues::OrderBookStream;
+
+  // Given
+  events::EventHub<MQMarketStream> market_stream_event_hub;
+  events::EventHub<MQOrderBookStream> order_book_event_hub;
+  analyzer::OrderBookSnapshotProvider ob_provider(
+      market_stream_event_hub.CreateHandler(), order_book_event_hub.dispatcher(),
+      nullptr, true, OrderBookDiffMode::kLazy);
+  const auto dispatch_update = [&](const market_stream::types::OrderBook& update) {
+    market_stream_event_hub.dispatcher().lock()->DispatchEvent<
+        MQMarketStream::Event::kOrderBookUpdateEvent>(update);
+  };
+  market_stream::types::OrderBook update;
+  update.received_timestamp = 100;
+  update.bids = {{121, 3.5}, {120, 22}};
+  update.asks = {{122.2, 443.45}};
+  dispatch_update(update);
+  update.received_timestamp = 101;
+  update.bids = {{121, 0.0}, {119, 1}};
+  update.asks = {{122.2, 1}, {123, 2}};
+  dispatch_update(update);
+  market_stream_event_hub.WaitForAllEventsProcessed();
+
+  // When
+  const auto snapshot = ob_provider.GetSnapshot(101);
+  auto next_snapshot_future = std::async(std::launch::async, [&]() {
+    return ob_provider.GetNextSnapshot(snapshot->version());
+  });
+  update.received_timestamp = 102;
+  update.bids = {{118, 4}};
+  update.asks = {};
+  dispatch_update(update);
+  const auto next_snapshot = next_snapshot_future.get();
+  market_stream_event_hub.Shutdown();
+  order_book_event_hub.Shutdown();
+
+  // Then
+  EXPECT_EQ(snapshot->version(), 1);
+  EXPECT_EQ(snapshot->received_timestamp(), 101);
+  EXPECT_EQ(snapshot->order_book().bids,
+            market_stream::types::OrderBook::Items({{120, 22}, {119, 1}}));
+  EXPECT_EQ(snapshot->order_book().asks,
+            market_stream::types::OrderBook::Items({{122.2, 1}, {123, 2}}));
+  EXPECT_EQ(next_snapshot->version(), 2);
+  EXPECT_EQ(next_snapshot->order_book().bids.size(), 3);
+}
+
+TEST(OrderBookSnapshotProvider,
+     GivenNoSnapshotReaders_WhenBookUpdated_ThenSnapshotBuiltOnceOnGetSnapshot) {
+  using MQMarketStream = events::message_queues::MarketStream;
+  using MQOrderBookStream = events::message_queues::OrderBookStream;
+
+  // Given
+  events::EventHub<MQMarketStream> market_stream_event_hub;
+  events::EventHub<MQOrderBookStream> order_book_event_hub;
+  analyzer::OrderBookSnapshotProvider ob_provider(market_stream_event_hub.CreateHandler(),
+                                                  order_book_event_hub.dispatcher(),
+                                                  nullptr, false);
+  market_stream::types::OrderBook update;
+  update.received_timestamp = 100;
+  update.bids = {{121, 3.5}, {120, 22}};
+  update.asks = {{122.2, 443.45}};
+
+  // When
+  for (int i = 0; i < 3; i++) {
+    update.received_timestamp++;
+    market_stream_event_hub.dispatcher().lock()->DispatchEvent<
+        MQMarketStream::Event::kOrderBookUpdateEvent>(update);
+  }
+  market_stream_event_hub.WaitForAllEventsProcessed();
+  const auto built_snapshot = ob_provider.GetBuiltSnapshot();
+  const auto snapshot = ob_provider.GetSnapshot();
+  const auto same_snapshot = ob_provider.GetSnapshot();
+  market_stream_event_hub.Shutdown();
+  order_book_event_hub.Shutdown();
+
+  // Then
+  EXPECT_EQ(built_snapshot->version(), 0);
+  EXPECT_EQ(snapshot->version(), 3);
+  EXPECT_EQ(snapshot->received_timestamp(), 103);
+  EXPECT_EQ(same_snapshot, snapshot);
+}
+
+TEST(OrderBookSnapshotProvider,
+     GivenReaderCopyingPublishedBook_WhenBookUpdated_ThenWriterNotBlocked) {
+  using MQMarketStream = events::message_queues::MarketStream;
+  using MQOrderBookStream = events::message_queues::OrderBookStream;
+
+  // Given
+  events::EventHub<MQMarketStream> market_stream_event_hub;
+  events::EventHub<MQOrderBookStream> order_book_event_hub;
+  analyzer::OrderBookSnapshotProvider ob_provider(market_stream_event_hub.CreateHandler(),
+                                                  order_book_event_hub.dispatcher(),
+                                                  nullptr, false);
+  const auto dispatch_update = [&](const market_stream::types::OrderBook& update) {
+    market_stream_event_hub.dispatcher().lock()->DispatchEvent<
+        MQMarketStream::Event::kOrderBookUpdateEvent>(update);
+  };
+  market_stream::types::OrderBook update;
+  update.received_timestamp = 100;
+  for (int i = 0; i < 1000; i++) {
+    update.bids.emplace_back(1000 - i, 1);
+    update.asks.emplace_back(1001 + i, 1);
+  }
+  dispatch_update(update);
+  market_stream_event_hub.WaitForAllEventsProcessed();
+  // The reader is in the middle of a build, the book it copies from is taken
+  const auto book = ob_provider.GetPublishedBook();
+  market_stream::types::OrderBook::Items bids;
+  book->levels.bids.CopyTo(&bids, 500);
+
+  // When
+  for (int i = 0; i < 100; i++) {
+    update.received_timestamp++;
+    update.bids = {{1000.0 - i, 2}, {500.0 - i, 0.0}};
+    update.asks = {{1001.0 + i * 10, 0.0}};
+    dispatch_update(update);
+  }
+  market_stream_event_hub.WaitForAllEventsProcessed();
+  market_stream::types::OrderBook::Items asks;
+  book->levels.asks.CopyTo(&asks);
+  const auto snapshot = ob_provider.GetSnapshot();
+  market_stream_event_hub.Shutdown();
+  order_book_event_hub.Shutdown();
+
+  // Then
+  EXPECT_EQ(book->version, 1);
+  EXPECT_EQ(bids.size(), 500);
+  EXPECT_EQ(bids[10], market_stream::types::OrderBook::Item(990, 1));
+  EXPECT_EQ(asks.size(), 1000);
+  EXPECT_EQ(snapshot->version(), 101);
+  EXPECT_EQ(snapshot->received_timestamp(), 200);
+  EXPECT_EQ(snapshot->order_book().bids.size(), 900);
+  EXPECT_EQ(snapshot->order_book().bids[10], market_stream::types::OrderBook::Item(990, 2));
+  EXPECT_EQ(snapshot->order_book().asks.size(), 900);
+}
+
+TEST(OrderBookSnapshotProvider,
+     GivenDeepBook_WhenDiffApplied_ThenAnalyticsFromEngineTotals) {
+  using MQMarketStream = events::message_queues::MarketStream;
+  using MQOrderBookStream = events::message_queues::OrderBookStream;
+
+  // Given
+  events::EventHub<MQMarketStream> market_stream_event_hub;
+  events::EventHub<MQOrderBookStream> order_book_event_hub;
+  analyzer::OrderBookSnapshotProvider ob_provider(market_stream_event_hub.CreateHandler(),
+                                                  order_book_event_hub.dispatcher(),
+                                                  nullptr, false);
+  const auto dispatch_update = [&](const market_stream::types::OrderBook& update) {
+    market_stream_event_hub.dispatcher().lock()->DispatchEvent<
+        MQMarketStream::Event::kOrderBookUpdateEvent>(update);
+  };
+  market_stream::types::OrderBook update;
+  update.received_timestamp = 100;
+  // Deep enough to be kept in several chunks by the engine
+  for (int i = 0; i < 300; i++) {
+    update.bids.emplace_back(1000 - i, 0.5);
+    update.asks.emplace_back(1001 + i, 0.1 * (i % 7 + 1));
+  }
+  dispatch_update(update);
+
+  // When
+  update.received_timestamp = 101;
+  update.bids = {{1000, 1.5}, {990, 0.0}, {850.5, 0.25}};
+  update.asks = {{1001, 0.0}};
+  dispatch_update(update);
+  market_stream_event_hub.WaitForAllEventsProcessed();
+  const auto snapshot = ob_provider.GetSnapshot(101);
+  const auto book = ob_provider.GetPublishedBook();
+  market_stream_event_hub.Shutdown();
+  order_book_event_hub.Shutdown();
+
+  // Then
+  const auto& analytics = snapshot->analytics();
+  EXPECT_EQ(book->version, snapshot->version());
+  EXPECT_EQ(analytics.bids().size(), 300);
+  EXPECT_DOUBLE_EQ(analytics.bids().Depth(2), 2);
+  EXPECT_DOUBLE_EQ(analytics.bids().Depth(300), 150.75);
+  EXPECT_DOUBLE_EQ(*analytics.bids().CostToFill(2), 1000 * 1.5 + 999 * 0.5);
+  EXPECT_EQ(analytics.asks().size(), 299);
+  EXPECT_DOUBLE_EQ(*analytics.asks().CostToFill(0.2), 1002 * 0.2);
+  // Same totals as kept in the published book, so not calculated again by the
+  // snapshot, and close to the ones calculated level by level
+  const OrderBookAnalytics calculated(&snapshot->order_book());
+  OrderBookSideTotals bids_totals, asks_totals;
+  book->levels.bids.CopyTotalsTo(&bids_totals);
+  book->levels.asks.CopyTotalsTo(&asks_totals);
+  const auto expect_engine_totals = [](const OrderBookSideAnalytics& side,
+                                       const OrderBookSideAnalytics& calculated_side,
+                                       const OrderBookSideTotals& totals) {
+    ASSERT_EQ(side.size(), totals.size());
+    for (std::size_t level = 1; level <= totals.size(); level++) {
+      const auto depth = side.Depth(level);
+      const auto calculated_depth = calculated_side.Depth(level);
+      const auto calculated_cost = *calculated_side.CostToFill(calculated_depth);
+      ASSERT_EQ(depth, totals[level - 1].quantity);
+      ASSERT_NEAR(depth, calculated_depth, depth * 1e-12);
+      ASSERT_NEAR(totals[level - 1].notional, calculated_cost, calculated_cost * 1e-12);
+    }
+  };
+  expect_engine_totals(analytics.bids(), calculated.bids(), bids_totals);
+  expect_engine_totals(analytics.asks(), calculated.asks(), asks_totals);
+}
+
+TEST(OrderBookSnapshotProvider,
+     GivenSnapshotSubscribers_WhenBookUpdated_ThenSnapshotBookShared) {
+  using MQMarketStream = events::message_queues::MarketStream;
+  using MQOrderBookStream = events::message_queues::OrderBookStream;
+
+  // Given
+  events::EventHub<MQMarketStream> market_stream_event_hub;
+  events::EventHub<MQOrderBookStream> order_book_event_hub;
+  analyzer::OrderBookSnapshotProvider ob_provider(market_stream_event_hub.CreateHandler(),
+                                                  order_book_event_hub.dispatcher(),
+                                                  nullptr, false);
+  std::vector<const void*> received_books(2, nullptr);
+  for (auto& it : received_books) {
+    order_book_event_hub.CreateHandler().lock()->Subscribe(
+        [&it](MQOrderBookStream::Event event, const void* data) { it = data; },
+        {MQOrderBookStream::Event::kNewSnapshotAvailable});
+  }
+  market_stream::types::OrderBook update;
+  update.received_timestamp = 100;
+  update.bids = {{121, 3.5}, {120, 22}};
+  update.asks = {{122.2, 443.45}};
+
+  // When
+  market_stream_event_hub.dispatcher().lock()->DispatchEvent<
+      MQMarketStream::Event::kOrderBookUpdateEvent>(update);
+  market_stream_event_hub.WaitForAllEventsProcessed();
+  order_book_event_hub.WaitForAllEventsProcessed();
+  const auto snapshot = ob_provider.GetSnapshot();
+  market_stream_event_hub.Shutdown();
+  order_book_event_hub.Shutdown();
+
+  // Then
+  EXPECT_EQ(snapshot->version(), 1);
+  EXPECT_EQ(received_books[0], &snapshot->order_book());
+  EXPECT_EQ(received_books[1], &snapshot->order_book());
+}
+
+TEST(OrderBookSnapshotProvider, GivenKeptHistory_WhenBookUpdated_ThenOlderBookQueried) {
+  using MQMarketStream = events::message_queues::MarketStream;
+  using MQOrderBookStream = events::message_queues::OrderBookStream;
+
+  // Given
+  events::EventHub<MQMarketStream> market_stream_event_hub;
+  events::EventHub<MQOrderBookStream> order_book_event_hub;
+  analyzer::OrderBookSnapshotProvider ob_provider(market_stream_event_hub.CreateHandler(),
+                                                  order_book_event_hub.dispatcher(),
+                                                  nullptr);
+  ob_provider.KeepHistory(std::chrono::seconds(10));
+  market_stream::types::OrderBook update;
+  update.received_timestamp = 100;
+  update.bids = {{121, 3.5}, {120, 22}};
+  update.asks = {{122.2, 443.45}};
+
+  // When
+  market_stream_event_hub.dispatcher().lock()->DispatchEvent<
+      MQMarketStream::Event::kOrderBookUpdateEvent>(update);
+  update.received_timestamp = 200;
+  update.bids = {{121, 0.0}};
+  market_stream_event_hub.dispatcher().lock()->DispatchEvent<
+      MQMarketStream::Event::kOrderBookUpdateEvent>(update);
+  ob_provider.GetSnapshot(200);
+  market_stream_event_hub.Shutdown();
+  order_book_event_hub.Shutdown();
+
+  // Then
+  EXPECT_FALSE(ob_provider.GetSnapshotAt(99));
+  EXPECT_EQ(ob_provider.GetSnapshotAt(150)->bids,
+            market_stream::types::OrderBook::Items({{121, 3.5}, {120, 22}}));
+  EXPECT_EQ(ob_provider.GetTopNAt(200, 1)->bids,
+            market_stream::types::OrderBook::Items({{120, 22}}));
+}
+
+TEST(OrderBookSnapshotProvider, GivenBufferedDiffs_WhenResync_ThenBookReplaced) {
+  using MQMarketStream = events::message_queues::MarketStream;
+  using MQOrderBookStream = events::message_queues::OrderBookStream;
+
+  // Given
+  events::EventHub<MQMarketStream> market_stream_event_hub;
+  events::EventHub<MQOrderBookStream> order_book_event_hub;
+  analyzer::OrderBookSnapshotProvider ob_provider(
+      market_stream_event_hub.CreateHandler(), order_book_event_hub.dispatcher(),
+      nullptr, false, OrderBookDiffMode::kLazy);
+  ob_provider.KeepHistory(std::chrono::seconds(10));
+  std::vector<market_stream::types::OrderBookResyncMarker> markers;
+  order_book_event_hub.CreateHandler().lock()->Subscribe(
+      [&markers](MQOrderBookStream::Event event, const void* data) {
+        markers.push_back(
+            *static_cast<const market_stream::types::OrderBookResyncMarker*>(data));
+      },
+      {MQOrderBookStream::Event::kOrderBookResynced});
+  market_stream::types::OrderBook update;
+  update.received_timestamp = 100;
+  update.bids = {{121, 3.5}, {120, 22}};
+  update.asks = {{122.2, 443.45}};
+  market_stream_event_hub.dispatcher().lock()->DispatchEvent<
+      MQMarketStream::Event::kOrderBookUpdateEvent>(update);
+  market_stream_event_hub.WaitForAllEventsProcessed();
+  const auto snapshot = ob_provider.GetSnapshot();
+  update.received_timestamp = 101;
+  update.bids = {{119, 1}};
+  update.asks = {};
+  market_stream_event_hub.dispatcher().lock()->DispatchEvent<
+      MQMarketStream::Event::kOrderBookUpdateEvent>(update);
+
+  // When
+  market_stream::types::OrderBookResync resync;
+  resync.order_book.timestamp = 150;
+  resync.order_book.received_timestamp = 200;
+  resync.order_book.bids = {{120, 2}};
+  resync.order_book.asks = {{123, 1}};
+  market_stream_event_hub.dispatcher().lock()->DispatchEvent<
+      MQMarketStream::Event::kOrderBookResyncEvent>(resync);
+  market_stream_event_hub.WaitForAllEventsProcessed();
+  order_book_event_hub.WaitForAllEventsProcessed();
+  const auto resynced_snapshot = ob_provider.GetSnapshot();
+  market_stream_event_hub.Shutdown();
+  order_book_event_hub.Shutdown();
+
+  // Then
+  EXPECT_EQ(resynced_snapshot->version(), snapshot->version() + 1);
+  EXPECT_EQ(resynced_snapshot->order_book(), resync.order_book);
+  ASSERT_EQ(markers.size(), 1);
+  EXPECT_EQ(markers[0].timestamp, 150);
+  EXPECT_EQ(markers[0].received_timestamp, 200);
+  EXPECT_EQ(ob_provider.GetSnapshotAt(150)->bids,
+            market_stream::types::OrderBook::Items({{121, 3.5}, {120, 22}}));
+  EXPECT_EQ(*ob_provider.GetSnapshotAt(200), resync.order_book);
 }
 
-}  // namespace analyzer
\ No newline at end of file
+}  // namespace analyzer
@@ -1,15 +1,21 @@
 #include <gmock/gmock.h>
 
 #include <chrono>
+#include <functional>
 #include <future>
 #include <thread>
+#include <utility>
+#include <vector>
 
 #include "analyzer/benchmark_data_collector.h"
 #include "analyzer/benchmark_orchestrator.h"
 #include "analyzer/order_manager.h"
 #include "analyzer/order_plan_manager.h"
+#include "analyzer/real_market_emulator.h"
 #include "analyzer/types/types.h"
 #include "events/event_hub.h"
+#include "events/inline_event_loop.h"
+#include "market_stream/saved_market_stream_forwarder.h"
 #include "utils/tests/helpers/scoped_logger.h"
 #include "utils/tests/helpers/unit_state_mock.h"
 #include "utils/time/global_clock.h"
@@ -33,6 +39,29 @@ class MockBenchmarkDataCollector : public BenchmarkDataCollector {
               (override));
 };
 
+// Forwards the given items, each one calls its function when forwarded
+class ScriptedMarketStreamForwarder : public market_stream::SavedMarketStreamForwarder {
+ public:
+  using Item = std::pair<utils::Timestamp, std::function<void()>>;
+
+  ScriptedMarketStreamForwarder(std::vector<Item>&& items)
+      : SavedMarketStreamForwarder("", {}), items_(std::move(items)) {}
+
+  void Initialize() override {}
+  bool ReadNext(utils::Timestamp* next_data_ts) override {
+    if (items_.size() == next_item_) {
+      return false;
+    }
+    *next_data_ts = items_[next_item_].first;
+    return true;
+  }
+  void ForwardNext() override { items_[next_item_++].second(); }
+
+ private:
+  std::vector<Item> items_;
+  std::size_t next_item_{0};
+};
+
 class OrderPlanManagerFixture : public ::testing::Test {
   using MQ = events::message_queues::AnalyzerStream;
   using EventHubHandler = events::EventHub<MQ>::Handler;
@@ -349,4 +378,163 @@ TEST_F(OrderPlanManagerFixture,
   // Then
   EXPECT_NE(logger.str().find("OrderPlan processing finishe"), std::string::npos);
 }
-}  // namespace analyzer
\ No newline at end of file
+
+TEST(OrderPlanManager,
+     GivenInlineEventLoop_WhenSellExperied_ThenPlanProcessedOnLoopThreadOnly) {
+  using MQ = events::message_queues::AnalyzerStream;
+
+  // Given
+  auto mock_time_provider = std::make_shared<utils::MockTimeProvider>(0);
+  utils::GlobalClock::Instance().SetTimeProvider(mock_time_provider);
+  auto inline_event_loop = std::make_shared<events::InlineEventLoop>();
+  events::EventHubOptions options;
+  options.queue_type = events::QueueType::kInline;
+  options.inline_event_loop = inline_event_loop;
+  events::EventHub<MQ> event_hub(options);
+  auto unit_state = std::make_shared<
+      testing::NiceMock<MockUnitState<ObservableUnits::UnitId::kOrderPlanManager>>>();
+  auto order_manager = std::make_shared<MockOrderManager>();
+  auto benchmark_data_collector = std::make_shared<MockBenchmarkDataCollector>();
+  OrderPlanManager order_plan_manager(event_hub.CreateHandler(), order_manager,
+                                      unit_state, benchmark_data_collector,
+                                      inline_event_loop);
+
+  types::OrderPlanInfo order_plan;
+  order_plan.expiration_ts = 1000000;
+  order_plan.expiration_buy_ts = 1000000;
+  order_plan.expiration_sell_ts = 500000;
+  order_plan.max_buy_price = 12.34;
+  order_plan.min_sell_price = 13.34;
+
+  types::OrderResponse<std::promise> buy_responce_gen;
+  types::OrderResponse<std::promise> sell_responce_gen;
+  types::OrderResponse<std::promise> market_sell_responce_gen;
+  std::vector<std::thread::id> calling_threads;
+  auto make_responce = [&](types::OrderResponse<std::promise>& responce_gen,
+                           uint64_t order_id) {
+    calling_threads.push_back(std::this_thread::get_id());
+    types::OrderResponse<std::future> responce;
+    responce.order_id = responce_gen.order_id.get_future();
+    responce.order_result = responce_gen.order_result.get_future();
+    responce_gen.order_id.set_value(order_id);
+    return responce;
+  };
+
+  testing::Sequence seq;
+  EXPECT_CALL(*order_manager, PlaceOrder(testing::Field(&types::OrderInfo::side,
+                                                        types::OrderInfo::Side::BUY)))
+      .InSequence(seq)
+      .WillOnce([&]() { return make_responce(buy_responce_gen, 1); });
+  EXPECT_CALL(*order_manager, PlaceOrder(testing::Field(&types::OrderInfo::type,
+                                                        types::OrderInfo::Type::LIMIT)))
+      .InSequence(seq)
+      .WillOnce([&]() { return make_responce(sell_responce_gen, 2); });
+  EXPECT_CALL(*order_manager, CancelOrder(2)).InSequence(seq).WillOnce([&]() {
+    types::OrderResult result;
+    result.status = types::OrderResult::Status::kCanceled;
+    sell_responce_gen.order_result.set_value(result);
+  });
+  EXPECT_CALL(*order_manager, PlaceOrder(testing::Field(&types::OrderInfo::type,
+                                                        types::OrderInfo::Type::MARKET)))
+      .InSequence(seq)
+      .WillOnce([&]() {
+        auto responce = make_responce(market_sell_responce_gen, 3);
+        types::OrderResult result;
+        result.status = types::OrderResult::Status::kOk;
+        result.price = 13.00;
+        market_sell_responce_gen.order_result.set_value(result);
+        return responce;
+      });
+
+  types::OrderPlanReport expected_report;
+  expected_report.buy_price = 11.34;
+  expected_report.sold_price = 13.00;
+  expected_report.status = types::OrderPlanReport::Status::kFailedToProfitSell;
+  EXPECT_CALL(*benchmark_data_collector, AddOrderPlanReport(expected_report));
+
+  // When
+  event_hub.dispatcher().lock()->DispatchEvent<MQ::Event::kNewOrderPlan>(order_plan);
+  inline_event_loop->RunUntilIdle();
+  // Buy order is not filled yet, polled again by the next run
+  inline_event_loop->RunUntilIdle();
+  types::OrderResult buy_result;
+  buy_result.status = types::OrderResult::Status::kOk;
+  buy_result.price = 11.34;
+  buy_responce_gen.order_result.set_value(buy_result);
+  inline_event_loop->RunUntilIdle();
+  mock_time_provider->JumpToTime(order_plan.expiration_sell_ts);
+  inline_event_loop->RunUntilIdle();
+  inline_event_loop->RunUntilIdle();
+
+  // Then
+  EXPECT_THAT(calling_threads, ::testing::Each(std::this_thread::get_id()));
+  EXPECT_EQ(calling_threads.size(), 3);
+  event_hub.Shutdown();
+}
+
+TEST(OrderPlanManager,
+     GivenInlineEventLoop_WhenBuyCrossedAfterExpiration_ThenFailedToBuy) {
+  using MQ = events::message_queues::AnalyzerStream;
+  using MQOrderBookStream = events::message_queues::OrderBookStream;
+
+  // Given
+  auto inline_event_loop = std::make_shared<events::InlineEventLoop>();
+  events::EventHubOptions options;
+  options.queue_type = events::QueueType::kInline;
+  options.inline_event_loop = inline_event_loop;
+  events::EventHub<MQ> event_hub(options);
+  events::EventHub<MQOrderBookStream> order_book_event_hub(options);
+  auto market_emulator = std::make_shared<RealMarketEmulator>(
+      order_book_event_hub.CreateHandler(),
+      std::make_shared<testing::NiceMock<
+          MockUnitState<ObservableUnits::UnitId::kRealMarketEmulator>>>());
+  auto order_manager = std::make_shared<OrderManager>(
+      market_emulator,
+      std::make_shared<
+          testing::NiceMock<MockUnitState<ObservableUnits::UnitId::kOrderManager>>>());
+  auto benchmark_data_collector = std::make_shared<MockBenchmarkDataCollector>();
+  OrderPlanManager order_plan_manager(
+      event_hub.CreateHandler(), order_manager,
+      std::make_shared<
+          testing::NiceMock<MockUnitState<ObservableUnits::UnitId::kOrderPlanManager>>>(),
+      benchmark_data_collector, inline_event_loop);
+
+  types::OrderPlanInfo order_plan;
+  order_plan.expiration_ts = 10000;
+  order_plan.expiration_buy_ts = 2000;
+  order_plan.expiration_sell_ts = 5000;
+  order_plan.max_buy_price = 12.34;
+  order_plan.min_sell_price = 13.34;
+  const auto dispatch_best_bid_offer = [&](double bid, double ask) {
+    market_stream::types::BestBidOffer best_bid_offer;
+    best_bid_offer.bid = {bid, 1};
+    best_bid_offer.ask = {ask, 1};
+    order_book_event_hub.dispatcher()
+        .lock()
+        ->DispatchEvent<MQOrderBookStream::Event::kBestBidOfferChanged>(best_bid_offer);
+  };
+  auto forwarder = std::make_shared<ScriptedMarketStreamForwarder>(
+      std::vector<ScriptedMarketStreamForwarder::Item>{
+          {1000,
+           [&]() {
+             dispatch_best_bid_offer(20, 21);
+             event_hub.dispatcher().lock()->DispatchEvent<MQ::Event::kNewOrderPlan>(
+                 order_plan);
+           }},
+          // The first best bid the buy order crosses comes after it expired
+          {3000, [&]() { dispatch_best_bid_offer(12, 13); }}});
+  BenchmarkOrchestrator benchmark_orchestrator(forwarder, true, inline_event_loop);
+
+  types::OrderPlanReport expected_report;
+  expected_report.status = types::OrderPlanReport::Status::kFailedToBuy;
+  EXPECT_CALL(*benchmark_data_collector, AddOrderPlanReport(expected_report));
+
+  // When
+  benchmark_orchestrator.Go();
+
+  // Then
+  EXPECT_EQ(market_emulator->orders_count(), 0);
+  event_hub.Shutdown();
+  order_book_event_hub.Shutdown();
+}
+}  // namespace analyzer
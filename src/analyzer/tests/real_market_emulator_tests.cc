@@ -59,8 +59,13 @@ class RealMarketEmulatorFixture : public ::testing::Test {
   void TearDown() override { event_hub_.Shutdown(); }
 
   void SendOrderBookSnapshot(const market_stream::types::OrderBook& order_book) {
-    event_hub_.dispatcher().lock()->DispatchEvent<MQ::Event::kNewSnapshotAvailable>(
-        order_book);
+    market_stream::types::BestBidOffer best_bid_offer;
+    best_bid_offer.timestamp = order_book.timestamp;
+    best_bid_offer.received_timestamp = order_book.received_timestamp;
+    best_bid_offer.bid = order_book.bids.front();
+    best_bid_offer.ask = order_book.asks.front();
+    event_hub_.dispatcher().lock()->DispatchEvent<MQ::Event::kBestBidOfferChanged>(
+        best_bid_offer);
     event_hub_.WaitForAllEventsProcessed();
   }
 
@@ -216,6 +221,41 @@ TEST_F(RealMarketEmulatorFixture,
   EXPECT_EQ(real_market_emulator_->orders_count(), 0);
 }
 
+TEST_F(RealMarketEmulatorFixture,
+       GivenSteadyBestPrices_WhenCrossingLimitOrderPlaced_ThenFilledAtOnce) {
+  // Given
+  testing::Sequence unit_state_seq;
+  for (int i = 0; i < 1 + 4 + 2; i++) {  // 1 Snapshot, 4 PlaceOrder, 2 orders_count
+    EXPECT_CALL(*unit_state_, SetBusy()).InSequence(unit_state_seq);
+    EXPECT_CALL(*unit_state_, SetReady()).InSequence(unit_state_seq);
+  }
+  SendOrderBookSnapshot(order_book1_);
+  EXPECT_EQ(real_market_emulator_->orders_count(), 0);
+
+  // When
+  order_1.second = real_market_emulator_->PlaceOrder(order_1.first);
+  order_2.second = real_market_emulator_->PlaceOrder(order_2.first);
+  order_3.second = real_market_emulator_->PlaceOrder(order_3.first);
+  order_4.second = real_market_emulator_->PlaceOrder(order_4.first);
+
+  // Then
+  ASSERT_EQ(order_1.second.order_result.wait_for(std::chrono::seconds(0)),
+            std::future_status::ready);
+  auto result1 = order_1.second.order_result.get();
+  EXPECT_EQ(result1.status, types::OrderResult::Status::kOk);
+  EXPECT_EQ(result1.price, order_1.first.price);
+  ASSERT_EQ(order_2.second.order_result.wait_for(std::chrono::seconds(0)),
+            std::future_status::ready);
+  auto result2 = order_2.second.order_result.get();
+  EXPECT_EQ(result2.status, types::OrderResult::Status::kOk);
+  EXPECT_EQ(result2.price, order_2.first.price);
+  EXPECT_NE(order_3.second.order_result.wait_for(std::chrono::seconds(0)),
+            std::future_status::ready);
+  EXPECT_NE(order_4.second.order_result.wait_for(std::chrono::seconds(0)),
+            std::future_status::ready);
+  EXPECT_EQ(real_market_emulator_->orders_count(), 2);
+}
+
 TEST_F(RealMarketEmulatorFixture, GivenPlacedOrders_WhenCancelOrder_ThenOrdersCanceled) {
   // Given
   testing::Sequence unit_state_seq;
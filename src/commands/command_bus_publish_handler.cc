@@ -0,0 +1,102 @@
+#include "commands/command_bus_publish_handler.h"
+
+#include <spdlog/spdlog.h>
+
+#include <iostream>
+#include <thread>
+
+#include "analyzer/order_book_snapshot_provider.h"
+#include "events/event_hub.h"
+#include "events/shm_bus.h"
+#include "market_stream/market_stream_forwarder.h"
+
+namespace commands {
+
+namespace {
+const auto gSymbolOptionName = "symbol";
+const auto gBusNameOptionName = "bus-name";
+const auto gDurationOptionName = "duration";
+const auto gStateDirOptionName = "state-dir";
+
+// Snapshots, the first REST depth book and resync books hold the whole book, so
+// both rings need slots of events::kBookShmBusSlotSize. Updates are much more
+// frequent than snapshots, so the MarketStream ring keeps more of them.
+const std::size_t gMarketStreamBusCapacity = 256;
+const std::size_t gSnapshotsBusCapacity = 64;
+}  // namespace
+
+CommandBusPublishHandler::CommandBusPublishHandler(int argc, const char* argv[]) {
+  spdlog::info("command parsing...");
+  po::variables_map opts_map;
+  try {
+    // clang-format off
+    po::options_description command_options;
+    command_options.add_options()
+      (gSymbolOptionName, po::value<std::string>()->required(), "Symbol (e.g., BTCUSDT)")
+      (gBusNameOptionName, po::value<std::string>()->default_value(""), "Bus name, terry.<symbol> if not set")
+      (gDurationOptionName, po::value<int>()->required(), "Timer duration value in seconds")
+      (gStateDirOptionName, po::value<std::string>()->default_value(""), "Dir to keep the order book between runs");
+    // clang-format on
+
+    // Parse the options
+    po::options_description all_options;
+    all_options.add(command_options);
+    po::store(po::parse_command_line(argc, argv, all_options), opts_map);
+    po::notify(opts_map);
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  symbol_ = opts_map.at(gSymbolOptionName).as<std::string>();
+  bus_name_ = opts_map.at(gBusNameOptionName).as<std::string>();
+  if (bus_name_.empty()) {
+    bus_name_ = DefaultBusName(symbol_);
+  }
+  duration_ = std::chrono::seconds(opts_map.at(gDurationOptionName).as<int>());
+  state_dir_ = opts_map.at(gStateDirOptionName).as<std::string>();
+  spdlog::info("command pasing finished.");
+}
+
+std::string CommandBusPublishHandler::DefaultBusName(const std::string& symbol) {
+  return "terry." + symbol;
+}
+
+void CommandBusPublishHandler::Run() {
+  spdlog::info("run bus publish command...");
+
+  // MarketStream events are fanned out to several subscribers, share one payload
+  events::EventHubOptions ms_event_hub_options;
+  ms_event_hub_options.dispatch_mode = events::DispatchMode::kSharedPayload;
+  events::EventHub<events::message_queues::MarketStream> ms_event_hub(
+      ms_event_hub_options);
+  events::EventHub<events::message_queues::OrderBookStream> obs_event_hub;
+
+  auto forwarder = std::make_shared<market_stream::MarketStreamForwarder>(
+      symbol_, ms_event_hub.dispatcher(), state_dir_);
+  auto order_book_snap_provider = std::make_shared<analyzer::OrderBookSnapshotProvider>(
+      ms_event_hub.CreateHandler(), obs_event_hub.dispatcher(), nullptr);
+
+  events::ShmBusOptions ms_bus_options;
+  ms_bus_options.capacity = gMarketStreamBusCapacity;
+  ms_bus_options.slot_size = events::kBookShmBusSlotSize;
+  events::ShmBusPublisher<events::message_queues::MarketStream> ms_publisher(
+      ms_event_hub.CreateHandler(), bus_name_, ms_bus_options);
+  events::ShmBusOptions obs_bus_options;
+  obs_bus_options.capacity = gSnapshotsBusCapacity;
+  obs_bus_options.slot_size = events::kBookShmBusSlotSize;
+  events::ShmBusPublisher<events::message_queues::OrderBookStream> obs_publisher(
+      obs_event_hub.CreateHandler(), bus_name_, obs_bus_options);
+
+  forwarder->Initialize();
+  forwarder->StartAsync();
+
+  spdlog::info("bus {} publishing {} market stream.", bus_name_, symbol_);
+  std::this_thread::sleep_for(duration_);
+  spdlog::info("timer finished");
+
+  forwarder->Stop();
+  ms_event_hub.Shutdown();
+  obs_event_hub.Shutdown();
+}
+
+}  // namespace commands
@@ -0,0 +1,164 @@
+#include "commands/command_orderbook_bench_handler.h"
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "analyzer/order_book_engine.h"
+#include "events/event_hub.h"
+#include "market_stream/saved_market_stream_forwarder.h"
+
+namespace commands {
+
+namespace {
+const auto gSavedStreamDirOptionName = "stream-dir";
+const auto gRoundsOptionName = "rounds";
+const std::size_t gMaxOrderBookLevelsHandleCount = 6000;
+
+using Clock = std::chrono::steady_clock;
+
+// Recorded diff, or the fetched book that replaces the book on a resync
+struct RecordedUpdate {
+  market_stream::types::OrderBook order_book;
+  bool is_resync{false};
+};
+using OrderBookUpdates = std::vector<RecordedUpdate>;
+
+market_stream::types::OrderBook MergeAll(const OrderBookUpdates &updates) {
+  // Merge keeps removals of levels behind its last one, the engine never stores them
+  const auto is_removed = [](const market_stream::types::OrderBook::Item &item) {
+    return item.quantity.is_zero();
+  };
+  market_stream::types::OrderBook order_book;
+  for (const auto &it : updates) {
+    if (it.is_resync) {
+      order_book = market_stream::types::OrderBook();
+    }
+    const auto &update = it.order_book;
+    order_book.timestamp = update.timestamp;
+    order_book.received_timestamp = update.received_timestamp;
+    order_book.bids = analyzer::MergeOrderBookItems(order_book.bids, update.bids, false);
+    order_book.asks = analyzer::MergeOrderBookItems(order_book.asks, update.asks, true);
+    order_book.bids.erase(
+        std::remove_if(order_book.bids.begin(), order_book.bids.end(), is_removed),
+        order_book.bids.end());
+    order_book.asks.erase(
+        std::remove_if(order_book.asks.begin(), order_book.asks.end(), is_removed),
+        order_book.asks.end());
+    order_book.bids.resize(
+        std::min(gMaxOrderBookLevelsHandleCount, order_book.bids.size()));
+    order_book.asks.resize(
+        std::min(gMaxOrderBookLevelsHandleCount, order_book.asks.size()));
+  }
+  return order_book;
+}
+
+market_stream::types::OrderBook ApplyAll(const OrderBookUpdates &updates) {
+  analyzer::OrderBookEngine engine(gMaxOrderBookLevelsHandleCount);
+  for (const auto &it : updates) {
+    if (it.is_resync) {
+      analyzer::OrderBookEngine resynced_engine(gMaxOrderBookLevelsHandleCount);
+      engine.Swap(&resynced_engine);
+    }
+    engine.Apply(it.order_book);
+  }
+  market_stream::types::OrderBook order_book;
+  engine.CopyTo(&order_book);
+  return order_book;
+}
+
+// Average ns per diff over all rounds
+template <typename Func>
+double MeasureNsPerUpdate(const OrderBookUpdates &updates, int rounds, Func func,
+                          market_stream::types::OrderBook *result) {
+  const auto start = Clock::now();
+  for (int i = 0; i < rounds; i++) {
+    *result = func(updates);
+  }
+  const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      Clock::now() - start);
+  return static_cast<double>(elapsed.count()) / rounds / updates.size();
+}
+}  // namespace
+
+CommandOrderBookBenchHandler::CommandOrderBookBenchHandler(int argc, const char *argv[]) {
+  spdlog::info("command parsing...");
+  po::variables_map opts_map;
+  try {
+    // clang-format off
+    po::options_description command_options;
+    command_options.add_options()
+      (gSavedStreamDirOptionName, po::value<std::string>()->required(), "Path to the recorded market stream file dir")
+      (gRoundsOptionName, po::value<int>()->default_value(5), "Number of replays of the recorded diffs");
+    // clang-format on
+
+    // Parse the options
+    po::options_description all_options;
+    all_options.add(command_options);
+    po::store(po::parse_command_line(argc, argv, all_options), opts_map);
+    po::notify(opts_map);
+  } catch (const std::exception &e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  saved_stream_dir_ = opts_map.at(gSavedStreamDirOptionName).as<std::string>();
+  rounds_ = std::max(1, opts_map.at(gRoundsOptionName).as<int>());
+  spdlog::info("command parsing finished.");
+}
+
+void CommandOrderBookBenchHandler::Run() {
+  spdlog::info("run order book bench command...");
+  using MQ = events::message_queues::MarketStream;
+
+  OrderBookUpdates updates;
+  {
+    events::EventHub<MQ> event_hub;
+    auto forwarder = std::make_shared<market_stream::SavedMarketStreamForwarder>(
+        saved_stream_dir_, event_hub.dispatcher());
+    forwarder->Initialize();
+    event_hub.CreateHandler().lock()->Subscribe(
+        [&updates](MQ::Event event, const void *data) {
+          if (MQ::Event::kOrderBookResyncEvent == event) {
+            updates.push_back(
+                {static_cast<const market_stream::types::OrderBookResync *>(data)
+                     ->order_book,
+                 true});
+            return;
+          }
+          updates.push_back(
+              {*static_cast<const market_stream::types::OrderBook *>(data), false});
+        },
+        {MQ::Event::kOrderBookUpdateEvent, MQ::Event::kOrderBookResyncEvent});
+    while (forwarder->ReadNext()) {
+      forwarder->ForwardNext();
+    }
+    event_hub.Shutdown();
+  }
+  if (updates.empty()) {
+    std::cout << "no order book updates in the recorded stream" << std::endl;
+    return;
+  }
+
+  market_stream::types::OrderBook merged, applied;
+  const double merge_ns = MeasureNsPerUpdate(updates, rounds_, MergeAll, &merged);
+  const double engine_ns = MeasureNsPerUpdate(updates, rounds_, ApplyAll, &applied);
+
+  std::cout << fmt::format("{} order book diffs, {} rounds", updates.size(), rounds_)
+            << '\n';
+  std::cout << fmt::format("merge:  {:.1f} ns/diff", merge_ns) << '\n';
+  std::cout << fmt::format("engine: {:.1f} ns/diff ({:.1f}x)", engine_ns,
+                           merge_ns / engine_ns)
+            << '\n';
+  if (!(merged == applied)) {
+    std::cout << "final books differ: " << merged.bids.size() << '/'
+              << merged.asks.size() << " levels merged, " << applied.bids.size() << '/'
+              << applied.asks.size() << " levels applied" << '\n';
+  }
+  std::cout << std::flush;
+}
+
+}  // namespace commands
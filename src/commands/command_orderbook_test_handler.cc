@@ -53,7 +53,7 @@ void CommandOrderBookTestHandler::Run() {
   std::shared_ptr<analyzer::OrderBookSnapshotProvider> order_book_snapshot_provider =
       std::make_shared<analyzer::OrderBookSnapshotProvider>(
           market_stream_event_hub.CreateHandler(), order_book_event_hub.dispatcher(),
-          nullptr);
+          nullptr, true, analyzer::OrderBookDiffMode::kLazy);
 
   analyzer::BenchmarkManager benchmark_manager(symbol_, order_book_snapshot_provider);
 
@@ -66,6 +66,7 @@ void CommandOrderBookTestHandler::Run() {
     std::this_thread::sleep_for(std::chrono::seconds(1));
   }
 
+  forwarder->Stop();
   market_stream_event_hub.Shutdown();
 }
 
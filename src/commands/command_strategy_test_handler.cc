@@ -16,6 +16,7 @@
 #include "analyzer/order_plan_manager.h"
 #include "analyzer/real_market_emulator.h"
 #include "events/event_hub.h"
+#include "events/inline_event_loop.h"
 #include "market_stream/saved_market_stream_forwarder.h"
 
 namespace commands {
@@ -23,8 +24,10 @@ namespace commands {
 namespace {
 const auto gStrategyOptionName = "strategy";
 const auto gNoTsJumpOptionName = "no-ts-jump";
+const auto gInlineOptionName = "inline";
 const auto gOutputJsonOptionName = "output-json-dir";
 const auto gInputStreamDirOptionName = "stream-dir";
+const auto gTraceDirOptionName = "trace-dir";
 
 const auto gOutputJsonFileName = "strategy_test_result.json";
 }  // namespace
@@ -41,7 +44,9 @@ CommandStrategyTestHandler::CommandStrategyTestHandler(int argc, const char* arg
       (gInputStreamDirOptionName, po::value<std::string>()->required(), "Path saved market stream to test on")
       (gStrategyOptionName, po::value<std::string>()->required(), "Strategy name")
       (gOutputJsonOptionName, po::value<std::string>(), "Path where to save test result in json")
-      (gNoTsJumpOptionName, po::bool_switch()->default_value(false), "Not use timestamps jumping");
+      (gNoTsJumpOptionName, po::bool_switch()->default_value(false), "Not use timestamps jumping")
+      (gInlineOptionName, po::bool_switch()->default_value(false), "Process all events in one thread, in order they were sent")
+      (gTraceDirOptionName, po::value<std::string>()->default_value(""), "Dir where to keep flight recorder files of event hubs");
     // clang-format on
 
     // Parse the options
@@ -55,6 +60,8 @@ CommandStrategyTestHandler::CommandStrategyTestHandler(int argc, const char* arg
   }
   saved_stream_path_ = opts_map.at(gInputStreamDirOptionName).as<std::string>();
   disable_ts_jump_ = opts_map.at(gNoTsJumpOptionName).as<bool>();
+  inline_events_ = opts_map.at(gInlineOptionName).as<bool>();
+  trace_dir_ = opts_map.at(gTraceDirOptionName).as<std::string>();
 
   output_json_ = (opts_map.find(gOutputJsonOptionName) != opts_map.end());
   if (output_json_) {
@@ -77,9 +84,25 @@ void CommandStrategyTestHandler::Run() {
 
   InitUnitStates();
 
-  events::EventHub<events::message_queues::MarketStream> ms_event_hub;
-  events::EventHub<events::message_queues::OrderBookStream> obs_event_hub;
-  events::EventHub<events::message_queues::AnalyzerStream> as_event_hub;
+  // All hubs share one event loop driven by BenchmarkOrchestrator
+  std::shared_ptr<events::InlineEventLoop> inline_event_loop;
+  events::EventHubOptions event_hub_options;
+  event_hub_options.flight_recorder_dir = trace_dir_;
+  if (inline_events_) {
+    inline_event_loop = std::make_shared<events::InlineEventLoop>();
+    event_hub_options.queue_type = events::QueueType::kInline;
+    event_hub_options.inline_event_loop = inline_event_loop;
+  }
+
+  // MarketStream events are fanned out to several subscribers, share one payload
+  events::EventHubOptions ms_event_hub_options = event_hub_options;
+  ms_event_hub_options.dispatch_mode = events::DispatchMode::kSharedPayload;
+  events::EventHub<events::message_queues::MarketStream> ms_event_hub(
+      ms_event_hub_options);
+  events::EventHub<events::message_queues::OrderBookStream> obs_event_hub(
+      event_hub_options);
+  events::EventHub<events::message_queues::AnalyzerStream> as_event_hub(
+      event_hub_options);
 
   auto benchmark_data_collector = std::make_shared<analyzer::BenchmarkDataCollector>();
 
@@ -89,7 +112,8 @@ void CommandStrategyTestHandler::Run() {
 
   // MS reciever, OBS forwarder
   auto order_book_snap_provider = std::make_shared<analyzer::OrderBookSnapshotProvider>(
-      ms_event_hub.CreateHandler(), obs_event_hub.dispatcher(), snapshot_provider_state_);
+      ms_event_hub.CreateHandler(), obs_event_hub.dispatcher(), snapshot_provider_state_,
+      !inline_events_);
 
   // OBS reciever
   auto market_emulator = std::make_shared<analyzer::RealMarketEmulator>(
@@ -105,13 +129,14 @@ void CommandStrategyTestHandler::Run() {
   auto market_analyzer = std::make_shared<analyzer::MarketAnalyzer>(
       ms_event_hub.CreateHandler(), trading_strategy, analyzer_state_);
 
-  // AS reciever
+  // AS reciever, driven by the shared event loop as well in inline mode
   auto order_plan_manager = std::make_shared<analyzer::OrderPlanManager>(
       as_event_hub.CreateHandler(), order_manager, order_plan_manager_state_,
-      benchmark_data_collector);
+      benchmark_data_collector, inline_event_loop);
 
   auto benchmark_orchestator =
-      std::make_shared<analyzer::BenchmarkOrchestrator>(forwarder, !disable_ts_jump_);
+      std::make_shared<analyzer::BenchmarkOrchestrator>(forwarder, !disable_ts_jump_,
+                                                        inline_event_loop);
 
   forwarder->Initialize();
 
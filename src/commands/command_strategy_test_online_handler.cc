@@ -14,7 +14,9 @@
 #include "analyzer/order_manager.h"
 #include "analyzer/order_plan_manager.h"
 #include "analyzer/real_market_emulator.h"
+#include "commands/command_bus_publish_handler.h"
 #include "events/event_hub.h"
+#include "events/shm_bus.h"
 #include "market_stream/market_stream_forwarder.h"
 #include "market_stream/market_stream_saver.h"
 
@@ -25,6 +27,11 @@ const auto gStrategyOptionName = "strategy";
 const auto gOutputDirOptionName = "output-dir";
 const auto gSymbolOptionName = "symbol";
 const auto gDurationOptionName = "duration";
+const auto gWaitStrategyOptionName = "wait-strategy";
+const auto gAnalyzerCpuOptionName = "analyzer-cpu";
+const auto gSnapshotProviderCpuOptionName = "snapshot-provider-cpu";
+const auto gBusOptionName = "bus";
+const auto gTraceDirOptionName = "trace-dir";
 
 const auto gOutputJsonFileName = "strategy_test_result.json";
 }  // namespace
@@ -42,7 +49,12 @@ CommandStrategyTestOnlineHandler::CommandStrategyTestOnlineHandler(int argc,
       (gSymbolOptionName, po::value<std::string>()->required(), "Symbol (e.g., BTCUSDT)")
       (gStrategyOptionName, po::value<std::string>()->required(), "Strategy name")
       (gOutputDirOptionName, po::value<std::string>()->required(), "Path where to save test result in json")
-      (gDurationOptionName, po::value<int>()->required(), "Timer duration value in seconds");
+      (gDurationOptionName, po::value<int>()->required(), "Timer duration value in seconds")
+      (gWaitStrategyOptionName, po::value<std::string>()->default_value("blocking"), "Event workers wait strategy: blocking, spin, spin-yield, spin-park")
+      (gAnalyzerCpuOptionName, po::value<int>()->default_value(-1), "CPU to pin analyzer event worker to")
+      (gSnapshotProviderCpuOptionName, po::value<int>()->default_value(-1), "CPU to pin order book snapshot provider event worker to")
+      (gBusOptionName, po::value<std::string>()->implicit_value(""), "Receive market stream and order book from the bus publish process instead of connecting, terry.<symbol> if no name given")
+      (gTraceDirOptionName, po::value<std::string>()->default_value(""), "Dir where to keep flight recorder files of event hubs");
     // clang-format on
 
     // Parse the options
@@ -57,6 +69,29 @@ CommandStrategyTestOnlineHandler::CommandStrategyTestOnlineHandler(int argc,
   symbol_ = opts_map.at(gSymbolOptionName).as<std::string>();
   output_dir_ = opts_map.at(gOutputDirOptionName).as<std::string>();
   duration_ = std::chrono::seconds(opts_map.at(gDurationOptionName).as<int>());
+  analyzer_cpu_ = opts_map.at(gAnalyzerCpuOptionName).as<int>();
+  snapshot_provider_cpu_ = opts_map.at(gSnapshotProviderCpuOptionName).as<int>();
+  trace_dir_ = opts_map.at(gTraceDirOptionName).as<std::string>();
+  if (opts_map.count(gBusOptionName)) {
+    bus_name_ = opts_map.at(gBusOptionName).as<std::string>();
+    if (bus_name_.empty()) {
+      bus_name_ = CommandBusPublishHandler::DefaultBusName(symbol_);
+    }
+  }
+
+  const auto wait_strategy_str = opts_map.at(gWaitStrategyOptionName).as<std::string>();
+  if ("blocking" == wait_strategy_str) {
+    wait_strategy_ = events::WaitStrategy::kBlocking;
+  } else if ("spin" == wait_strategy_str) {
+    wait_strategy_ = events::WaitStrategy::kBusySpin;
+  } else if ("spin-yield" == wait_strategy_str) {
+    wait_strategy_ = events::WaitStrategy::kSpinThenYield;
+  } else if ("spin-park" == wait_strategy_str) {
+    wait_strategy_ = events::WaitStrategy::kSpinThenPark;
+  } else {
+    std::cerr << "Error: unknown wait strategy" << std::endl;
+    exit(EXIT_FAILURE);
+  }
 
   const auto strategy_str = opts_map.at(gStrategyOptionName).as<std::string>();
   if ("dummy" == strategy_str) {
@@ -74,19 +109,51 @@ void CommandStrategyTestOnlineHandler::Run() {
 
   InitUnitStates();
 
-  events::EventHub<events::message_queues::MarketStream> ms_event_hub;
-  events::EventHub<events::message_queues::OrderBookStream> obs_event_hub;
-  events::EventHub<events::message_queues::AnalyzerStream> as_event_hub;
+  events::EventHubOptions event_hub_options;
+  event_hub_options.flight_recorder_dir = trace_dir_;
+  event_hub_options.worker_options.wait_strategy = wait_strategy_;
+
+  // MarketStream events are fanned out to several subscribers, share one payload
+  events::EventHubOptions ms_event_hub_options = event_hub_options;
+  ms_event_hub_options.dispatch_mode = events::DispatchMode::kSharedPayload;
+  events::EventHub<events::message_queues::MarketStream> ms_event_hub(
+      ms_event_hub_options);
+  events::EventHub<events::message_queues::OrderBookStream> obs_event_hub(
+      event_hub_options);
+  events::EventHub<events::message_queues::AnalyzerStream> as_event_hub(
+      event_hub_options);
+
+  events::WorkerOptions snapshot_provider_worker_options =
+      event_hub_options.worker_options;
+  snapshot_provider_worker_options.cpu = snapshot_provider_cpu_;
+  snapshot_provider_worker_options.thread_name = "ms.snapshot";
+  events::WorkerOptions analyzer_worker_options = event_hub_options.worker_options;
+  analyzer_worker_options.cpu = analyzer_cpu_;
+  analyzer_worker_options.thread_name = "ms.analyzer";
 
   auto benchmark_data_collector = std::make_shared<analyzer::BenchmarkDataCollector>();
 
-  // MS forwarder
-  auto forwarder = std::make_shared<market_stream::MarketStreamForwarder>(
-      symbol_, ms_event_hub.dispatcher());
-
-  // MS reciever, OBS forwarder
-  auto order_book_snap_provider = std::make_shared<analyzer::OrderBookSnapshotProvider>(
-      ms_event_hub.CreateHandler(), obs_event_hub.dispatcher(), snapshot_provider_state_);
+  // MS forwarder and OBS forwarder are either local or in the bus publish process
+  std::shared_ptr<market_stream::MarketStreamForwarder> forwarder;
+  std::shared_ptr<analyzer::OrderBookSnapshotProvider> order_book_snap_provider;
+  std::unique_ptr<events::ShmBusSubscriber<events::message_queues::MarketStream>>
+      ms_bus_subscriber;
+  std::unique_ptr<events::ShmBusSubscriber<events::message_queues::OrderBookStream>>
+      obs_bus_subscriber;
+  if (bus_name_.empty()) {
+    forwarder = std::make_shared<market_stream::MarketStreamForwarder>(
+        symbol_, ms_event_hub.dispatcher());
+
+    // MS reciever, OBS forwarder
+    order_book_snap_provider = std::make_shared<analyzer::OrderBookSnapshotProvider>(
+        ms_event_hub.CreateHandler(snapshot_provider_worker_options),
+        obs_event_hub.dispatcher(), snapshot_provider_state_);
+  } else {
+    // OBS reciever, book is built by the bus publish process
+    order_book_snap_provider = std::make_shared<analyzer::OrderBookSnapshotProvider>(
+        obs_event_hub.CreateHandler(snapshot_provider_worker_options),
+        snapshot_provider_state_);
+  }
 
   // OBS reciever
   auto market_emulator = std::make_shared<analyzer::RealMarketEmulator>(
@@ -109,7 +176,8 @@ void CommandStrategyTestOnlineHandler::Run() {
   }
 
   auto market_analyzer = std::make_shared<analyzer::MarketAnalyzer>(
-      ms_event_hub.CreateHandler(), trading_strategy, analyzer_state_);
+      ms_event_hub.CreateHandler(analyzer_worker_options), trading_strategy,
+      analyzer_state_);
 
   // AS reciever
   auto order_plan_manager = std::make_shared<analyzer::OrderPlanManager>(
@@ -119,14 +187,31 @@ void CommandStrategyTestOnlineHandler::Run() {
   market_stream::MarketStreamSaver stream_saver(ms_event_hub.CreateHandler(),
                                                 output_dir_);
 
-  forwarder->Initialize();
+  if (nullptr != forwarder) {
+    forwarder->Initialize();
 
-  forwarder->StartAsync();
+    forwarder->StartAsync();
+  } else {
+    spdlog::info("receiving market stream from bus {}", bus_name_);
+    ms_bus_subscriber =
+        std::make_unique<events::ShmBusSubscriber<events::message_queues::MarketStream>>(
+            ms_event_hub.dispatcher(), bus_name_, event_hub_options.worker_options);
+    obs_bus_subscriber = std::make_unique<
+        events::ShmBusSubscriber<events::message_queues::OrderBookStream>>(
+        obs_event_hub.dispatcher(), bus_name_, event_hub_options.worker_options);
+  }
 
   spdlog::info("strategy test run successfully.");
   std::this_thread::sleep_for(duration_);
   spdlog::info("timer finished");
 
+  if (nullptr != forwarder) {
+    forwarder->Stop();
+  }
+  if (nullptr != ms_bus_subscriber) {
+    ms_bus_subscriber->Stop();
+    obs_bus_subscriber->Stop();
+  }
   ms_event_hub.Shutdown();
   obs_event_hub.Shutdown();
   as_event_hub.Shutdown();
@@ -19,6 +19,7 @@ const auto gSymbolOptionName = "symbol";
 const auto gDurationOptionName = "timer";
 const auto gPrintStreamOptionName = "print-stream";
 const auto gOutputDirOptionName = "output-dir";
+const auto gStateDirOptionName = "state-dir";
 }  // namespace
 
 CommandStreamSaveHandler::CommandStreamSaveHandler(int argc, const char* argv[]) {
@@ -31,7 +32,8 @@ CommandStreamSaveHandler::CommandStreamSaveHandler(int argc, const char* argv[])
       (gSymbolOptionName, po::value<std::string>()->required(), "Symbol (e.g., BTCUSDT)")
       (gOutputDirOptionName, po::value<std::string>()->required(), "Path to the stream save dir")
       (gDurationOptionName, po::value<int>()->required(), "Timer duration value in seconds")
-      (gPrintStreamOptionName, po::bool_switch()->default_value(false), "Print recording stream");
+      (gPrintStreamOptionName, po::bool_switch()->default_value(false), "Print recording stream")
+      (gStateDirOptionName, po::value<std::string>()->default_value(""), "Dir to keep the order book between runs");
     // clang-format on
 
     // Parse the options
@@ -47,17 +49,21 @@ CommandStreamSaveHandler::CommandStreamSaveHandler(int argc, const char* argv[])
   save_path_ = opts_map.at(gOutputDirOptionName).as<std::string>();
   timer_ = std::chrono::seconds(opts_map.at(gDurationOptionName).as<int>());
   print_stream_ = opts_map.at(gPrintStreamOptionName).as<bool>();
+  state_dir_ = opts_map.at(gStateDirOptionName).as<std::string>();
   spdlog::info("command pasing finished.");
 }
 
 void CommandStreamSaveHandler::Run() {
   spdlog::info("run stream save command...");
 
-  events::EventHub<events::message_queues::MarketStream> event_hub;
+  // MarketStream events are fanned out to several subscribers, share one payload
+  events::EventHubOptions event_hub_options;
+  event_hub_options.dispatch_mode = events::DispatchMode::kSharedPayload;
+  events::EventHub<events::message_queues::MarketStream> event_hub(event_hub_options);
 
   std::shared_ptr<market_stream::MarketStreamForwarder> forwarder =
-      std::make_shared<market_stream::MarketStreamForwarder>(symbol_,
-                                                             event_hub.dispatcher());
+      std::make_shared<market_stream::MarketStreamForwarder>(
+          symbol_, event_hub.dispatcher(), state_dir_);
   forwarder->Initialize();
 
   market_stream::MarketStreamSaver stream_saver(event_hub.CreateHandler(), save_path_);
@@ -73,6 +79,7 @@ void CommandStreamSaveHandler::Run() {
   std::this_thread::sleep_for(std::chrono::seconds(timer_));
   spdlog::info("timer finished");
 
+  forwarder->Stop();
   event_hub.Shutdown();
 }
 
@@ -0,0 +1,94 @@
+#include "commands/command_trace_dump_handler.h"
+
+#include <fmt/chrono.h>
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <unordered_map>
+
+#include "events/flight_recorder.h"
+
+namespace commands {
+
+namespace {
+const auto gTraceFileOptionName = "trace-file";
+const auto gLastSecondsOptionName = "last-seconds";
+}  // namespace
+
+CommandTraceDumpHandler::CommandTraceDumpHandler(int argc, const char* argv[]) {
+  spdlog::info("command parsing...");
+  po::variables_map opts_map;
+  try {
+    // clang-format off
+    po::options_description command_options;
+    command_options.add_options()
+      (gTraceFileOptionName, po::value<std::string>()->required(), "Flight recorder file, <trace-dir>/<hub>.<pid>.<n>.trace")
+      (gLastSecondsOptionName, po::value<int>()->default_value(0), "Print only records of the last seconds before the latest one");
+    // clang-format on
+
+    // Parse the options
+    po::options_description all_options;
+    all_options.add(command_options);
+    po::store(po::parse_command_line(argc, argv, all_options), opts_map);
+    po::notify(opts_map);
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  trace_file_ = opts_map.at(gTraceFileOptionName).as<std::string>();
+  last_seconds_ = opts_map.at(gLastSecondsOptionName).as<int>();
+  spdlog::info("command parsing finished.");
+}
+
+void CommandTraceDumpHandler::Run() {
+  spdlog::info("run trace dump command...");
+
+  events::FlightRecording recording(trace_file_);
+  const auto& records = recording.records();
+  std::cout << fmt::format("hub {}, {} records", recording.hub_name(), records.size())
+            << std::endl;
+  if (records.empty()) {
+    return;
+  }
+
+  const int64_t from_time_ns =
+      0 == last_seconds_
+          ? std::numeric_limits<int64_t>::min()
+          : records.back().time_ns -
+                std::chrono::nanoseconds(std::chrono::seconds(last_seconds_)).count();
+
+  // Dequeue records are printed with the time passed since the dispatch
+  std::unordered_map<uint64_t, int64_t> dispatch_times;
+  for (const auto& it : records) {
+    if (events::FlightRecordType::kDispatch == it.type) {
+      dispatch_times[it.sequence] = it.time_ns;
+    }
+    if (it.time_ns < from_time_ns) {
+      continue;
+    }
+
+    const auto time = recording.ToSystemTime(it.time_ns);
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                        time.time_since_epoch()) %
+                    std::chrono::seconds(1);
+    auto line = fmt::format("{:%Y-%m-%d %H:%M:%S}.{:06} seq={} event={}",
+                            std::chrono::time_point_cast<std::chrono::seconds>(time),
+                            us.count(), it.sequence, it.event);
+    if (events::FlightRecordType::kDispatch == it.type) {
+      line += fmt::format(" dispatch payload={:#x}", it.payload);
+    } else {
+      line += fmt::format(" dequeue queue=#{}", it.queue);
+      const auto dispatch_time = dispatch_times.find(it.sequence);
+      if (dispatch_times.end() != dispatch_time) {
+        line += fmt::format(" wait={}ns", it.time_ns - dispatch_time->second);
+      }
+    }
+    std::cout << line << '\n';
+  }
+  std::cout << std::flush;
+}
+
+}  // namespace commands
@@ -2,36 +2,92 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <cassert>
 #include <thread>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 namespace events {
 
+namespace {
+// All existing hubs counters, read by TransportUnitStateImpl::total_event_count only
+std::mutex gInFlightEventsMutex;
+std::vector<const InFlightEvents *> gInFlightEvents;
+}  // namespace
+
+InFlightEvents::InFlightEvents() {
+  std::lock_guard<std::mutex> lock(gInFlightEventsMutex);
+  gInFlightEvents.push_back(this);
+}
+
+InFlightEvents::~InFlightEvents() {
+  std::lock_guard<std::mutex> lock(gInFlightEventsMutex);
+  gInFlightEvents.erase(std::find(gInFlightEvents.begin(), gInFlightEvents.end(), this));
+}
+
+void InFlightEvents::WaitUntilDrained() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  drained_cv_.wait(lock, [this] { return 0 == count(); });
+}
+
+// Several threads may cross zero concurrently, so the state is taken from the
+// counter under the lock and the last caller leaves it consistent
+void InFlightEvents::OnBusyChanged() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const bool is_busy = count() > 0;
+  if (is_busy == is_busy_) {
+    return;
+  }
+  is_busy_ = is_busy;
+
+  if (g_transport_unit_state_impl) {
+    if (is_busy) {
+      g_transport_unit_state_impl->AddBusyHub();
+    } else {
+      g_transport_unit_state_impl->RemoveBusyHub();
+    }
+  }
+  if (!is_busy) {
+    drained_cv_.notify_all();
+  }
+}
+
 TransportUnitStateImpl::TransportUnitStateImpl(
     const std::shared_ptr<analyzer::TransportUnitState> &unit_state)
-    : unit_state_(unit_state), total_event_count_(0) {}
+    : unit_state_(unit_state), busy_hubs_count_(0) {}
 
-void TransportUnitStateImpl::AddOneEvent() {
+void TransportUnitStateImpl::AddBusyHub() {
   std::lock_guard<std::mutex> lock(mutex_);
-  if (0 == total_event_count_) {
+  if (0 == busy_hubs_count_) {
     unit_state_->SetBusy();
   }
-  total_event_count_++;
+  busy_hubs_count_++;
 }
 
-void TransportUnitStateImpl::RemoveOneEvent() {
+void TransportUnitStateImpl::RemoveBusyHub() {
   std::lock_guard<std::mutex> lock(mutex_);
-  total_event_count_--;
-  if (0 == total_event_count_) {
+  busy_hubs_count_--;
+  if (0 == busy_hubs_count_) {
     unit_state_->SetReady();
   }
-  if (total_event_count_ < 0) {
-    spdlog::error("total_event_count_ < 0");
+  if (busy_hubs_count_ < 0) {
+    spdlog::error("busy_hubs_count_ < 0");
     exit(-1);
   }
 }
 
-int TransportUnitStateImpl::total_event_count() const { return total_event_count_; }
+int TransportUnitStateImpl::total_event_count() const {
+  std::lock_guard<std::mutex> lock(gInFlightEventsMutex);
+  int total_event_count = 0;
+  for (const auto *it : gInFlightEvents) {
+    total_event_count += it->count();
+  }
+  return total_event_count;
+}
 
 std::unique_ptr<TransportUnitStateImpl> g_transport_unit_state_impl;
 
@@ -42,4 +98,28 @@ void SetTransportUnitState(
   }
   g_transport_unit_state_impl = std::make_unique<TransportUnitStateImpl>(unit_state);
 }
+
+void SetupWorkerThread(const WorkerOptions &worker_options) {
+#ifdef __linux__
+  if (!worker_options.thread_name.empty()) {
+    // Linux limits thread name to 15 characters
+    const auto thread_name = worker_options.thread_name.substr(0, 15);
+    if (0 != pthread_setname_np(pthread_self(), thread_name.c_str())) {
+      spdlog::warn("Failed to set worker thread name: {}", thread_name);
+    }
+  }
+  if (worker_options.cpu >= 0) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(worker_options.cpu, &cpu_set);
+    if (0 != pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set)) {
+      spdlog::warn("Failed to pin worker thread to CPU {}", worker_options.cpu);
+    }
+  }
+#else
+  if (!worker_options.thread_name.empty() || worker_options.cpu >= 0) {
+    spdlog::warn("Worker thread name and CPU affinity are supported on Linux only");
+  }
+#endif
+}
 }  // namespace events
\ No newline at end of file
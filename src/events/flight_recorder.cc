@@ -0,0 +1,155 @@
+#include "events/flight_recorder.h"
+
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <utility>
+
+namespace events {
+
+namespace bip = boost::interprocess;
+
+namespace flight_recorder_internal {
+const uint64_t kMagic = 0x74657272795f6672;  // "terry_fr"
+const std::size_t kHubNameSize = 32;
+
+struct Cell {
+  // 1 + append index of the record, 0 while the record is written
+  std::atomic<uint64_t> index{0};
+  FlightRecord record;
+};
+
+struct Header {
+  uint64_t magic{0};
+  uint64_t capacity{0};
+  int64_t steady_to_system_ns{0};
+  char hub_name[kHubNameSize]{};
+  std::atomic<uint64_t> next_index{0};
+
+  Cell *cells() { return reinterpret_cast<Cell *>(this + 1); }
+  const Cell *cells() const { return reinterpret_cast<const Cell *>(this + 1); }
+};
+}  // namespace flight_recorder_internal
+
+namespace {
+using flight_recorder_internal::Cell;
+using flight_recorder_internal::Header;
+
+int64_t SteadyNowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+int64_t SystemNowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+}  // namespace
+
+std::string MakeFlightRecorderPath(const std::string &dir, const std::string &hub_name) {
+  static std::atomic<uint64_t> paths_count{0};
+  return fmt::format("{}/{}.{}.{}.trace", dir, hub_name, getpid(),
+                     paths_count.fetch_add(1, std::memory_order_relaxed));
+}
+
+FlightRecorder::FlightRecorder(const std::string &path, const std::string &hub_name,
+                               std::size_t capacity) {
+  const std::size_t file_size = sizeof(Header) + capacity * sizeof(Cell);
+  try {
+    {
+      std::filebuf file_buf;
+      file_buf.open(path, std::ios::in | std::ios::out | std::ios::trunc |
+                              std::ios::binary);
+      file_buf.pubseekoff(file_size - 1, std::ios::beg);
+      file_buf.sputc(0);
+    }
+    file_ = bip::file_mapping(path.c_str(), bip::read_write);
+    region_ = bip::mapped_region(file_, bip::read_write);
+  } catch (const bip::interprocess_exception &e) {
+    spdlog::error("Cannot map flight recorder file {}: {}", path, e.what());
+    exit(-1);
+  }
+
+  header_ = new (region_.get_address()) Header();
+  header_->capacity = capacity;
+  header_->steady_to_system_ns = SystemNowNs() - SteadyNowNs();
+  std::strncpy(header_->hub_name, hub_name.c_str(),
+               flight_recorder_internal::kHubNameSize - 1);
+  for (std::size_t i = 0; i < capacity; i++) {
+    new (header_->cells() + i) Cell();
+  }
+  header_->magic = flight_recorder_internal::kMagic;
+  spdlog::info("Flight recorder of {} hub writes to {}", hub_name, path);
+}
+
+uint64_t FlightRecorder::RecordDispatch(uint16_t event, const void *payload) {
+  const uint64_t sequence = next_sequence_.fetch_add(1, std::memory_order_relaxed);
+  Append({sequence, SteadyNowNs(), reinterpret_cast<uint64_t>(payload), 0, event,
+          FlightRecordType::kDispatch, 0});
+  return sequence;
+}
+
+void FlightRecorder::RecordDequeue(uint16_t event, uint64_t sequence, uint32_t queue) {
+  Append({sequence, SteadyNowNs(), 0, queue, event, FlightRecordType::kDequeue, 0});
+}
+
+void FlightRecorder::Append(const FlightRecord &record) {
+  const uint64_t index = header_->next_index.fetch_add(1, std::memory_order_relaxed);
+  auto &cell = header_->cells()[index % header_->capacity];
+  // A record torn by a crash or by a concurrent writer keeps index 0 and is skipped
+  cell.index.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  cell.record = record;
+  cell.index.store(index + 1, std::memory_order_release);
+}
+
+FlightRecording::FlightRecording(const std::string &path) {
+  try {
+    bip::file_mapping file(path.c_str(), bip::read_only);
+    bip::mapped_region region(file, bip::read_only);
+    const auto *header = static_cast<const Header *>(region.get_address());
+    if (region.get_size() < sizeof(Header) ||
+        flight_recorder_internal::kMagic != header->magic ||
+        region.get_size() < sizeof(Header) + header->capacity * sizeof(Cell)) {
+      spdlog::error("{} is not a flight recorder file", path);
+      exit(-1);
+    }
+
+    hub_name_ = std::string(
+        header->hub_name,
+        strnlen(header->hub_name, flight_recorder_internal::kHubNameSize));
+    steady_to_system_ns_ = header->steady_to_system_ns;
+
+    std::vector<std::pair<uint64_t, FlightRecord>> indexed_records;
+    for (std::size_t i = 0; i < header->capacity; i++) {
+      const auto &cell = header->cells()[i];
+      const uint64_t index = cell.index.load(std::memory_order_acquire);
+      if (0 != index) {
+        indexed_records.emplace_back(index, cell.record);
+      }
+    }
+    std::sort(indexed_records.begin(), indexed_records.end(),
+              [](const auto &l, const auto &r) { return l.first < r.first; });
+    for (const auto &it : indexed_records) {
+      records_.push_back(it.second);
+    }
+  } catch (const bip::interprocess_exception &e) {
+    spdlog::error("Cannot read flight recorder file {}: {}", path, e.what());
+    exit(-1);
+  }
+}
+
+std::chrono::system_clock::time_point FlightRecording::ToSystemTime(
+    int64_t time_ns) const {
+  return std::chrono::system_clock::time_point(
+      std::chrono::duration_cast<std::chrono::system_clock::duration>(
+          std::chrono::nanoseconds(time_ns + steady_to_system_ns_)));
+}
+
+}  // namespace events
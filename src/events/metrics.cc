@@ -0,0 +1,101 @@
+#include "events/metrics.h"
+
+#include <algorithm>
+
+namespace events {
+
+namespace {
+std::size_t BucketIndex(uint64_t value_ns) {
+  std::size_t index = 0;
+  while (0 != value_ns && index < LatencyHistogramSnapshot::kBucketsCount - 1) {
+    value_ns >>= 1;
+    index++;
+  }
+  return index;
+}
+
+void UpdateMax(std::atomic<uint64_t> *max, uint64_t value) {
+  uint64_t current = max->load(std::memory_order_relaxed);
+  while (current < value &&
+         !max->compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+
+void PrintHistogram(std::ostream &os, const LatencyHistogramSnapshot &o) {
+  os << "count=" << o.count;
+  if (0 != o.count) {
+    os << " avg=" << o.sum_ns / o.count << "ns p50<=" << o.PercentileNs(0.5)
+       << "ns p99<=" << o.PercentileNs(0.99) << "ns max=" << o.max_ns << "ns";
+  }
+}
+}  // namespace
+
+uint64_t LatencyHistogramSnapshot::PercentileNs(double quantile) const {
+  const auto target = static_cast<uint64_t>(quantile * count);
+  uint64_t counted = 0;
+  for (std::size_t i = 0; i < kBucketsCount; i++) {
+    counted += buckets[i];
+    if (counted > target || (counted == count && 0 != count)) {
+      return 0 == i ? 0 : (uint64_t{1} << i) - 1;
+    }
+  }
+  return max_ns;
+}
+
+void LatencyHistogram::Record(std::chrono::nanoseconds value) {
+  const auto value_ns = static_cast<uint64_t>(std::max<int64_t>(0, value.count()));
+  buckets_[BucketIndex(value_ns)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_ns_.fetch_add(value_ns, std::memory_order_relaxed);
+  UpdateMax(&max_ns_, value_ns);
+}
+
+LatencyHistogramSnapshot LatencyHistogram::snapshot() const {
+  LatencyHistogramSnapshot snapshot;
+  for (std::size_t i = 0; i < buckets_.size(); i++) {
+    snapshot.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+  }
+  snapshot.count = count_.load(std::memory_order_relaxed);
+  snapshot.sum_ns = sum_ns_.load(std::memory_order_relaxed);
+  snapshot.max_ns = max_ns_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+QueueMetrics::QueueMetrics(const std::string &message_queue,
+                           const std::string &subscriber, std::size_t events_count)
+    : message_queue_(message_queue), subscriber_(subscriber), wait_time_(events_count) {}
+
+void QueueMetrics::OnEventQueued() {
+  const int depth = depth_.fetch_add(1, std::memory_order_relaxed) + 1;
+  int max_depth = max_depth_.load(std::memory_order_relaxed);
+  while (max_depth < depth &&
+         !max_depth_.compare_exchange_weak(max_depth, depth, std::memory_order_relaxed)) {
+  }
+}
+
+QueueMetricsSnapshot QueueMetrics::snapshot() const {
+  QueueMetricsSnapshot snapshot;
+  snapshot.message_queue = message_queue_;
+  snapshot.subscriber = subscriber_;
+  snapshot.depth = depth_.load(std::memory_order_relaxed);
+  snapshot.max_depth = max_depth_.load(std::memory_order_relaxed);
+  for (const auto &it : wait_time_) {
+    snapshot.wait_time.push_back(it.snapshot());
+  }
+  snapshot.handle_time = handle_time_.snapshot();
+  return snapshot;
+}
+
+std::ostream &operator<<(std::ostream &os, const QueueMetricsSnapshot &o) {
+  os << o.message_queue << "/" << o.subscriber << ": depth=" << o.depth
+     << " max_depth=" << o.max_depth;
+  for (std::size_t i = 0; i < o.wait_time.size(); i++) {
+    os << "\n  event " << i << " wait time: ";
+    PrintHistogram(os, o.wait_time[i]);
+  }
+  os << "\n  handle time: ";
+  PrintHistogram(os, o.handle_time);
+  return os;
+}
+
+}  // namespace events
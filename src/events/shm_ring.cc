@@ -0,0 +1,167 @@
+#include "events/shm_ring.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <type_traits>
+
+namespace events {
+
+namespace bip = boost::interprocess;
+
+namespace shm_ring_internal {
+const uint64_t kMagic = 0x74657272795f726e;  // "terry_rn"
+const std::size_t kCacheLineSize = 64;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "shared memory atomics must be lock free");
+
+struct Header {
+  std::atomic<uint64_t> magic{0};  // set when the segment is initialized
+  uint64_t capacity{0};
+  uint64_t slot_size{0};
+  uint64_t slot_stride{0};
+  alignas(kCacheLineSize) std::atomic<uint64_t> write_sequence{0};  // published count
+};
+
+struct Slot {
+  // 2 * sequence + 1 while the message is written, 2 * sequence + 2 when done
+  std::atomic<uint64_t> state{0};
+  uint32_t tag{0};
+  uint32_t size{0};
+
+  char *data() { return reinterpret_cast<char *>(this + 1); }
+  const char *data() const { return reinterpret_cast<const char *>(this + 1); }
+};
+}  // namespace shm_ring_internal
+
+namespace {
+using shm_ring_internal::Header;
+using shm_ring_internal::kCacheLineSize;
+using shm_ring_internal::Slot;
+
+std::size_t AlignToCacheLine(std::size_t size) {
+  return (size + kCacheLineSize - 1) / kCacheLineSize * kCacheLineSize;
+}
+
+const std::size_t gSlotsOffset = AlignToCacheLine(sizeof(Header));
+
+template <class H>
+auto *SlotAt(H *header, uint64_t sequence) {
+  using SlotType = std::conditional_t<std::is_const_v<H>, const Slot, Slot>;
+  using ByteType = std::conditional_t<std::is_const_v<H>, const char, char>;
+  auto *slots = reinterpret_cast<ByteType *>(header) + gSlotsOffset;
+  return reinterpret_cast<SlotType *>(
+      slots + (sequence % header->capacity) * header->slot_stride);
+}
+}  // namespace
+
+ShmRingWriter::ShmRingWriter(const std::string &name, std::size_t capacity,
+                             std::size_t slot_size)
+    : name_(name), slot_size_(slot_size) {
+  const std::size_t slot_stride = AlignToCacheLine(sizeof(Slot) + slot_size);
+  try {
+    bip::shared_memory_object::remove(name_.c_str());
+    shm_ = bip::shared_memory_object(bip::create_only, name_.c_str(), bip::read_write);
+    shm_.truncate(gSlotsOffset + capacity * slot_stride);
+    region_ = bip::mapped_region(shm_, bip::read_write);
+  } catch (const bip::interprocess_exception &e) {
+    spdlog::error("Cannot create shared memory ring {}: {}", name_, e.what());
+    exit(-1);
+  }
+
+  header_ = new (region_.get_address()) Header();
+  header_->capacity = capacity;
+  header_->slot_size = slot_size;
+  header_->slot_stride = slot_stride;
+  for (std::size_t i = 0; i < capacity; i++) {
+    new (SlotAt(header_, i)) Slot();
+  }
+  header_->magic.store(shm_ring_internal::kMagic, std::memory_order_release);
+  spdlog::info("Shared memory ring {} created: {} slots of {} bytes", name_, capacity,
+               slot_size);
+}
+
+ShmRingWriter::~ShmRingWriter() { bip::shared_memory_object::remove(name_.c_str()); }
+
+char *ShmRingWriter::BeginWrite() {
+  slot_ = SlotAt(header_, sequence_);
+  slot_->state.store(2 * sequence_ + 1, std::memory_order_relaxed);
+  // Readers must see the slot as being written before any of its new data
+  std::atomic_thread_fence(std::memory_order_release);
+  return slot_->data();
+}
+
+void ShmRingWriter::EndWrite(uint32_t tag, std::size_t size) {
+  slot_->tag = tag;
+  slot_->size = static_cast<uint32_t>(size);
+  slot_->state.store(2 * sequence_ + 2, std::memory_order_release);
+  sequence_++;
+  header_->write_sequence.store(sequence_, std::memory_order_release);
+}
+
+ShmRingReader::ShmRingReader(const std::string &name) {
+  try {
+    shm_ = bip::shared_memory_object(bip::open_only, name.c_str(), bip::read_only);
+    region_ = bip::mapped_region(shm_, bip::read_only);
+  } catch (const bip::interprocess_exception &e) {
+    spdlog::error("Cannot open shared memory ring {}: {}", name, e.what());
+    exit(-1);
+  }
+
+  header_ = static_cast<const Header *>(region_.get_address());
+  if (shm_ring_internal::kMagic != header_->magic.load(std::memory_order_acquire)) {
+    spdlog::error("Shared memory ring {} is not initialized", name);
+    exit(-1);
+  }
+  sequence_ = header_->write_sequence.load(std::memory_order_acquire);
+}
+
+ShmRingReader::ReadResult ShmRingReader::BeginRead(uint64_t *slot_sequence) {
+  const uint64_t write_sequence =
+      header_->write_sequence.load(std::memory_order_acquire);
+  if (write_sequence == sequence_) {
+    return ReadResult::kEmpty;
+  }
+  if (write_sequence - sequence_ > header_->capacity) {
+    return SkipToLatest();
+  }
+
+  slot_ = SlotAt(header_, sequence_);
+  *slot_sequence = slot_->state.load(std::memory_order_acquire);
+  if (2 * sequence_ + 2 != *slot_sequence) {
+    return SkipToLatest();
+  }
+  return ReadResult::kRead;
+}
+
+ShmRingReader::ReadResult ShmRingReader::EndRead(uint64_t slot_sequence) {
+  // Data reads must be done before the slot state is checked again
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (slot_->state.load(std::memory_order_relaxed) != slot_sequence) {
+    return SkipToLatest();
+  }
+  sequence_++;
+  return ReadResult::kRead;
+}
+
+ShmRingReader::ReadResult ShmRingReader::SkipToLatest() {
+  const uint64_t write_sequence =
+      header_->write_sequence.load(std::memory_order_acquire);
+  lagged_messages_ += write_sequence - sequence_;
+  sequence_ = write_sequence;
+  return ReadResult::kLagged;
+}
+
+uint32_t ShmRingReader::tag() const { return slot_->tag; }
+
+const char *ShmRingReader::data() const { return slot_->data(); }
+
+// Size of an overwritten slot may be garbage, it must not point outside the slot
+std::size_t ShmRingReader::size() const {
+  return std::min<std::size_t>(slot_->size, header_->slot_size);
+}
+
+}  // namespace events
@@ -4,8 +4,14 @@
 
 #include <atomic>
 #include <chrono>
+#include <future>
 #include <thread>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #include "market_stream/types/types.h"
 #include "utils/tests/helpers/unit_state_mock.h"
 
@@ -16,10 +22,47 @@ void SendDummyOrdeBookEvent(std::shared_ptr<events::EventHub<MQ>::Dispatcher> di
       market_stream::types::OrderBook());
 }
 
+void SendOrderBookEvent(std::shared_ptr<events::EventHub<MQ>::Dispatcher> dispather,
+                        uint64_t timestamp) {
+  market_stream::types::OrderBook order_book;
+  order_book.timestamp = timestamp;
+  dispather->DispatchEvent<MQ::Event::kOrderBookUpdateEvent>(order_book);
+}
+
 void SendDummyTradeEvent(std::shared_ptr<events::EventHub<MQ>::Dispatcher> dispather) {
   dispather->DispatchEvent<MQ::Event::kNewTradeEvent>(market_stream::types::Trade());
 }
 
+class TypedSubscriber {
+ public:
+  TypedSubscriber(const std::weak_ptr<events::EventHub<MQ>::Handler>& event_handler) {
+    SUBSCRIBE_TO_TYPED_EVENTS(event_handler);
+  }
+
+  std::vector<uint64_t> order_book_timestamps;
+  std::vector<uint64_t> trade_timestamps;
+
+ private:
+  friend class events::TypedEventHandlerAccess;
+
+  void OnEvent(const market_stream::types::OrderBook& order_book) {
+    order_book_timestamps.push_back(order_book.timestamp);
+  }
+  void OnEvent(const market_stream::types::Trade& trade) {
+    trade_timestamps.push_back(trade.trade_timestamp);
+  }
+};
+
+class TaggedTradeSubscriber {
+ public:
+  void OnEvent(events::EventTag<MQ::Event::kNewTradeEvent>,
+               const market_stream::types::Trade& trade) {
+    trades_count++;
+  }
+
+  std::atomic<int> trades_count = 0;
+};
+
 class EventHubFixture : public ::testing::Test {
  public:
   EventHubFixture()
@@ -56,6 +99,10 @@ TEST_F(EventHubFixture,
         case MQ::Event::kNewTradeEvent:
           events_stack.push_back(MQ::Event::kNewTradeEvent);
           break;
+
+        default:
+          ADD_FAILURE() << "Unexpected event " << static_cast<int>(event);
+          break;
       }
     });
   }
@@ -90,6 +137,560 @@ TEST_F(EventHubFixture,
   }
 }
 
+TEST_F(EventHubFixture,
+       GivenLockFreeRingQueue_WhenEventsSent_ThenRecievedInSameOrderWithPayload) {
+  using namespace events;
+
+  // Given
+  EventHubOptions options;
+  options.queue_type = QueueType::kLockFreeRing;
+  options.ring_capacity = 4;
+  EventHub<MQ> event_hub(options);
+  const int kSubscribersCount = 3;
+  const int kEventsCount = 100;
+  std::vector<uint64_t> recieved_timestamps[kSubscribersCount];
+  auto handler_locked = event_hub.CreateHandler().lock();
+  for (int i = 0; i < kSubscribersCount; i++) {
+    auto& timestamps = recieved_timestamps[i];
+    handler_locked->Subscribe([&timestamps](MQ::Event event, const void* data) {
+      switch (event) {
+        case MQ::Event::kOrderBookUpdateEvent:
+          timestamps.push_back(
+              static_cast<const market_stream::types::OrderBook*>(data)->timestamp);
+          break;
+
+        case MQ::Event::kNewTradeEvent:
+          timestamps.push_back(
+              static_cast<const market_stream::types::Trade*>(data)->trade_timestamp);
+          break;
+
+        default:
+          break;
+      }
+    });
+  }
+
+  // When
+  auto dispatcher_locked = event_hub.dispatcher().lock();
+  for (int i = 0; i < kEventsCount; i++) {
+    if (i % 3 == 0) {
+      market_stream::types::Trade trade;
+      trade.trade_timestamp = i;
+      dispatcher_locked->DispatchEvent<MQ::Event::kNewTradeEvent>(trade);
+    } else {
+      market_stream::types::OrderBook order_book;
+      order_book.timestamp = i;
+      dispatcher_locked->DispatchEvent<MQ::Event::kOrderBookUpdateEvent>(order_book);
+    }
+  }
+  event_hub.WaitForAllEventsProcessed();
+
+  EXPECT_EQ(g_transport_unit_state_impl->total_event_count(), 0);
+  event_hub.Shutdown();
+
+  // Then
+  for (int i = 0; i < kSubscribersCount; i++) {
+    const auto& timestamps = recieved_timestamps[i];
+    ASSERT_EQ(timestamps.size(), kEventsCount);
+    for (int j = 0; j < kEventsCount; j++) {
+      EXPECT_EQ(timestamps[j], j);
+    }
+  }
+}
+
+TEST_F(EventHubFixture,
+       GivenNotPowerOfTwoRingCapacity_WhenCreateEventHub_ThenTheProgramExit) {
+  using namespace events;
+
+  // Given
+  EventHubOptions options;
+  options.queue_type = QueueType::kLockFreeRing;
+  options.ring_capacity = 1000;
+
+  // Then
+  EXPECT_EXIT(EventHub<MQ>{options}, ::testing::ExitedWithCode(255), "");
+}
+
+TEST_F(EventHubFixture,
+       GivenSharedPayloadDispatchMode_WhenEventSent_ThenSubscribersShareOnePayload) {
+  using namespace events;
+
+  for (auto queue_type : {QueueType::kBlocking, QueueType::kLockFreeRing}) {
+    // Given
+    EventHubOptions options;
+    options.queue_type = queue_type;
+    options.dispatch_mode = DispatchMode::kSharedPayload;
+    EventHub<MQ> event_hub(options);
+    const int kSubscribersCount = 3;
+    const void* recieved_data[kSubscribersCount] = {nullptr, nullptr, nullptr};
+    std::size_t recieved_bids_count[kSubscribersCount] = {0, 0, 0};
+    auto handler_locked = event_hub.CreateHandler().lock();
+    for (int i = 0; i < kSubscribersCount; i++) {
+      handler_locked->Subscribe([&, i](MQ::Event event, const void* data) {
+        recieved_data[i] = data;
+        recieved_bids_count[i] =
+            static_cast<const market_stream::types::OrderBook*>(data)->bids.size();
+      });
+    }
+
+    // When
+    market_stream::types::OrderBook order_book;
+    order_book.bids = {{121, 3.5}, {120, 22}};
+    event_hub.dispatcher().lock()->DispatchEvent<MQ::Event::kOrderBookUpdateEvent>(
+        order_book);
+    event_hub.Shutdown();
+
+    // Then
+    for (int i = 0; i < kSubscribersCount; i++) {
+      EXPECT_NE(recieved_data[i], &order_book);
+      EXPECT_EQ(recieved_data[i], recieved_data[0]);
+      EXPECT_EQ(recieved_bids_count[i], order_book.bids.size());
+    }
+  }
+}
+
+TEST_F(EventHubFixture,
+       GivenSharedEvent_WhenDispatchedAndProcessed_ThenPayloadReleasedBySubscribers) {
+  using namespace events;
+
+  // Given
+  EventHubOptions options;
+  options.queue_type = QueueType::kLockFreeRing;
+  EventHub<MQ> event_hub(options);
+  std::atomic<int> recieved_events_count = 0;
+  auto handler_locked = event_hub.CreateHandler().lock();
+  handler_locked->Subscribe(
+      [&](MQ::Event event, const void* data) { recieved_events_count++; });
+  handler_locked->Subscribe(
+      [&](MQ::Event event, const void* data) { recieved_events_count++; });
+  auto trade = std::make_shared<const market_stream::types::Trade>();
+
+  // When
+  event_hub.dispatcher().lock()->DispatchSharedEvent<MQ::Event::kNewTradeEvent>(trade);
+  event_hub.Shutdown();
+
+  // Then
+  EXPECT_EQ(recieved_events_count, 2);
+  EXPECT_EQ(trade.use_count(), 1);
+}
+
+TEST_F(EventHubFixture,
+       GivenPerEventSubscriptions_WhenEventsSent_ThenOnlySubscribedEventsRecieved) {
+  using namespace events;
+
+  for (auto queue_type : {QueueType::kBlocking, QueueType::kLockFreeRing}) {
+    // Given
+    EventHubOptions options;
+    options.queue_type = queue_type;
+    EventHub<MQ> event_hub(options);
+    std::vector<MQ::Event> order_book_events;
+    std::vector<MQ::Event> trade_events;
+    std::vector<MQ::Event> all_events;
+    auto handler_locked = event_hub.CreateHandler().lock();
+    handler_locked->Subscribe(
+        [&](MQ::Event event, const void* data) { order_book_events.push_back(event); },
+        {MQ::Event::kOrderBookUpdateEvent});
+    handler_locked->Subscribe(
+        [&](MQ::Event event, const void* data) { trade_events.push_back(event); },
+        {MQ::Event::kNewTradeEvent});
+    handler_locked->Subscribe(
+        [&](MQ::Event event, const void* data) { all_events.push_back(event); },
+        {MQ::Event::kOrderBookUpdateEvent, MQ::Event::kNewTradeEvent});
+
+    // When
+    auto dispatcher_locked = event_hub.dispatcher().lock();
+    SendDummyOrdeBookEvent(dispatcher_locked);
+    SendDummyTradeEvent(dispatcher_locked);
+    SendDummyTradeEvent(dispatcher_locked);
+    SendDummyOrdeBookEvent(dispatcher_locked);
+    SendDummyTradeEvent(dispatcher_locked);
+    event_hub.Shutdown();
+
+    // Then
+    EXPECT_EQ(g_transport_unit_state_impl->total_event_count(), 0);
+    EXPECT_THAT(order_book_events, ::testing::Each(MQ::Event::kOrderBookUpdateEvent));
+    EXPECT_EQ(order_book_events.size(), 2);
+    EXPECT_THAT(trade_events, ::testing::Each(MQ::Event::kNewTradeEvent));
+    EXPECT_EQ(trade_events.size(), 3);
+    EXPECT_EQ(all_events.size(), 5);
+  }
+}
+
+TEST_F(EventHubFixture,
+       GivenInlineQueueType_WhenEventsSent_ThenProcessedInOrderOnRunningThread) {
+  using namespace events;
+  using MQOrderBook = message_queues::OrderBookStream;
+
+  // Given
+  auto inline_event_loop = std::make_shared<InlineEventLoop>();
+  EventHubOptions options;
+  options.queue_type = QueueType::kInline;
+  options.inline_event_loop = inline_event_loop;
+  EventHub<MQ> ms_event_hub(options);
+  EventHub<MQOrderBook> obs_event_hub(options);
+  std::vector<std::string> recieved_events;
+  std::vector<std::thread::id> handling_threads;
+  auto obs_dispatcher = obs_event_hub.dispatcher().lock();
+  ms_event_hub.CreateHandler().lock()->Subscribe(
+      [&](MQ::Event event, const void* data) {
+        recieved_events.push_back(MQ::Event::kNewTradeEvent == event ? "trade"
+                                                                      : "order_book");
+        handling_threads.push_back(std::this_thread::get_id());
+        if (MQ::Event::kOrderBookUpdateEvent == event) {
+          obs_dispatcher->DispatchEvent<MQOrderBook::Event::kNewSnapshotAvailable>(
+              market_stream::types::OrderBook());
+        }
+      });
+  obs_event_hub.CreateHandler().lock()->Subscribe(
+      [&](MQOrderBook::Event event, const void* data) {
+        recieved_events.push_back("snapshot");
+        handling_threads.push_back(std::this_thread::get_id());
+      });
+
+  // When
+  auto ms_dispatcher = ms_event_hub.dispatcher().lock();
+  SendDummyOrdeBookEvent(ms_dispatcher);
+  SendDummyTradeEvent(ms_dispatcher);
+  EXPECT_TRUE(recieved_events.empty());
+  EXPECT_EQ(g_transport_unit_state_impl->total_event_count(), 2);
+  const auto processed_count = inline_event_loop->RunUntilIdle();
+
+  // Then
+  EXPECT_EQ(processed_count, 3);
+  EXPECT_EQ(g_transport_unit_state_impl->total_event_count(), 0);
+  EXPECT_THAT(recieved_events,
+              ::testing::ElementsAre("order_book", "trade", "snapshot"));
+  EXPECT_THAT(handling_threads, ::testing::Each(std::this_thread::get_id()));
+}
+
+TEST_F(EventHubFixture,
+       GivenDeliveryPolicies_WhenSubscriberBusy_ThenPendingEventsConflatedOrDropped) {
+  using namespace events;
+
+  for (auto queue_type : {QueueType::kBlocking, QueueType::kLockFreeRing}) {
+    for (auto delivery_policy :
+         {DeliveryPolicy::kKeepLatest, DeliveryPolicy::kDropOldest}) {
+      // Given
+      EventHubOptions options;
+      options.queue_type = queue_type;
+      EventHub<MQ> event_hub(options);
+      std::vector<uint64_t> recieved_timestamps;
+      std::promise<void> first_event_entered;
+      std::promise<void> subscriber_released;
+      auto subscriber_released_future = subscriber_released.get_future().share();
+      event_hub.CreateHandler().lock()->Subscribe(
+          [&](MQ::Event event, const void* data) {
+            recieved_timestamps.push_back(
+                static_cast<const market_stream::types::OrderBook*>(data)->timestamp);
+            if (1 == recieved_timestamps.size()) {
+              first_event_entered.set_value();
+              subscriber_released_future.wait();
+            }
+          },
+          {MQ::Event::kOrderBookUpdateEvent}, delivery_policy, 2);
+
+      // When
+      auto dispatcher_locked = event_hub.dispatcher().lock();
+      SendOrderBookEvent(dispatcher_locked, 1);
+      first_event_entered.get_future().wait();
+      for (uint64_t ts = 2; ts <= 6; ts++) {
+        SendOrderBookEvent(dispatcher_locked, ts);
+      }
+      subscriber_released.set_value();
+      event_hub.Shutdown();
+
+      // Then
+      EXPECT_EQ(g_transport_unit_state_impl->total_event_count(), 0);
+      if (DeliveryPolicy::kKeepLatest == delivery_policy) {
+        EXPECT_THAT(recieved_timestamps, ::testing::ElementsAre(1, 6));
+      } else {
+        EXPECT_THAT(recieved_timestamps, ::testing::ElementsAre(1, 5, 6));
+      }
+    }
+  }
+}
+
+TEST_F(EventHubFixture,
+       GivenWorkerOptions_WhenEventsSent_ThenRecievedInOrderOnConfiguredThread) {
+  using namespace events;
+
+  for (auto queue_type : {QueueType::kBlocking, QueueType::kLockFreeRing}) {
+    for (auto wait_strategy :
+         {WaitStrategy::kBlocking, WaitStrategy::kBusySpin, WaitStrategy::kSpinThenYield,
+          WaitStrategy::kSpinThenPark}) {
+      // Given
+      EventHubOptions options;
+      options.queue_type = queue_type;
+      EventHub<MQ> event_hub(options);
+      WorkerOptions worker_options;
+      worker_options.wait_strategy = wait_strategy;
+      worker_options.cpu = 0;
+      worker_options.thread_name = "ms.test_worker_name";
+      const int kEventsCount = 100;
+      std::vector<uint64_t> recieved_timestamps;
+      std::string worker_thread_name;
+      int worker_cpu = -1;
+      event_hub.CreateHandler(worker_options)
+          .lock()
+          ->Subscribe([&](MQ::Event event, const void* data) {
+            recieved_timestamps.push_back(
+                static_cast<const market_stream::types::OrderBook*>(data)->timestamp);
+#ifdef __linux__
+            char name[16] = {0};
+            pthread_getname_np(pthread_self(), name, sizeof(name));
+            worker_thread_name = name;
+            worker_cpu = sched_getcpu();
+#endif
+          });
+
+      // When
+      auto dispatcher_locked = event_hub.dispatcher().lock();
+      for (int i = 0; i < kEventsCount; i++) {
+        SendOrderBookEvent(dispatcher_locked, i);
+        if (0 == i % 10) {
+          // Let the worker fall into waiting
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+      }
+      event_hub.Shutdown();
+
+      // Then
+      ASSERT_EQ(recieved_timestamps.size(), kEventsCount);
+      for (int i = 0; i < kEventsCount; i++) {
+        EXPECT_EQ(recieved_timestamps[i], i);
+      }
+#ifdef __linux__
+      EXPECT_EQ(worker_thread_name, "ms.test_worker_");
+      EXPECT_EQ(worker_cpu, 0);
+#endif
+    }
+  }
+}
+
+TEST_F(EventHubFixture,
+       GivenThreadPoolQueueType_WhenManySubscribers_ThenEachRecievesInOrderSerially) {
+  using namespace events;
+
+  // Given
+  const int kThreadsCount = 2;
+  auto thread_pool = std::make_shared<WorkStealingPool>(kThreadsCount);
+  EventHubOptions options;
+  options.queue_type = QueueType::kThreadPool;
+  options.thread_pool = thread_pool;
+  EventHub<MQ> event_hub(options);
+  const int kSubscribersCount = 16;
+  const int kEventsCount = 1000;
+  std::vector<uint64_t> recieved_timestamps[kSubscribersCount];
+  std::atomic<int> running_callbacks[kSubscribersCount] = {};
+  std::atomic<bool> is_concurrent_callback = false;
+  auto handler_locked = event_hub.CreateHandler().lock();
+  for (int i = 0; i < kSubscribersCount; i++) {
+    handler_locked->Subscribe([&, i](MQ::Event event, const void* data) {
+      if (running_callbacks[i]++ != 0) {
+        is_concurrent_callback = true;
+      }
+      recieved_timestamps[i].push_back(
+          static_cast<const market_stream::types::OrderBook*>(data)->timestamp);
+      running_callbacks[i]--;
+    });
+  }
+
+  // When
+  auto dispatcher_locked = event_hub.dispatcher().lock();
+  for (int i = 0; i < kEventsCount; i++) {
+    SendOrderBookEvent(dispatcher_locked, i);
+  }
+  event_hub.Shutdown();
+
+  // Then
+  EXPECT_EQ(g_transport_unit_state_impl->total_event_count(), 0);
+  EXPECT_FALSE(is_concurrent_callback);
+  for (int i = 0; i < kSubscribersCount; i++) {
+    ASSERT_EQ(recieved_timestamps[i].size(), kEventsCount);
+    for (int j = 0; j < kEventsCount; j++) {
+      EXPECT_EQ(recieved_timestamps[i][j], j);
+    }
+  }
+}
+
+TEST_F(EventHubFixture,
+       GivenShutDownThreadPool_WhenEventsSent_ThenDrainedByDispatcherAndHubStopped) {
+  using namespace events;
+
+  // Given
+  auto thread_pool = std::make_shared<WorkStealingPool>(2);
+  EventHubOptions options;
+  options.queue_type = QueueType::kThreadPool;
+  options.thread_pool = thread_pool;
+  EventHub<MQ> event_hub(options);
+  const int kEventsCount = 100;
+  std::vector<uint64_t> recieved_timestamps;
+  event_hub.CreateHandler().lock()->Subscribe([&](MQ::Event event, const void* data) {
+    recieved_timestamps.push_back(
+        static_cast<const market_stream::types::OrderBook*>(data)->timestamp);
+  });
+  thread_pool->Shutdown();
+
+  // When
+  auto dispatcher_locked = event_hub.dispatcher().lock();
+  for (int i = 0; i < kEventsCount; i++) {
+    SendOrderBookEvent(dispatcher_locked, i);
+  }
+  event_hub.Shutdown();
+
+  // Then
+  EXPECT_EQ(g_transport_unit_state_impl->total_event_count(), 0);
+  ASSERT_EQ(recieved_timestamps.size(), kEventsCount);
+  for (int i = 0; i < kEventsCount; i++) {
+    EXPECT_EQ(recieved_timestamps[i], i);
+  }
+}
+
+TEST_F(EventHubFixture, GivenThreadPoolHandler_WhenItStopsItsHub_ThenShutdownReturns) {
+  using namespace events;
+
+  // Given
+  auto thread_pool = std::make_shared<WorkStealingPool>(2);
+  EventHubOptions options;
+  options.queue_type = QueueType::kThreadPool;
+  options.thread_pool = thread_pool;
+  EventHub<MQ> event_hub(options);
+  std::promise<void> shutdown_promise;
+  event_hub.CreateHandler().lock()->Subscribe([&](MQ::Event event, const void* data) {
+    event_hub.Shutdown();
+    shutdown_promise.set_value();
+  });
+
+  // When
+  SendDummyOrdeBookEvent(event_hub.dispatcher().lock());
+
+  // Then
+  EXPECT_EQ(shutdown_promise.get_future().wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+  event_hub.Shutdown();
+  thread_pool->Shutdown();
+}
+
+TEST_F(EventHubFixture,
+       GivenQueuedEvents_WhenWaitForAllEventsProcessed_ThenReturnsRightAfterLastEvent) {
+  using namespace events;
+
+  for (auto queue_type : {QueueType::kBlocking, QueueType::kLockFreeRing}) {
+    // Given
+    EventHubOptions options;
+    options.queue_type = queue_type;
+    EventHub<MQ> event_hub(options);
+    std::atomic<int> recieved_events_count = 0;
+    event_hub.CreateHandler().lock()->Subscribe([&](MQ::Event event, const void* data) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      recieved_events_count++;
+    });
+    auto dispatcher_locked = event_hub.dispatcher().lock();
+    for (int i = 0; i < 5; i++) {
+      SendDummyOrdeBookEvent(dispatcher_locked);
+    }
+
+    // When
+    const auto start_time = std::chrono::steady_clock::now();
+    event_hub.WaitForAllEventsProcessed();
+    const auto wait_time = std::chrono::steady_clock::now() - start_time;
+
+    // Then
+    EXPECT_EQ(recieved_events_count, 5);
+    EXPECT_EQ(g_transport_unit_state_impl->total_event_count(), 0);
+    EXPECT_LT(wait_time, std::chrono::milliseconds(300));
+  }
+}
+
+TEST_F(EventHubFixture,
+       GivenMetricsEnabled_WhenEventsProcessed_ThenDepthAndHistogramsReported) {
+  using namespace events;
+
+  for (auto queue_type : {QueueType::kBlocking, QueueType::kLockFreeRing}) {
+    // Given
+    EventHubOptions options;
+    options.queue_type = queue_type;
+    options.enable_metrics = true;
+    EventHub<MQ> event_hub(options);
+    std::promise<void> release_handler;
+    auto release_handler_future = release_handler.get_future().share();
+    event_hub.CreateHandler().lock()->Subscribe(
+        [&](MQ::Event event, const void* data) {
+          release_handler_future.wait();
+          std::this_thread::sleep_for(std::chrono::microseconds(100));
+        },
+        {MQ::Event::kOrderBookUpdateEvent});
+    auto dispatcher_locked = event_hub.dispatcher().lock();
+
+    // When
+    for (int i = 0; i < 5; i++) {
+      SendDummyOrdeBookEvent(dispatcher_locked);
+    }
+    SendDummyTradeEvent(dispatcher_locked);
+    release_handler.set_value();
+    event_hub.WaitForAllEventsProcessed();
+
+    // Then
+    const auto metrics = event_hub.GetMetrics();
+    ASSERT_EQ(metrics.size(), 1);
+    EXPECT_EQ(metrics[0].message_queue, MQ::kClassName);
+    EXPECT_EQ(metrics[0].subscriber, "#0");
+    EXPECT_EQ(metrics[0].depth, 0);
+    EXPECT_EQ(metrics[0].max_depth, 5);
+    const auto& order_book_wait_time =
+        metrics[0].wait_time[static_cast<std::size_t>(MQ::Event::kOrderBookUpdateEvent)];
+    EXPECT_EQ(order_book_wait_time.count, 5);
+    EXPECT_GT(order_book_wait_time.max_ns, 0);
+    EXPECT_EQ(
+        metrics[0].wait_time[static_cast<std::size_t>(MQ::Event::kNewTradeEvent)].count,
+        0);
+    EXPECT_EQ(metrics[0].handle_time.count, 5);
+    EXPECT_GE(metrics[0].handle_time.PercentileNs(0.5), 100000);
+  }
+}
+
+TEST_F(EventHubFixture, GivenMetricsDisabled_WhenEventsProcessed_ThenNoMetrics) {
+  using namespace events;
+
+  // Given
+  EventHub<MQ> event_hub;
+  event_hub.CreateHandler().lock()->Subscribe([](MQ::Event event, const void* data) {});
+
+  // When
+  SendDummyOrdeBookEvent(event_hub.dispatcher().lock());
+  event_hub.WaitForAllEventsProcessed();
+
+  // Then
+  EXPECT_TRUE(event_hub.GetMetrics().empty());
+}
+
+TEST_F(EventHubFixture,
+       GivenTypedSubscribers_WhenEventsSent_ThenOnlyHandledEventsRecievedByType) {
+  using namespace events;
+
+  // Given
+  EventHub<MQ> event_hub;
+  TypedSubscriber typed_subscriber(event_hub.CreateHandler());
+  TaggedTradeSubscriber tagged_subscriber;
+  event_hub.CreateHandler().lock()->SubscribeTyped(&tagged_subscriber);
+  auto dispatcher_locked = event_hub.dispatcher().lock();
+
+  // When
+  for (int i = 0; i < 3; i++) {
+    SendOrderBookEvent(dispatcher_locked, i);
+    market_stream::types::Trade trade;
+    trade.trade_timestamp = 10 + i;
+    dispatcher_locked->DispatchEvent<MQ::Event::kNewTradeEvent>(trade);
+  }
+  event_hub.Shutdown();
+
+  // Then
+  EXPECT_EQ(typed_subscriber.order_book_timestamps, std::vector<uint64_t>({0, 1, 2}));
+  EXPECT_EQ(typed_subscriber.trade_timestamps, std::vector<uint64_t>({10, 11, 12}));
+  EXPECT_EQ(tagged_subscriber.trades_count, 3);
+  EXPECT_EQ(g_transport_unit_state_impl->total_event_count(), 0);
+}
+
 TEST_F(EventHubFixture, GivenSluggishHandler_WhenEventsSent_ThenHandlerFinishedJob) {
   using namespace events;
   // Given
@@ -0,0 +1,150 @@
+#include "events/flight_recorder.h"
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <map>
+#include <vector>
+
+#include "events/event_hub.h"
+#include "market_stream/types/types.h"
+#include "utils/tests/helpers/unit_state_mock.h"
+
+using MQ = events::message_queues::MarketStream;
+namespace {
+boost::filesystem::path TempPath(const std::string &name) {
+  return boost::filesystem::temp_directory_path() /
+         boost::filesystem::unique_path("terry_test_%%%%%%%%_" + name);
+}
+
+std::vector<boost::filesystem::path> ListFiles(const boost::filesystem::path &dir) {
+  std::vector<boost::filesystem::path> files{boost::filesystem::directory_iterator(dir),
+                                             boost::filesystem::directory_iterator()};
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+class FlightRecorderFixture : public ::testing::Test {
+ public:
+  FlightRecorderFixture()
+      : unit_state_(std::make_shared<
+                    MockUnitState<analyzer::ObservableUnits::UnitId::kTransport>>()) {}
+  void SetUp() { events::SetTransportUnitState(unit_state_); }
+  void TearDown() { events::SetTransportUnitState(nullptr); }
+
+  std::shared_ptr<MockUnitState<analyzer::ObservableUnits::UnitId::kTransport>>
+      unit_state_;
+};
+
+}  // namespace
+
+TEST(FlightRecorder, GivenSmallRing_WhenOverwritten_ThenLastRecordsReadInOrder) {
+  // Given
+  const auto path = TempPath("ring.trace");
+  {
+    events::FlightRecorder recorder(path.string(), "TestHub", 4);
+
+    // When
+    for (int i = 0; i < 10; i++) {
+      recorder.RecordDispatch(static_cast<uint16_t>(i % 2), nullptr);
+    }
+  }
+
+  // Then
+  events::FlightRecording recording(path.string());
+  EXPECT_EQ(recording.hub_name(), "TestHub");
+  ASSERT_EQ(recording.records().size(), 4);
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ(recording.records()[i].sequence, 7 + i);
+    EXPECT_EQ(recording.records()[i].event, (6 + i) % 2);
+    EXPECT_EQ(recording.records()[i].type, events::FlightRecordType::kDispatch);
+  }
+  boost::filesystem::remove(path);
+}
+
+TEST_F(FlightRecorderFixture,
+       GivenFlightRecorderEnabled_WhenEventsDispatched_ThenDispatchAndDequeuesRecorded) {
+  using namespace events;
+
+  // Given
+  const auto dir = TempPath("dir");
+  boost::filesystem::create_directories(dir);
+  const int kSubscribersCount = 2;
+  const int kEventsCount = 3;
+  {
+    EventHubOptions options;
+    options.flight_recorder_dir = dir.string();
+    EventHub<MQ> event_hub(options);
+    for (int i = 0; i < kSubscribersCount; i++) {
+      event_hub.CreateHandler().lock()->Subscribe([](MQ::Event event, const void *data) {
+      });
+    }
+
+    // When
+    auto dispatcher_locked = event_hub.dispatcher().lock();
+    for (int i = 0; i < kEventsCount; i++) {
+      dispatcher_locked->DispatchEvent<MQ::Event::kOrderBookUpdateEvent>(
+          market_stream::types::OrderBook());
+    }
+    event_hub.Shutdown();
+  }
+
+  // Then
+  const auto files = ListFiles(dir);
+  ASSERT_EQ(files.size(), 1);
+  FlightRecording recording(files[0].string());
+  EXPECT_EQ(recording.hub_name(), MQ::kClassName);
+  ASSERT_EQ(recording.records().size(), kEventsCount * (1 + kSubscribersCount));
+  std::map<uint64_t, int64_t> dispatch_times;
+  std::map<uint64_t, int> dequeues_count;
+  for (const auto &it : recording.records()) {
+    EXPECT_EQ(it.event, static_cast<uint16_t>(MQ::Event::kOrderBookUpdateEvent));
+    if (FlightRecordType::kDispatch == it.type) {
+      dispatch_times[it.sequence] = it.time_ns;
+    } else {
+      ASSERT_EQ(dispatch_times.count(it.sequence), 1);
+      EXPECT_GE(it.time_ns, dispatch_times[it.sequence]);
+      EXPECT_LT(it.queue, kSubscribersCount);
+      dequeues_count[it.sequence]++;
+    }
+  }
+  EXPECT_EQ(dispatch_times.size(), kEventsCount);
+  for (const auto &it : dequeues_count) {
+    EXPECT_EQ(it.second, kSubscribersCount);
+  }
+  boost::filesystem::remove_all(dir);
+}
+
+TEST_F(FlightRecorderFixture, GivenHubsOfSameType_WhenRecordingToSameDir_ThenOwnFiles) {
+  using namespace events;
+
+  // Given
+  const auto dir = TempPath("dir");
+  boost::filesystem::create_directories(dir);
+  EventHubOptions options;
+  options.flight_recorder_dir = dir.string();
+  {
+    EventHub<MQ> event_hub(options);
+    EventHub<MQ> other_event_hub(options);
+
+    // When
+    event_hub.dispatcher().lock()->DispatchEvent<MQ::Event::kOrderBookUpdateEvent>(
+        market_stream::types::OrderBook());
+    event_hub.Shutdown();
+    other_event_hub.Shutdown();
+  }
+
+  // Then
+  const auto files = ListFiles(dir);
+  ASSERT_EQ(files.size(), 2);
+  std::vector<std::size_t> records_counts;
+  for (const auto &it : files) {
+    EXPECT_THAT(it.filename().string(), ::testing::StartsWith(MQ::kClassName));
+    FlightRecording recording(it.string());
+    EXPECT_EQ(recording.hub_name(), MQ::kClassName);
+    records_counts.push_back(recording.records().size());
+  }
+  EXPECT_THAT(records_counts, ::testing::UnorderedElementsAre(0, 1));
+  boost::filesystem::remove_all(dir);
+}
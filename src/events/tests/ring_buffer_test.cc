@@ -0,0 +1,87 @@
+#include "events/ring_buffer.h"
+
+#include <gmock/gmock.h>
+
+#include <thread>
+#include <vector>
+
+TEST(RingBuffer, GivenEmptyRing_WhenPushUntilFull_ThenPushFailsAndPopsInSameOrder) {
+  // Given
+  events::RingBuffer<int> ring(4);
+  ASSERT_TRUE(ring.empty());
+
+  // When
+  for (int i = 0; i < 4; i++) {
+    ASSERT_TRUE(ring.TryPush([i](int &slot) { slot = i; }));
+  }
+
+  // Then
+  EXPECT_FALSE(ring.TryPush([](int &slot) { slot = 100; }));
+  for (int i = 0; i < 4; i++) {
+    int value = -1;
+    ASSERT_TRUE(ring.TryPop([&value](int &slot) { value = slot; }));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_TRUE(ring.empty());
+  EXPECT_FALSE(ring.TryPop([](int &slot) {}));
+}
+
+TEST(RingBuffer, GivenReusedSlot_WhenPushSmallerPayload_ThenSlotCapacityKept) {
+  // Given
+  events::RingBuffer<std::vector<int>> ring(2);
+  const std::vector<int> big(1000, 1);
+  const std::vector<int> small(10, 2);
+  ring.TryPush([&big](std::vector<int> &slot) { slot = big; });
+  ring.TryPop([](std::vector<int> &slot) {});
+  ring.TryPush([&big](std::vector<int> &slot) { slot = big; });
+  ring.TryPop([](std::vector<int> &slot) {});
+
+  // When
+  std::size_t capacity = 0;
+  ring.TryPush([&small](std::vector<int> &slot) { slot = small; });
+  ring.TryPop([&capacity, &small](std::vector<int> &slot) {
+    EXPECT_EQ(slot, small);
+    capacity = slot.capacity();
+  });
+
+  // Then
+  EXPECT_GE(capacity, big.size());
+}
+
+TEST(RingBuffer, GivenSeveralProducers_WhenPushConcurrently_ThenAllValuesConsumed) {
+  // Given
+  const int kProducersCount = 4;
+  const int kValuesPerProducer = 10000;
+  events::RingBuffer<std::pair<int, int>> ring(64);
+
+  // When
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducersCount; p++) {
+    producers.emplace_back([&ring, p]() {
+      for (int i = 0; i < kValuesPerProducer; i++) {
+        while (!ring.TryPush([p, i](std::pair<int, int> &slot) { slot = {p, i}; })) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  std::vector<int> last_value(kProducersCount, -1);
+  int consumed_count = 0;
+  while (consumed_count < kProducersCount * kValuesPerProducer) {
+    ring.TryPop([&](std::pair<int, int> &slot) {
+      // Then
+      EXPECT_EQ(last_value[slot.first] + 1, slot.second);
+      last_value[slot.first] = slot.second;
+      consumed_count++;
+    });
+  }
+  for (auto &it : producers) {
+    it.join();
+  }
+
+  // Then
+  EXPECT_TRUE(ring.empty());
+  for (int p = 0; p < kProducersCount; p++) {
+    EXPECT_EQ(last_value[p], kValuesPerProducer - 1);
+  }
+}
@@ -0,0 +1,217 @@
+#include "events/shm_bus.h"
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "market_stream/types/types.h"
+#include "utils/tests/helpers/unit_state_mock.h"
+
+using MQ = events::message_queues::MarketStream;
+namespace {
+std::string UniqueRingName(const std::string &name) {
+  return "terry_test." + name + "." +
+         std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+}
+
+bool PublishInt(events::ShmRingWriter *writer, int value) {
+  return writer->Publish(1, [value](char *data, std::size_t size) {
+    std::memcpy(data, &value, sizeof(value));
+    return sizeof(value);
+  });
+}
+
+events::ShmRingReader::ReadResult ReadInt(events::ShmRingReader *reader, int *value) {
+  return reader->TryRead([value](uint32_t tag, const char *data, std::size_t size) {
+    std::memcpy(value, data, sizeof(*value));
+  });
+}
+
+class ShmBusFixture : public ::testing::Test {
+ public:
+  ShmBusFixture()
+      : unit_state_(std::make_shared<
+                    MockUnitState<analyzer::ObservableUnits::UnitId::kTransport>>()) {}
+  void SetUp() { events::SetTransportUnitState(unit_state_); }
+  void TearDown() { events::SetTransportUnitState(nullptr); }
+
+  std::shared_ptr<MockUnitState<analyzer::ObservableUnits::UnitId::kTransport>>
+      unit_state_;
+};
+
+}  // namespace
+
+TEST(ShmRing, GivenReader_WhenMessagesPublished_ThenReadInSameOrder) {
+  using ReadResult = events::ShmRingReader::ReadResult;
+
+  // Given
+  const auto name = UniqueRingName("order");
+  events::ShmRingWriter writer(name, 8, 64);
+  ASSERT_TRUE(PublishInt(&writer, -1));
+  events::ShmRingReader reader(name);
+
+  // When
+  for (int i = 0; i < 5; i++) {
+    ASSERT_TRUE(PublishInt(&writer, i));
+  }
+
+  // Then
+  for (int i = 0; i < 5; i++) {
+    int value = -1;
+    ASSERT_EQ(ReadInt(&reader, &value), ReadResult::kRead);
+    EXPECT_EQ(value, i);
+  }
+  int value = -1;
+  EXPECT_EQ(ReadInt(&reader, &value), ReadResult::kEmpty);
+  EXPECT_EQ(reader.lagged_messages(), 0);
+}
+
+TEST(ShmRing, GivenSlowReader_WhenRingOverwritten_ThenLagReportedAndNewMessagesRead) {
+  using ReadResult = events::ShmRingReader::ReadResult;
+
+  // Given
+  const auto name = UniqueRingName("lag");
+  events::ShmRingWriter writer(name, 4, 64);
+  events::ShmRingReader reader(name);
+
+  // When
+  for (int i = 0; i < 10; i++) {
+    ASSERT_TRUE(PublishInt(&writer, i));
+  }
+
+  // Then
+  int value = -1;
+  EXPECT_EQ(ReadInt(&reader, &value), ReadResult::kLagged);
+  EXPECT_EQ(reader.lagged_messages(), 10);
+  EXPECT_EQ(ReadInt(&reader, &value), ReadResult::kEmpty);
+  ASSERT_TRUE(PublishInt(&writer, 10));
+  EXPECT_EQ(ReadInt(&reader, &value), ReadResult::kRead);
+  EXPECT_EQ(value, 10);
+}
+
+TEST(ShmRing, GivenTooBigMessage_WhenPublished_ThenSkipped) {
+  using ReadResult = events::ShmRingReader::ReadResult;
+
+  // Given
+  const auto name = UniqueRingName("big");
+  events::ShmRingWriter writer(name, 4, 64);
+  events::ShmRingReader reader(name);
+
+  // When
+  EXPECT_FALSE(writer.Publish(1, [](char *data, std::size_t size) { return 0; }));
+  ASSERT_TRUE(PublishInt(&writer, 7));
+
+  // Then
+  int value = -1;
+  EXPECT_EQ(ReadInt(&reader, &value), ReadResult::kRead);
+  EXPECT_EQ(value, 7);
+  EXPECT_EQ(ReadInt(&reader, &value), ReadResult::kEmpty);
+}
+
+TEST_F(ShmBusFixture, GivenBusSubscriber_WhenEventsPublished_ThenLocalHandlersRecieve) {
+  using namespace events;
+
+  // Given
+  const auto bus_name = UniqueRingName("bus");
+  EventHub<MQ> publisher_hub;
+  ShmBusPublisher<MQ> publisher(publisher_hub.CreateHandler(), bus_name);
+
+  EventHub<MQ> subscriber_hub;
+  std::vector<uint64_t> recieved_timestamps;
+  std::vector<MQ::Event> recieved_events;
+  std::atomic<int> recieved_events_count = 0;
+  subscriber_hub.CreateHandler().lock()->Subscribe([&](MQ::Event event,
+                                                       const void *data) {
+    recieved_events.push_back(event);
+    recieved_events_count++;
+    if (MQ::Event::kOrderBookUpdateEvent == event) {
+      const auto *order_book = static_cast<const market_stream::types::OrderBook *>(data);
+      recieved_timestamps.push_back(order_book->timestamp);
+      EXPECT_EQ(order_book->bids.size(), 2);
+    }
+  });
+  ShmBusSubscriber<MQ> subscriber(subscriber_hub.dispatcher(), bus_name);
+
+  // When
+  auto dispatcher_locked = publisher_hub.dispatcher().lock();
+  for (int i = 0; i < 10; i++) {
+    market_stream::types::OrderBook order_book;
+    order_book.timestamp = i;
+    order_book.bids = {{1, 2}, {3, 4}};
+    dispatcher_locked->DispatchEvent<MQ::Event::kOrderBookUpdateEvent>(order_book);
+  }
+  dispatcher_locked->DispatchEvent<MQ::Event::kNewTradeEvent>(
+      market_stream::types::Trade());
+  publisher_hub.WaitForAllEventsProcessed();
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (recieved_events_count < 11 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  subscriber.Stop();
+  subscriber_hub.Shutdown();
+
+  // Then
+  ASSERT_EQ(recieved_events.size(), 11);
+  EXPECT_EQ(recieved_events.back(), MQ::Event::kNewTradeEvent);
+  ASSERT_EQ(recieved_timestamps.size(), 10);
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(recieved_timestamps[i], i);
+  }
+  EXPECT_EQ(subscriber.lagged_events(), 0);
+}
+
+TEST_F(ShmBusFixture, GivenBookSlotSize_WhenFullDepthBookPublished_ThenRecievedWhole) {
+  using namespace events;
+
+  // Given
+  const std::size_t kLevelsCount = 5000;
+  const auto bus_name = UniqueRingName("book");
+  ShmBusOptions options;
+  options.capacity = 4;
+  options.slot_size = kBookShmBusSlotSize;
+  EventHub<MQ> publisher_hub;
+  ShmBusPublisher<MQ> publisher(publisher_hub.CreateHandler(), bus_name, options);
+
+  EventHub<MQ> subscriber_hub;
+  market_stream::types::OrderBook recieved_order_book;
+  std::atomic<int> recieved_events_count = 0;
+  subscriber_hub.CreateHandler().lock()->Subscribe([&](MQ::Event event,
+                                                       const void *data) {
+    if (MQ::Event::kOrderBookUpdateEvent == event) {
+      recieved_order_book = *static_cast<const market_stream::types::OrderBook *>(data);
+    }
+    recieved_events_count++;
+  });
+  ShmBusSubscriber<MQ> subscriber(subscriber_hub.dispatcher(), bus_name);
+
+  market_stream::types::OrderBook order_book;
+  order_book.timestamp = 1;
+  for (std::size_t i = 0; i < kLevelsCount; i++) {
+    order_book.bids.emplace_back(30000.0 - 0.01 * i, 123456.789 + i);
+    order_book.asks.emplace_back(30000.01 + 0.01 * i, 123456.789 + i);
+  }
+
+  // When
+  publisher_hub.dispatcher().lock()->DispatchEvent<MQ::Event::kOrderBookUpdateEvent>(
+      order_book);
+  publisher_hub.WaitForAllEventsProcessed();
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (recieved_events_count < 1 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  subscriber.Stop();
+  subscriber_hub.Shutdown();
+
+  // Then
+  ASSERT_EQ(recieved_events_count, 1);
+  EXPECT_EQ(recieved_order_book.bids.size(), kLevelsCount);
+  EXPECT_EQ(recieved_order_book.asks.size(), kLevelsCount);
+  EXPECT_EQ(recieved_order_book, order_book);
+}
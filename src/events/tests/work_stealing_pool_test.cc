@@ -0,0 +1,75 @@
+#include "events/work_stealing_pool.h"
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+
+TEST(WorkStealingPool, GivenPool_WhenTasksSubmitted_ThenAllRunOnPoolThreads) {
+  // Given
+  const int kThreadsCount = 3;
+  const int kTasksCount = 10000;
+  events::WorkStealingPool pool(kThreadsCount);
+  std::atomic<int> done_tasks_count = 0;
+  std::mutex mutex;
+  std::set<std::thread::id> thread_ids;
+
+  // When
+  for (int i = 0; i < kTasksCount; i++) {
+    pool.Submit([&]() {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        thread_ids.insert(std::this_thread::get_id());
+      }
+      done_tasks_count++;
+    });
+  }
+  pool.Shutdown();
+
+  // Then
+  EXPECT_EQ(done_tasks_count, kTasksCount);
+  EXPECT_LE(thread_ids.size(), kThreadsCount);
+  EXPECT_EQ(thread_ids.count(std::this_thread::get_id()), 0);
+}
+
+TEST(WorkStealingPool, GivenBusyWorker_WhenTaskSubmittedFromIt_ThenStolenByIdleWorker) {
+  // Given
+  events::WorkStealingPool pool(2);
+  std::atomic<bool> is_stolen_task_done = false;
+  std::thread::id busy_thread_id;
+  std::thread::id stolen_thread_id;
+
+  // When
+  pool.Submit([&]() {
+    busy_thread_id = std::this_thread::get_id();
+    pool.Submit([&]() {
+      stolen_thread_id = std::this_thread::get_id();
+      is_stolen_task_done = true;
+    });
+    // Blocks its worker until the task from its own deque is run by another one
+    while (!is_stolen_task_done) {
+      std::this_thread::yield();
+    }
+  });
+  pool.Shutdown();
+
+  // Then
+  EXPECT_TRUE(is_stolen_task_done);
+  EXPECT_NE(busy_thread_id, stolen_thread_id);
+}
+
+TEST(WorkStealingPool, GivenShutDownPool_WhenTaskSubmitted_ThenRejected) {
+  // Given
+  events::WorkStealingPool pool(2);
+  bool is_task_done = false;
+  pool.Shutdown();
+
+  // When
+  const bool is_submitted = pool.Submit([&]() { is_task_done = true; });
+
+  // Then
+  EXPECT_FALSE(is_submitted);
+  EXPECT_FALSE(is_task_done);
+}
@@ -0,0 +1,135 @@
+#include "events/work_stealing_pool.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+#include "events/event_hub.h"
+
+namespace events {
+
+namespace {
+// Index of the pool worker running on this thread, used to keep tasks
+// submitted from a worker on the same worker
+thread_local const WorkStealingPool *gCurrentPool = nullptr;
+thread_local std::size_t gCurrentWorkerIndex = 0;
+}  // namespace
+
+WorkStealingPool::WorkStealingPool(std::size_t threads_count,
+                                   const std::string &thread_name) {
+  if (0 == threads_count) {
+    threads_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (std::size_t i = 0; i < threads_count; i++) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  for (std::size_t i = 0; i < threads_count; i++) {
+    threads_.emplace_back(&WorkStealingPool::WorkerLoop, this, i, thread_name);
+  }
+  spdlog::debug("WorkStealingPool started with {} threads", threads_count);
+}
+
+WorkStealingPool::~WorkStealingPool() { Shutdown(); }
+
+bool WorkStealingPool::Submit(Task &&task) {
+  // Counted before the push, so a worker that steals and finishes the task first
+  // never sees a negative count. A worker exits only when it reads no pending
+  // tasks after is_stopped_ is set, so either it keeps running for this task or
+  // is_stopped_ is seen here. Tasks of a running task are taken while the pool
+  // drains, their worker is not done yet.
+  pending_tasks_++;
+  if (this != gCurrentPool && is_stopped_) {
+    pending_tasks_--;
+    spdlog::warn("Task is submitted to WorkStealingPool after shutdown");
+    return false;
+  }
+
+  std::size_t worker_index = 0;
+  if (this == gCurrentPool) {
+    worker_index = gCurrentWorkerIndex;
+  } else {
+    worker_index = next_worker_++ % workers_.size();
+  }
+
+  {
+    auto &worker = *workers_[worker_index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.tasks.push_back(std::move(task));
+  }
+
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (idle_workers_.load(std::memory_order_relaxed) > 0) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cv_.notify_one();
+  }
+  return true;
+}
+
+void WorkStealingPool::Shutdown() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopped_ = true;
+  }
+  cv_.notify_all();
+  for (auto &it : threads_) {
+    if (it.joinable()) {
+      it.join();
+    }
+  }
+}
+
+void WorkStealingPool::WorkerLoop(std::size_t worker_index,
+                                  const std::string &thread_name) {
+  WorkerOptions worker_options;
+  worker_options.thread_name = thread_name;
+  SetupWorkerThread(worker_options);
+
+  gCurrentPool = this;
+  gCurrentWorkerIndex = worker_index;
+
+  while (true) {
+    Task task;
+    if (TryPopTask(worker_index, &task)) {
+      pending_tasks_--;
+      task();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_workers_++;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    cv_.wait(lock, [this] { return pending_tasks_ > 0 || is_stopped_; });
+    idle_workers_--;
+
+    if (is_stopped_ && 0 == pending_tasks_) {
+      break;
+    }
+  }
+
+  gCurrentPool = nullptr;
+}
+
+bool WorkStealingPool::TryPopTask(std::size_t worker_index, Task *task) {
+  {
+    auto &worker = *workers_[worker_index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (!worker.tasks.empty()) {
+      *task = std::move(worker.tasks.front());
+      worker.tasks.pop_front();
+      return true;
+    }
+  }
+
+  for (std::size_t i = 1; i < workers_.size(); i++) {
+    auto &victim = *workers_[(worker_index + i) % workers_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      *task = std::move(victim.tasks.back());
+      victim.tasks.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace events
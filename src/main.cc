@@ -5,12 +5,15 @@
 #include <iostream>
 #include <memory>
 
+#include "commands/command_bus_publish_handler.h"
 #include "commands/command_handler.h"
+#include "commands/command_orderbook_bench_handler.h"
 #include "commands/command_orderbook_test_handler.h"
 #include "commands/command_strategy_test_handler.h"
 #include "commands/command_strategy_test_online_handler.h"
 #include "commands/command_stream_load_handler.h"
 #include "commands/command_stream_save_handler.h"
+#include "commands/command_trace_dump_handler.h"
 
 int main(int argc, const char* argv[]) {
   spdlog::cfg::load_env_levels();
@@ -54,11 +57,38 @@ int main(int argc, const char* argv[]) {
       std::cerr << "Unknown command.\n";
       return -1;
     }
+  } else if ("bus" == context) {
+    if (argc <= 2) {
+      std::cerr << "You must specify the command.\n";
+      return -1;
+    }
+    std::string command = argv[2];
+    if (command == "publish") {
+      command_handler = std::make_unique<commands::CommandBusPublishHandler>(argc, argv);
+    } else {
+      std::cerr << "Unknown command.\n";
+      return -1;
+    }
+  } else if ("trace" == context) {
+    if (argc <= 2) {
+      std::cerr << "You must specify the command.\n";
+      return -1;
+    }
+    std::string command = argv[2];
+    if (command == "dump") {
+      command_handler = std::make_unique<commands::CommandTraceDumpHandler>(argc, argv);
+    } else {
+      std::cerr << "Unknown command.\n";
+      return -1;
+    }
   } else if ("orderbook" == context) {
     std::string command = argv[2];
     if (command == "test") {
       command_handler =
           std::make_unique<commands::CommandOrderBookTestHandler>(argc, argv);
+    } else if (command == "bench") {
+      command_handler =
+          std::make_unique<commands::CommandOrderBookBenchHandler>(argc, argv);
     } else {
       std::cerr << "Unknown command.\n";
       return -1;
@@ -12,6 +12,8 @@ namespace {
 const std::string gHost = "api.binance.com";
 const std::string gWSHost = "stream.binance.com";
 const int gDepthRequestLevels = 5000;
+// Delay before a failed request is sent again or the stream is reconnected
+const auto gRetryDelay = std::chrono::seconds(1);
 }  // namespace
 
 namespace market_stream {
@@ -118,8 +120,12 @@ void BinAPIClient::SubscribeToTradeStream(const TradeRawCallback& trade_cb) {
   });
 }
 
-BinAPIClient::~BinAPIClient() {
-  stop_monitor_thread_ = true;
+BinAPIClient::~BinAPIClient() { Stop(); }
+
+void BinAPIClient::Stop() {
+  if (stop_monitor_thread_.exchange(true)) {
+    return;
+  }
   if (run_ws_combined_stream_) {
     spdlog::warn("BinAPIClient async_unsubscribe_all.");
     ws_->async_unsubscribe_all();
@@ -131,12 +137,29 @@ BinAPIClient::~BinAPIClient() {
 
 void BinAPIClient::GetDepthAsync(const DepthRawCallback& depth_callback) {
   assert(depth_callback != nullptr);
+  RequestDepth(depth_callback);
+  if (!run_ws_combined_stream_) {
+    monitor_thread_ = std::thread([this]() {
+      spdlog::info("io_context run started");
+      io_context_.reset();
+      io_context_.run();
+      spdlog::warn("io_context run finished");
+    });
+    monitor_thread_.detach();
+  }
+  spdlog::debug("BinAPIClient GET depths request sent.");
+}
+
+void BinAPIClient::RequestDepth(const DepthRawCallback& depth_callback) {
   api_->depths(symbol_, gDepthRequestLevels,
-               [depth_callback](const char* fl, int ec, std::string errmsg, auto res) {
+               [this, depth_callback](const char* fl, int ec, std::string errmsg,
+                                      auto res) {
                  if (ec) {
-                   spdlog::error("get depth error: fl={}, ec={}, emsg={}", fl, ec,
-                                 errmsg);
-                   exit(-1);
+                   spdlog::error("get depth error: fl={}, ec={}, emsg={}. Retry in {} s.",
+                                 fl, ec, errmsg, gRetryDelay.count());
+                   RunAfterRetryDelay(
+                       [this, depth_callback]() { RequestDepth(depth_callback); });
+                   return true;
                  }
                  if (spdlog::get_level() == spdlog::level::trace) {
                    std::stringstream ss;
@@ -147,24 +170,36 @@ void BinAPIClient::GetDepthAsync(const DepthRawCallback& depth_callback) {
                  depth_callback(std::move(res));
                  return true;
                });
-  if (!run_ws_combined_stream_) {
-    monitor_thread_ = std::thread([this]() {
-      spdlog::info("io_context run started");
-      io_context_.reset();
-      io_context_.run();
-      spdlog::warn("io_context run finished");
-    });
-    monitor_thread_.detach();
-  }
-  spdlog::debug("BinAPIClient GET depths request sent.");
 }
+
+void BinAPIClient::RunCombinedStream() {
+  ws_->combined_stream_run(
+      symbol_.c_str(),
+      [this](const char* fl, int ec, std::string emsg, auto combined_stream) {
+        if (stop_monitor_thread_) {
+          return;
+        }
+        // Updates missed meanwhile show up as a gap in the depth update ids, the
+        // order book stream resyncs on it
+        spdlog::error(
+            "combined_stream_run error: fl={}, ec={}, emsg={}. Reconnect in {} s.", fl,
+            ec, emsg, gRetryDelay.count());
+        RunAfterRetryDelay([this]() { RunCombinedStream(); });
+      });
+}
+
+void BinAPIClient::RunAfterRetryDelay(const std::function<void()>& func) {
+  auto timer = std::make_shared<boost::asio::steady_timer>(io_context_, gRetryDelay);
+  timer->async_wait([this, timer, func](const boost::system::error_code& ec) {
+    if (!ec && !stop_monitor_thread_) {
+      func();
+    }
+  });
+}
+
 void BinAPIClient::Run() {
   if (run_ws_combined_stream_) {
-    ws_->combined_stream_run(symbol_.c_str(), [](const char* fl, int ec, std::string emsg,
-                                                 auto combined_stream) {
-      spdlog::error("combined_stream_run error: fl={}, ec={}, emsg={}", fl, ec, emsg);
-      exit(-1);
-    });
+    RunCombinedStream();
     monitor_thread_ = std::thread([this]() {
       spdlog::info("io_context run started");
       io_context_.run();
@@ -2,25 +2,38 @@
 
 #include <spdlog/spdlog.h>
 
+#include <boost/filesystem.hpp>
+
 #include "market_stream/binapi_client.h"
 #include "utils/time/global_clock.h"
 
 namespace market_stream {
 
 MarketStreamForwarder::MarketStreamForwarder(
-    const std::string& symbol, const std::weak_ptr<EventHubDispatcher>& event_dispatcher)
-    : symbol_(symbol), event_dispatcher_(event_dispatcher) {}
+    const std::string& symbol, const std::weak_ptr<EventHubDispatcher>& event_dispatcher,
+    const std::string& state_dir)
+    : event_dispatcher_(event_dispatcher), symbol_(symbol), state_dir_(state_dir) {}
+
+MarketStreamForwarder::~MarketStreamForwarder() { Stop(); }
 
 void MarketStreamForwarder::Initialize() {
   spdlog::info("MarketStreamForwarder initializing for {} pair", symbol_);
 
   binapi_client_ = std::make_shared<BinAPIClient>(symbol_);
+  std::string state_path;
+  if (!state_dir_.empty()) {
+    state_path =
+        (boost::filesystem::path(state_dir_) / (symbol_ + "_order_book_state.bin"))
+            .string();
+  }
   trade_stream_ = std::make_unique<TradeStreamForwarder>(
       binapi_client_,
       std::bind(&MarketStreamForwarder::OnTradeReceived, this, std::placeholders::_1));
   order_book_stream_ = std::make_unique<OrderBookStreamForwarder>(
       binapi_client_,
-      std::bind(&MarketStreamForwarder::OnOrderBookUpdate, this, std::placeholders::_1));
+      std::bind(&MarketStreamForwarder::OnOrderBookUpdate, this, std::placeholders::_1),
+      std::bind(&MarketStreamForwarder::OnOrderBookResync, this, std::placeholders::_1),
+      state_path);
   spdlog::info("run binapi client");
   binapi_client_->Run();
   spdlog::info("MarketStreamForwarder initialized");
@@ -30,6 +43,21 @@ void MarketStreamForwarder::StartAsync() {
   spdlog::info("run market stream forwarder...");
 }
 
+void MarketStreamForwarder::Stop() {
+  if (is_stopped_) {
+    return;
+  }
+  is_stopped_ = true;
+  // The stream callbacks run on the binapi io thread until it is joined
+  if (nullptr != binapi_client_) {
+    binapi_client_->Stop();
+  }
+  if (nullptr != order_book_stream_) {
+    order_book_stream_->SaveState();
+  }
+  spdlog::info("MarketStreamForwarder stopped");
+}
+
 void MarketStreamForwarder::OnTradeReceived(types::Trade&& trade) {
   if (order_book_stream_started_) {
     trade.received_timestamp = utils::GlobalClock::Instance().Now();
@@ -48,7 +76,18 @@ void MarketStreamForwarder::OnOrderBookUpdate(types::OrderBook&& update) {
   update.received_timestamp = utils::GlobalClock::Instance().Now();
   auto event_dispatcher_locked = event_dispatcher_.lock();
   if (event_dispatcher_locked) {
-    event_dispatcher_locked->DispatchEvent<MQ::Event::kOrderBookUpdateEvent>(update);
+    event_dispatcher_locked->DispatchSharedEvent<MQ::Event::kOrderBookUpdateEvent>(
+        std::make_shared<const types::OrderBook>(std::move(update)));
+  }
+}
+
+void MarketStreamForwarder::OnOrderBookResync(types::OrderBook&& order_book) {
+  types::OrderBookResync resync;
+  resync.order_book = std::move(order_book);
+  resync.order_book.received_timestamp = utils::GlobalClock::Instance().Now();
+  auto event_dispatcher_locked = event_dispatcher_.lock();
+  if (event_dispatcher_locked) {
+    event_dispatcher_locked->DispatchEvent<MQ::Event::kOrderBookResyncEvent>(resync);
   }
 }
 
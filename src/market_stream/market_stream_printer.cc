@@ -5,24 +5,19 @@ namespace market_stream {
 MarketStreamPrinter::MarketStreamPrinter(
     const std::weak_ptr<EventHubHandler>& event_handler, std::ostream& out_stream)
     : out_stream_(out_stream) {
-  SUBSCRIBE_TO_EVENT(event_handler, &MarketStreamPrinter::OnMarketStreamEvent);
+  SUBSCRIBE_TO_TYPED_EVENTS(event_handler);
 }
 
 MarketStreamPrinter::~MarketStreamPrinter() { std::flush(out_stream_); }
 
-void MarketStreamPrinter::OnMarketStreamEvent(MQ::Event event, const void* data) {
-  switch (event) {
-    case MQ::Event::kNewTradeEvent:
-      out_stream_ << *static_cast<const market_stream::types::Trade*>(data);
-      break;
+void MarketStreamPrinter::OnEvent(const types::Trade& trade) { out_stream_ << trade; }
 
-    case MQ::Event::kOrderBookUpdateEvent:
-      out_stream_ << *static_cast<const market_stream::types::OrderBook*>(data);
-      break;
-    default:
-      spdlog::error("MarketStreamPrinter unkown event {}", static_cast<int>(event));
-      break;
-  }
+void MarketStreamPrinter::OnEvent(const types::OrderBook& order_book) {
+  out_stream_ << order_book;
+}
+
+void MarketStreamPrinter::OnEvent(const types::OrderBookResync& resync) {
+  out_stream_ << resync;
 }
 
 }  // namespace market_stream
\ No newline at end of file
@@ -16,7 +16,7 @@ MarketStreamSaver::MarketStreamSaver(const std::weak_ptr<EventHubHandler>& event
   }
   archive_ = std::make_unique<boost::archive::binary_oarchive>(file_);
 
-  SUBSCRIBE_TO_EVENT(event_handler, &MarketStreamSaver::OnMarketStreamEvent);
+  SUBSCRIBE_TO_TYPED_EVENTS(event_handler);
 }
 
 MarketStreamSaver::~MarketStreamSaver() {
@@ -26,23 +26,19 @@ MarketStreamSaver::~MarketStreamSaver() {
 
 std::string MarketStreamSaver::filename() { return "market_stream.bin"; }
 
-void MarketStreamSaver::OnMarketStreamEvent(MQ::Event event, const void* data) {
-  switch (event) {
-    case MQ::Event::kNewTradeEvent:
-      spdlog::debug("write new trade");
-      *archive_ << types::MarketDataType::TRADE
-                << *static_cast<const market_stream::types::Trade*>(data);
-      break;
-
-    case MQ::Event::kOrderBookUpdateEvent:
-      spdlog::debug("write order book update");
-      *archive_ << types::MarketDataType::ORDER_BOOK
-                << *static_cast<const market_stream::types::OrderBook*>(data);
-      break;
-    default:
-      spdlog::error("MarketStreamPrinter unkown event {}", static_cast<int>(event));
-      break;
-  }
+void MarketStreamSaver::OnEvent(const types::Trade& trade) {
+  spdlog::debug("write new trade");
+  *archive_ << types::MarketDataType::TRADE << trade;
+}
+
+void MarketStreamSaver::OnEvent(const types::OrderBook& order_book) {
+  spdlog::debug("write order book update");
+  *archive_ << types::MarketDataType::ORDER_BOOK << order_book;
+}
+
+void MarketStreamSaver::OnEvent(const types::OrderBookResync& resync) {
+  spdlog::debug("write order book resync");
+  *archive_ << types::MarketDataType::ORDER_BOOK_RESYNC << resync.order_book;
 }
 
 }  // namespace market_stream
\ No newline at end of file
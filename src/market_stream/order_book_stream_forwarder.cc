@@ -2,23 +2,99 @@
 
 #include <spdlog/spdlog.h>
 
-#include <cassert>
+#include <boost/filesystem.hpp>
+#include <fstream>
 
 #include "market_stream/binapi_client.h"
 
 namespace market_stream {
 
+namespace {
+// Same bound as the order book snapshot provider
+const std::size_t gStateMaxLevels = 6000;
+// About 100 s of updates. The depth snapshot needs the updates after it only,
+// and it is newer than the ones buffered that long ago.
+const std::size_t gMaxBufferedUpdatesCount = 1000;
+}  // namespace
+
 OrderBookStreamForwarder::OrderBookStreamForwarder(
     const std::shared_ptr<IBinAPIClient>& binapi_client,
-    const OrderBookUpdateCallback& order_book_update_cb)
+    const OrderBookUpdateCallback& order_book_update_cb,
+    const OrderBookUpdateCallback& order_book_resync_cb, const std::string& state_path)
     : binapi_client_(binapi_client),
       order_book_update_cb_(order_book_update_cb),
-      init_stage_(InitStage::WAIT_FOR_FIRST_BUFFER_UPDATE) {
+      order_book_resync_cb_(order_book_resync_cb),
+      init_stage_(InitStage::WAIT_FOR_FIRST_BUFFER_UPDATE),
+      state_path_(state_path) {
+  if (!state_path_.empty()) {
+    stored_state_ = ReadState(state_path_);
+  }
   binapi_client_->SubscribeToDepthStream(std::bind(
       &OrderBookStreamForwarder::OnBinAPIDepthUpdate, this, std::placeholders::_1));
   spdlog::info("OrderBookStreamForwarder initialized");
 }
 
+void OrderBookStreamForwarder::SaveState() {
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  if (nullptr == state_engine_) {
+    return;
+  }
+  types::OrderBookState state;
+  state.last_update_id = state_last_update_id_;
+  state_engine_->CopyTo(&state.order_book);
+  if (WriteState(state_path_, state)) {
+    spdlog::info("Order book state {} written to {}", state.last_update_id, state_path_);
+  }
+}
+
+bool OrderBookStreamForwarder::WriteState(const std::string& path,
+                                          const types::OrderBookState& state) {
+  // Written aside and renamed over the old file, so a crash while writing never
+  // leaves a partial state behind
+  const std::string tmp_path = path + ".tmp";
+  {
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!file.is_open()) {
+      spdlog::error("Cannot open order book state file: {}", tmp_path);
+      return false;
+    }
+    {
+      boost::archive::binary_oarchive archive(file);
+      archive << state;
+    }
+    file.flush();
+    if (!file) {
+      spdlog::error("Cannot write order book state file: {}", tmp_path);
+      return false;
+    }
+  }
+  boost::system::error_code error;
+  boost::filesystem::rename(tmp_path, path, error);
+  if (error) {
+    spdlog::error("Cannot replace order book state file {}: {}", path, error.message());
+    return false;
+  }
+  return true;
+}
+
+std::optional<types::OrderBookState> OrderBookStreamForwarder::ReadState(
+    const std::string& path) {
+  std::ifstream file(path, std::ios::binary | std::ios::in);
+  if (!file.is_open()) {
+    spdlog::info("No order book state at {}", path);
+    return std::nullopt;
+  }
+  types::OrderBookState state;
+  try {
+    boost::archive::binary_iarchive archive(file);
+    archive >> state;
+  } catch (const std::exception& e) {
+    spdlog::warn("Cannot read order book state {}: {}", path, e.what());
+    return std::nullopt;
+  }
+  return state;
+}
+
 std::future<void> OrderBookStreamForwarder::StartAsync() {
   return stream_started_promise_.get_future();
 }
@@ -28,26 +104,29 @@ void OrderBookStreamForwarder::OnBinAPIDepthUpdate(
   spdlog::debug("OnBinAPIDepthUpdate");
   switch (init_stage_) {
     case InitStage::WAIT_FOR_FIRST_BUFFER_UPDATE:
+      if (ResumeFromStoredState(diff_depths)) {
+        break;
+      }
       spdlog::debug("First update recieved. Send get depth request.");
-      depth_updates_buffer_.emplace_back(std::move(diff_depths));
-      binapi_client_->GetDepthAsync(std::bind(
-          &OrderBookStreamForwarder::OnBinAPIDepthRecieve, this, std::placeholders::_1));
-      init_stage_ = InitStage::DEPTH_SNAPSHOT_REQUESTED;
+      RequestDepthSnapshot(std::move(diff_depths));
       break;
     case InitStage::DEPTH_SNAPSHOT_REQUESTED:
       spdlog::debug("Depth snapshot request sent. Update buffered.");
-      depth_updates_buffer_.emplace_back(std::move(diff_depths));
+      BufferUpdate(std::move(diff_depths));
       break;
     case InitStage::SEARCH_FOR_FIRST_REAL_UPDATE:
       spdlog::debug("Waiting for first real update. Update buffered.");
-      depth_updates_buffer_.emplace_back(std::move(diff_depths));
+      BufferUpdate(std::move(diff_depths));
       ProcessBufferedUpdates();
       break;
     case InitStage::STREAM_STARTED:
-      assert((previous_last_update_id_ + 1 == diff_depths.U) &&
-             "Wrong depth update id order");
-      previous_last_update_id_ = diff_depths.u;
-      order_book_update_cb_(std::move(diff_depths));
+      if (previous_last_update_id_ + 1 != diff_depths.U) {
+        spdlog::warn("Depth update id gap: expected {}, got {}. Resync order book.",
+                     previous_last_update_id_ + 1, diff_depths.U);
+        RequestDepthSnapshot(std::move(diff_depths));
+        break;
+      }
+      ForwardDiff(std::move(diff_depths));
       break;
     default:
       spdlog::error("Not existing init state {} at order book forwarder",
@@ -56,15 +135,63 @@ void OrderBookStreamForwarder::OnBinAPIDepthUpdate(
   }
 }
 
+bool OrderBookStreamForwarder::ResumeFromStoredState(
+    binapi::ws::diff_depths_t& diff_depths) {
+  if (!stored_state_) {
+    return false;
+  }
+  auto state = std::move(*stored_state_);
+  stored_state_.reset();
+  const uint64_t next_update_id = state.last_update_id + 1;
+  if (diff_depths.U > next_update_id || next_update_id > diff_depths.u) {
+    spdlog::info("Stored order book state {} does not chain to update [{}, {}].",
+                 state.last_update_id, diff_depths.U, diff_depths.u);
+    return false;
+  }
+  spdlog::info("Resume order book from stored state {}.", state.last_update_id);
+  ForwardBook(std::move(state.order_book), state.last_update_id);
+  ForwardDiff(std::move(diff_depths));
+  OnStreamStarted();
+  return true;
+}
+
+void OrderBookStreamForwarder::RequestDepthSnapshot(
+    binapi::ws::diff_depths_t&& diff_depths) {
+  // Older updates are covered by the snapshot
+  depth_updates_buffer_.clear();
+  depth_updates_buffer_.emplace_back(std::move(diff_depths));
+  binapi_client_->GetDepthAsync(std::bind(&OrderBookStreamForwarder::OnBinAPIDepthRecieve,
+                                          this, std::placeholders::_1));
+  init_stage_ = InitStage::DEPTH_SNAPSHOT_REQUESTED;
+}
+
 void OrderBookStreamForwarder::OnBinAPIDepthRecieve(binapi::rest::depths_t&& depths) {
   spdlog::debug("OnBinAPIDepthRecieve recieved");
+  if (depth_updates_buffer_.front().U > depths.lastUpdateId + 1) {
+    // Served from a lagging cache, an immediate request would likely get the same
+    spdlog::warn("Depth snapshot {} is older than buffered updates. Send get depth "
+                 "request again after a delay.",
+                 depths.lastUpdateId);
+    binapi_client_->RunAfterRetryDelay([this]() {
+      binapi_client_->GetDepthAsync(std::bind(
+          &OrderBookStreamForwarder::OnBinAPIDepthRecieve, this, std::placeholders::_1));
+    });
+    return;
+  }
   depth_last_update_id_ = depths.lastUpdateId;
-  order_book_update_cb_(std::move(depths));
+  ForwardBook(std::move(depths), depth_last_update_id_);
   init_stage_ = InitStage::SEARCH_FOR_FIRST_REAL_UPDATE;
   ProcessBufferedUpdates();
 }
 
-std::vector<binapi::ws::diff_depths_t>::iterator
+void OrderBookStreamForwarder::BufferUpdate(binapi::ws::diff_depths_t&& diff_depths) {
+  if (depth_updates_buffer_.size() == gMaxBufferedUpdatesCount) {
+    depth_updates_buffer_.pop_front();
+  }
+  depth_updates_buffer_.emplace_back(std::move(diff_depths));
+}
+
+std::deque<binapi::ws::diff_depths_t>::iterator
 OrderBookStreamForwarder::SearchFirstRealUpdate(uint64_t last_update_id) {
   for (auto it = depth_updates_buffer_.begin(); it != depth_updates_buffer_.end(); ++it) {
     if (it->U <= last_update_id + 1 && last_update_id + 1 <= it->u) {
@@ -76,17 +203,72 @@ OrderBookStreamForwarder::SearchFirstRealUpdate(uint64_t last_update_id) {
 
 void OrderBookStreamForwarder::ProcessBufferedUpdates() {
   auto first_update_to_proceed_it = SearchFirstRealUpdate(depth_last_update_id_);
+  if (first_update_to_proceed_it == depth_updates_buffer_.end() &&
+      depth_updates_buffer_.back().U > depth_last_update_id_ + 1) {
+    spdlog::warn("Depth updates skipped past snapshot {}. Resync order book.",
+                 depth_last_update_id_);
+    auto diff_depths = std::move(depth_updates_buffer_.back());
+    RequestDepthSnapshot(std::move(diff_depths));
+    return;
+  }
   if (first_update_to_proceed_it != depth_updates_buffer_.end()) {
     spdlog::debug("First real update to start proceed found.");
     for (auto it = first_update_to_proceed_it; it != depth_updates_buffer_.end(); ++it) {
+      if (it != first_update_to_proceed_it && previous_last_update_id_ + 1 != it->U) {
+        spdlog::warn("Buffered depth update id gap: expected {}, got {}. Resync order "
+                     "book.",
+                     previous_last_update_id_ + 1, it->U);
+        auto diff_depths = std::move(depth_updates_buffer_.back());
+        RequestDepthSnapshot(std::move(diff_depths));
+        return;
+      }
       spdlog::debug("Fire buffered update.");
-      order_book_update_cb_(std::move(*it));
-      previous_last_update_id_ = it->u;
+      ForwardDiff(std::move(*it));
     }
     depth_updates_buffer_.clear();
-    spdlog::info("Order book stream started successfully.");
-    init_stage_ = InitStage::STREAM_STARTED;
-    stream_started_promise_.set_value();
+    OnStreamStarted();
+  }
+}
+
+void OrderBookStreamForwarder::OnStreamStarted() {
+  init_stage_ = InitStage::STREAM_STARTED;
+  if (is_stream_started_) {
+    spdlog::info("Order book stream resynced successfully.");
+    return;
+  }
+  spdlog::info("Order book stream started successfully.");
+  is_stream_started_ = true;
+  stream_started_promise_.set_value();
+}
+
+void OrderBookStreamForwarder::ForwardBook(types::OrderBook&& order_book,
+                                           uint64_t last_update_id) {
+  KeepState(order_book, last_update_id, true);
+  if (is_book_sent_ && nullptr != order_book_resync_cb_) {
+    order_book_resync_cb_(std::move(order_book));
+  } else {
+    order_book_update_cb_(std::move(order_book));
+  }
+  is_book_sent_ = true;
+}
+
+void OrderBookStreamForwarder::ForwardDiff(binapi::ws::diff_depths_t&& diff_depths) {
+  previous_last_update_id_ = diff_depths.u;
+  types::OrderBook update(std::move(diff_depths));
+  KeepState(update, previous_last_update_id_, false);
+  order_book_update_cb_(std::move(update));
+}
+
+void OrderBookStreamForwarder::KeepState(const types::OrderBook& update,
+                                         uint64_t last_update_id, bool is_whole_book) {
+  if (state_path_.empty()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  if (is_whole_book) {
+    state_engine_ = std::make_unique<analyzer::OrderBookEngine>(gStateMaxLevels);
   }
+  state_engine_->Apply(update);
+  state_last_update_id_ = last_update_id;
 }
 }  // namespace market_stream
\ No newline at end of file
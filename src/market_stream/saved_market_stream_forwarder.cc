@@ -68,6 +68,23 @@ bool SavedMarketStreamForwarder::ReadNext(utils::Timestamp* next_data_ts) {
       event_dispatcher_locked->DispatchEvent<MQ::Event::kOrderBookUpdateEvent>(
           order_book);
     };
+  } else if (types::MarketDataType::ORDER_BOOK_RESYNC == data_type) {
+    types::OrderBookResync resync;
+    if (!ReadNext(resync.order_book)) {
+      spdlog::error("Not able to read order_book resync as next data");
+      return false;
+    }
+    if (nullptr != next_data_ts) {
+      *next_data_ts = resync.order_book.received_timestamp;
+    }
+    forward_next_func_ = [this, resync]() {
+      auto event_dispatcher_locked = event_dispatcher_.lock();
+      if (nullptr == event_dispatcher_locked) {
+        spdlog::error("Event dispatcher not available");
+        exit(-1);
+      }
+      event_dispatcher_locked->DispatchEvent<MQ::Event::kOrderBookResyncEvent>(resync);
+    };
   } else if (types::MarketDataType::TRADE == data_type) {
     types::Trade trade;
     if (!ReadNext(trade)) {
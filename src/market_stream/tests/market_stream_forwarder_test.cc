@@ -20,6 +20,7 @@ class FakeBinAPIClient : public market_stream::IBinAPIClient {
       const DepthUpdateRawCallback& depth_book_update_cb) override {}
   void SubscribeToTradeStream(const TradeRawCallback& trade_cb) override {}
   void GetDepthAsync(const DepthRawCallback& depth_callback) override {}
+  void RunAfterRetryDelay(const std::function<void()>& func) override {}
   void Run() override {}
 };
 
@@ -130,6 +131,9 @@ TEST(MarketStreamForwarder, GivenMarketStreamForwarder_WhenNewEvents_ThenCallbac
       case MQ::Event::kOrderBookUpdateEvent:
         order_book_received_count++;
         break;
+      default:
+        ADD_FAILURE() << "Unexpected event " << static_cast<int>(event);
+        break;
     }
   });
 
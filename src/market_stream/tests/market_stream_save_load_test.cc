@@ -97,6 +97,10 @@ TEST_F(StorageFixture, GivenMarketStream_WhenStreamSaved_ThenCanBeLoaded) {
         recieved_stream.push_back(
             {market_stream::types::MarketDataType::ORDER_BOOK, combined_data});
         break;
+
+      default:
+        ADD_FAILURE() << "Unexpected event " << static_cast<int>(event);
+        break;
     }
   };
   event_hub2.CreateHandler().lock()->Subscribe(on_market_stream_cb);
@@ -2,11 +2,16 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <boost/filesystem.hpp>
 #include <cctype>
+#include <condition_variable>
+#include <fstream>
 #include <functional>
 #include <future>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "market_stream/i_binapi_client.h"
@@ -17,8 +22,8 @@ class FakeBinAPIClient : public market_stream::IBinAPIClient {
   static const int kOldDepthUpdatesCount = 3;
   static const int kRealDepthUpdatesCount = 4;
 
-  FakeBinAPIClient(bool check_wrong_update_ids)
-      : IBinAPIClient("BTCUSDT"), check_wrong_update_ids_(check_wrong_update_ids) {}
+  FakeBinAPIClient(bool send_update_ids_gap)
+      : IBinAPIClient("BTCUSDT"), send_update_ids_gap_(send_update_ids_gap) {}
 
   void SubscribeToDepthStream(
       const DepthUpdateRawCallback& depth_book_update_cb) override {
@@ -26,9 +31,12 @@ class FakeBinAPIClient : public market_stream::IBinAPIClient {
   }
   void SubscribeToTradeStream(const TradeRawCallback& trade_cb) override {}
   void GetDepthAsync(const DepthRawCallback& depth_callback) override {
+    std::lock_guard<std::mutex> lock(mutex_);
     depth_init_cb_ = depth_callback;
-    depth_requested_.set_value(true);
+    ++depth_requests_count_;
+    cv_.notify_all();
   }
+  void RunAfterRetryDelay(const std::function<void()>& func) override { func(); }
   void Run() override {
     run_finished_ = std::async(std::launch::async, [this]() {
       uint64_t previous_depth_u = 12342;
@@ -36,24 +44,28 @@ class FakeBinAPIClient : public market_stream::IBinAPIClient {
         binapi::ws::diff_depths_t diff_depth = BuildNextDiffDepth(previous_depth_u);
         depth_update_cb_(std::move(diff_depth));
       }
-      auto depth_requested_future = depth_requested_.get_future();
-      auto wait_result = depth_requested_future.wait_for(std::chrono::seconds(5));
-      if (wait_result == std::future_status::ready && depth_requested_future.get()) {
-        binapi::rest::depths_t depths;
-        depths.lastUpdateId = previous_depth_u + 100;
-        previous_depth_u = depths.lastUpdateId;
-        depth_init_cb_(std::move(depths));
+      if (!SendDepth(1, previous_depth_u + 100)) {
+        return;
       }
-      for (int i = 0; i < kRealDepthUpdatesCount; i++) {
-        binapi::ws::diff_depths_t diff_depth = BuildNextDiffDepth(previous_depth_u);
-        depth_update_cb_(std::move(diff_depth));
-        if (check_wrong_update_ids_) {
-          previous_depth_u = 0;
-        }
+      previous_depth_u += 100;
+      SendRealDepthUpdates(previous_depth_u);
+      if (!send_update_ids_gap_) {
+        return;
+      }
+
+      // Updates in between are lost
+      previous_depth_u += 50;
+      binapi::ws::diff_depths_t diff_depth = BuildNextDiffDepth(previous_depth_u);
+      const uint64_t resync_last_update_id = diff_depth.U + 2;
+      depth_update_cb_(std::move(diff_depth));
+      if (SendDepth(2, resync_last_update_id)) {
+        SendRealDepthUpdates(previous_depth_u);
       }
     });
   }
 
+  uint64_t last_sent_update_id() const { return last_sent_update_id_; }
+
   bool WaitForRunFinished() {
     if (run_finished_.wait_for(std::chrono::seconds(15)) == std::future_status::ready) {
       run_finished_.get();
@@ -68,15 +80,155 @@ class FakeBinAPIClient : public market_stream::IBinAPIClient {
     diff_depth.U = previous_depth_u + 1;
     diff_depth.u = diff_depth.U + 5;
     previous_depth_u = diff_depth.u;
+    last_sent_update_id_ = diff_depth.u;
     return diff_depth;
   }
 
-  bool check_wrong_update_ids_;
+  void SendRealDepthUpdates(uint64_t& previous_depth_u) {
+    for (int i = 0; i < kRealDepthUpdatesCount; i++) {
+      binapi::ws::diff_depths_t diff_depth = BuildNextDiffDepth(previous_depth_u);
+      depth_update_cb_(std::move(diff_depth));
+    }
+  }
+
+  // Answers the depth_request_number-th depth request
+  bool SendDepth(int depth_request_number, uint64_t last_update_id) {
+    DepthRawCallback depth_init_cb;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (!cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
+            return depth_requests_count_ >= depth_request_number;
+          })) {
+        return false;
+      }
+      depth_init_cb = depth_init_cb_;
+    }
+    binapi::rest::depths_t depths;
+    depths.lastUpdateId = last_update_id;
+    depth_init_cb(std::move(depths));
+    return true;
+  }
+
+  bool send_update_ids_gap_;
   std::future<void> run_finished_;
-  std::promise<bool> depth_requested_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int depth_requests_count_{0};
+  std::atomic<uint64_t> last_sent_update_id_{0};
   DepthUpdateRawCallback depth_update_cb_;
   DepthRawCallback depth_init_cb_;
 };
+
+// Sends updates_count chained updates from first_update_id on Run, never answers
+// depth requests
+class NoDepthBinAPIClient : public market_stream::IBinAPIClient {
+ public:
+  NoDepthBinAPIClient(uint64_t first_update_id, int updates_count)
+      : IBinAPIClient("BTCUSDT"),
+        first_update_id_(first_update_id),
+        updates_count_(updates_count) {}
+
+  void SubscribeToDepthStream(
+      const DepthUpdateRawCallback& depth_book_update_cb) override {
+    depth_update_cb_ = depth_book_update_cb;
+  }
+  void SubscribeToTradeStream(const TradeRawCallback& trade_cb) override {}
+  void GetDepthAsync(const DepthRawCallback& depth_callback) override {
+    ++depth_requests_count_;
+  }
+  void RunAfterRetryDelay(const std::function<void()>& func) override {}
+  void Run() override {
+    uint64_t update_id = first_update_id_;
+    for (int i = 0; i < updates_count_; i++) {
+      binapi::ws::diff_depths_t diff_depth;
+      diff_depth.U = update_id;
+      diff_depth.u = update_id + 5;
+      update_id = diff_depth.u + 1;
+      depth_update_cb_(std::move(diff_depth));
+    }
+  }
+
+  int depth_requests_count() const { return depth_requests_count_; }
+
+ private:
+  const uint64_t first_update_id_;
+  const int updates_count_;
+  int depth_requests_count_{0};
+  DepthUpdateRawCallback depth_update_cb_;
+};
+
+// Sends updates and answers depth requests only when told to, on the caller
+// thread. Delayed functions wait for RunDelayed.
+class ManualBinAPIClient : public market_stream::IBinAPIClient {
+ public:
+  ManualBinAPIClient() : IBinAPIClient("BTCUSDT") {}
+
+  void SubscribeToDepthStream(
+      const DepthUpdateRawCallback& depth_book_update_cb) override {
+    depth_update_cb_ = depth_book_update_cb;
+  }
+  void SubscribeToTradeStream(const TradeRawCallback& trade_cb) override {}
+  void GetDepthAsync(const DepthRawCallback& depth_callback) override {
+    depth_cb_ = depth_callback;
+    ++depth_requests_count_;
+  }
+  void RunAfterRetryDelay(const std::function<void()>& func) override {
+    delayed_.push_back(func);
+  }
+  void Run() override {}
+
+  void SendUpdate(uint64_t first_update_id, uint64_t last_update_id) {
+    binapi::ws::diff_depths_t diff_depth;
+    diff_depth.U = first_update_id;
+    diff_depth.u = last_update_id;
+    depth_update_cb_(std::move(diff_depth));
+  }
+  void SendDepth(uint64_t last_update_id) {
+    binapi::rest::depths_t depths;
+    depths.lastUpdateId = last_update_id;
+    depth_cb_(std::move(depths));
+  }
+  void RunDelayed() {
+    auto delayed = std::move(delayed_);
+    delayed_.clear();
+    for (const auto& it : delayed) {
+      it();
+    }
+  }
+
+  int depth_requests_count() const { return depth_requests_count_; }
+  std::size_t delayed_count() const { return delayed_.size(); }
+
+ private:
+  int depth_requests_count_{0};
+  std::vector<std::function<void()>> delayed_;
+  DepthUpdateRawCallback depth_update_cb_;
+  DepthRawCallback depth_cb_;
+};
+
+class OrderBookStateFixture : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    temp_dir_ =
+        boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directory(temp_dir_);
+  }
+  void TearDown() override { boost::filesystem::remove_all(temp_dir_); }
+
+  std::string state_path() const { return (temp_dir_ / "state.bin").string(); }
+
+  market_stream::types::OrderBookState WriteState(uint64_t last_update_id) const {
+    market_stream::types::OrderBookState state;
+    state.last_update_id = last_update_id;
+    state.order_book.timestamp = 1000;
+    state.order_book.bids = {{100, 1.5}, {99.5, 2}};
+    state.order_book.asks = {{101, 0.25}};
+    EXPECT_TRUE(market_stream::OrderBookStreamForwarder::WriteState(state_path(), state));
+    return state;
+  }
+
+  boost::filesystem::path temp_dir_;
+};
 }  // namespace
 
 TEST(OrderBookStreamForwarder,
@@ -103,26 +255,179 @@ TEST(OrderBookStreamForwarder,
 }
 
 TEST(OrderBookStreamForwarder,
-     GivenOrderBookStreamForwarder_WhenWrongUpdatesSequence_ThenAbort) {
+     GivenOrderBookStreamForwarder_WhenUpdateIdsGap_ThenResyncAndContinue) {
   // Given
   int depths_calls_counter = 0;
+  int resync_calls_counter = 0;
   auto depth_update_callback =
       [&depths_calls_counter](const market_stream::types::OrderBook& update) {
         ++depths_calls_counter;
       };
+  auto resync_callback =
+      [&resync_calls_counter](const market_stream::types::OrderBook& order_book) {
+        ++resync_calls_counter;
+      };
   auto binapi_client = std::make_shared<FakeBinAPIClient>(true);
-  market_stream::OrderBookStreamForwarder forwarder(binapi_client, depth_update_callback);
-#ifndef NDEBUG
-  EXPECT_DEATH(
-      [&]() {
-        // When
-        auto forwarder_started = forwarder.StartAsync();
-        binapi_client->Run();
-
-        // Then
-        forwarder_started.wait_for(std::chrono::seconds(5));
-        binapi_client->WaitForRunFinished();
-      }(),
-      "");
-#endif
-}
\ No newline at end of file
+  market_stream::OrderBookStreamForwarder forwarder(binapi_client, depth_update_callback,
+                                                    resync_callback);
+
+  // When
+  auto forwarder_started = forwarder.StartAsync();
+  binapi_client->Run();
+
+  // Then
+  ASSERT_NE(forwarder_started.wait_for(std::chrono::seconds(5)),
+            std::future_status::timeout);
+  ASSERT_TRUE(binapi_client->WaitForRunFinished());
+
+  EXPECT_EQ(resync_calls_counter, 1);
+  // First depth, real updates before the gap, the update after it that the resync
+  // depth starts from and real updates after it
+  EXPECT_EQ(depths_calls_counter, 1 + 2 * FakeBinAPIClient::kRealDepthUpdatesCount + 1);
+}
+
+TEST(OrderBookStreamForwarder,
+     GivenHoleInBufferedUpdates_WhenDepthReceived_ThenDepthRequestedAgain) {
+  // Given
+  int updates_count = 0;
+  auto binapi_client = std::make_shared<ManualBinAPIClient>();
+  market_stream::OrderBookStreamForwarder forwarder(
+      binapi_client,
+      [&updates_count](market_stream::types::OrderBook&& update) { ++updates_count; });
+  auto forwarder_started = forwarder.StartAsync();
+  binapi_client->SendUpdate(100, 105);
+  binapi_client->SendUpdate(106, 110);
+  // Updates 111-114 are lost
+  binapi_client->SendUpdate(115, 120);
+
+  // When
+  binapi_client->SendDepth(104);
+
+  // Then
+  EXPECT_EQ(binapi_client->depth_requests_count(), 2);
+  EXPECT_EQ(forwarder_started.wait_for(std::chrono::seconds(0)),
+            std::future_status::timeout);
+  // The depth and the updates before the hole
+  EXPECT_EQ(updates_count, 1 + 2);
+
+  binapi_client->SendDepth(117);
+  EXPECT_EQ(forwarder_started.wait_for(std::chrono::seconds(0)),
+            std::future_status::ready);
+  EXPECT_EQ(updates_count, 1 + 2 + 1 + 1);
+}
+
+TEST(OrderBookStreamForwarder,
+     GivenBufferedUpdates_WhenOlderDepthReceived_ThenDepthRequestedAgainAfterDelay) {
+  // Given
+  int updates_count = 0;
+  auto binapi_client = std::make_shared<ManualBinAPIClient>();
+  market_stream::OrderBookStreamForwarder forwarder(
+      binapi_client,
+      [&updates_count](market_stream::types::OrderBook&& update) { ++updates_count; });
+  auto forwarder_started = forwarder.StartAsync();
+  binapi_client->SendUpdate(200, 205);
+
+  // When
+  binapi_client->SendDepth(150);
+
+  // Then
+  EXPECT_EQ(binapi_client->depth_requests_count(), 1);
+  ASSERT_EQ(binapi_client->delayed_count(), 1);
+  binapi_client->SendUpdate(206, 210);
+  binapi_client->RunDelayed();
+  EXPECT_EQ(binapi_client->depth_requests_count(), 2);
+
+  binapi_client->SendDepth(207);
+  EXPECT_EQ(forwarder_started.wait_for(std::chrono::seconds(0)),
+            std::future_status::ready);
+  EXPECT_EQ(updates_count, 1 + 1);
+}
+
+TEST_F(OrderBookStateFixture,
+       GivenStartedStream_WhenStateSaved_ThenStateWritten) {
+  // Given
+  std::vector<market_stream::types::OrderBook> updates;
+  auto binapi_client = std::make_shared<FakeBinAPIClient>(false);
+  auto forwarder = std::make_unique<market_stream::OrderBookStreamForwarder>(
+      binapi_client,
+      [&updates](market_stream::types::OrderBook&& update) {
+        updates.push_back(std::move(update));
+      },
+      nullptr, state_path());
+  auto forwarder_started = forwarder->StartAsync();
+  binapi_client->Run();
+  ASSERT_NE(forwarder_started.wait_for(std::chrono::seconds(5)),
+            std::future_status::timeout);
+  ASSERT_TRUE(binapi_client->WaitForRunFinished());
+
+  // When
+  forwarder->SaveState();
+
+  // Then
+  const auto state = market_stream::OrderBookStreamForwarder::ReadState(state_path());
+  ASSERT_TRUE(state);
+  EXPECT_EQ(state->last_update_id, binapi_client->last_sent_update_id());
+  EXPECT_EQ(state->order_book.timestamp, updates.back().timestamp);
+}
+
+TEST_F(OrderBookStateFixture,
+       GivenPartialStateLeftByCrash_WhenStateWritten_ThenStoredStateReplaced) {
+  // Given
+  WriteState(500);
+  std::ofstream(state_path() + ".tmp", std::ios::binary) << "partial";
+
+  // When
+  WriteState(600);
+
+  // Then
+  const auto state = market_stream::OrderBookStreamForwarder::ReadState(state_path());
+  ASSERT_TRUE(state);
+  EXPECT_EQ(state->last_update_id, 600);
+  EXPECT_FALSE(boost::filesystem::exists(state_path() + ".tmp"));
+}
+
+TEST_F(OrderBookStateFixture, GivenStoredState_WhenFirstUpdateChains_ThenResumedFromIt) {
+  // Given
+  const auto state = WriteState(500);
+  std::vector<market_stream::types::OrderBook> updates;
+  auto binapi_client = std::make_shared<NoDepthBinAPIClient>(499, 3);
+  market_stream::OrderBookStreamForwarder forwarder(
+      binapi_client,
+      [&updates](market_stream::types::OrderBook&& update) {
+        updates.push_back(std::move(update));
+      },
+      nullptr, state_path());
+
+  // When
+  auto forwarder_started = forwarder.StartAsync();
+  binapi_client->Run();
+
+  // Then
+  ASSERT_EQ(forwarder_started.wait_for(std::chrono::seconds(0)),
+            std::future_status::ready);
+  EXPECT_EQ(binapi_client->depth_requests_count(), 0);
+  ASSERT_EQ(updates.size(), 1 + 3);
+  EXPECT_EQ(updates[0], state.order_book);
+}
+
+TEST_F(OrderBookStateFixture,
+       GivenStoredState_WhenFirstUpdateDoesNotChain_ThenDepthRequested) {
+  // Given
+  WriteState(500);
+  int updates_count = 0;
+  auto binapi_client = std::make_shared<NoDepthBinAPIClient>(600, 3);
+  market_stream::OrderBookStreamForwarder forwarder(
+      binapi_client,
+      [&updates_count](market_stream::types::OrderBook&& update) { ++updates_count; },
+      nullptr, state_path());
+
+  // When
+  auto forwarder_started = forwarder.StartAsync();
+  binapi_client->Run();
+
+  // Then
+  EXPECT_EQ(forwarder_started.wait_for(std::chrono::seconds(0)),
+            std::future_status::timeout);
+  EXPECT_EQ(binapi_client->depth_requests_count(), 1);
+  EXPECT_EQ(updates_count, 0);
+}
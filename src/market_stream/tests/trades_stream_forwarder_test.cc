@@ -21,6 +21,7 @@ class FakeBinAPIClient : public market_stream::IBinAPIClient {
     trade_cb_ = trade_cb;
   }
   void GetDepthAsync(const DepthRawCallback& depth_callback) override {}
+  void RunAfterRetryDelay(const std::function<void()>& func) override {}
   void Run() override {
     run_finished_ = std::async(std::launch::async, [this]() {
       for (int i = 0; i < kNewTradesCount; i++) {
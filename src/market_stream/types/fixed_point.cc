@@ -0,0 +1,47 @@
+#include "market_stream/types/fixed_point.h"
+
+#include <spdlog/spdlog.h>
+
+#include <cmath>
+#include <string>
+
+namespace market_stream {
+
+namespace types {
+
+namespace {
+int64_t SaturateTicks(bool is_negative, const std::string& value) {
+  spdlog::error("{} is out of the FixedPoint range", value);
+  return is_negative ? -FixedPoint::kMaxTicks : FixedPoint::kMaxTicks;
+}
+}  // namespace
+
+FixedPoint::FixedPoint(const DoubleType& value) {
+  const DoubleType ticks = boost::multiprecision::round(value * kScale);
+  if (ticks > kMaxTicks || ticks < -kMaxTicks) {
+    ticks_ = SaturateTicks(ticks < 0, value.str());
+    return;
+  }
+  ticks_ = ticks.convert_to<int64_t>();
+}
+
+FixedPoint::FixedPoint(double value) {
+  const double ticks = std::round(value * kScale);
+  // kMaxTicks as double is 2^63, the first value out of the range
+  if (!(std::abs(ticks) < static_cast<double>(kMaxTicks))) {
+    ticks_ = SaturateTicks(ticks < 0, std::to_string(value));
+    return;
+  }
+  ticks_ = static_cast<int64_t>(ticks);
+}
+
+DoubleType FixedPoint::ToDecimal() const { return DoubleType(ticks_) / kScale; }
+
+std::ostream& operator<<(std::ostream& os, FixedPoint o) {
+  os << o.ToDecimal();
+  return os;
+}
+
+}  // namespace types
+
+}  // namespace market_stream
@@ -0,0 +1,312 @@
+#include "market_stream/types/order_book_columns.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace market_stream {
+
+namespace types {
+
+namespace {
+// Binary search stops at this many levels, the rest is a linear scan
+const std::size_t gLevelsScanWindow = 32;
+
+bool IsBetter(int64_t level_price, int64_t price, bool is_increasing) {
+  return is_increasing ? level_price < price : level_price > price;
+}
+
+// Sums of quantity ticks overflow int64 within a few hundred levels on low priced
+// symbols, so the high and low 32 bit halves of ticks are summed separately. Both
+// halves of a level fit into 32 bits, so neither sum overflows below 2^31 levels.
+// Quantities are never negative.
+struct TicksSum {
+  int64_t high{0};
+  int64_t low{0};
+
+  void Add(int64_t ticks) {
+    high += ticks >> 32;
+    low += ticks & 0xFFFFFFFF;
+  }
+  // In units, not ticks
+  double ToDouble() const {
+    return (static_cast<double>(high) * 4294967296.0 + static_cast<double>(low)) /
+           FixedPoint::kScale;
+  }
+};
+
+// Levels below this quantity can be added by 4 at a time to any running total
+// below gMaxSafeRunningTicks without overflow
+const int64_t gMaxSafeLevelTicks = int64_t(1) << 60;
+const int64_t gMaxSafeRunningTicks = INT64_MAX - 4 * gMaxSafeLevelTicks;
+
+#if defined(__AVX2__)
+std::size_t CountLanes(int mask) {
+  return (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+}
+
+__m256i Load(const int64_t* data) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+}
+
+int64_t HorizontalSum(__m256i v) {
+  alignas(32) int64_t lanes[4];
+  _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), v);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+double HorizontalSum(__m256d v) {
+  alignas(32) double lanes[4];
+  _mm256_store_pd(lanes, v);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+// [a, b, c, d] -> [a, a + b, a + b + c, a + b + c + d]
+__m256i PrefixSum(__m256i v) {
+  const __m256i zero = _mm256_setzero_si256();
+  v = _mm256_add_epi64(
+      v, _mm256_blend_epi32(_mm256_permute4x64_epi64(v, _MM_SHUFFLE(2, 1, 0, 0)), zero,
+                            0x03));
+  v = _mm256_add_epi64(
+      v, _mm256_blend_epi32(_mm256_permute4x64_epi64(v, _MM_SHUFFLE(1, 0, 0, 0)), zero,
+                            0x0F));
+  return v;
+}
+
+__m256i BroadcastLast(__m256i v) {
+  return _mm256_permute4x64_epi64(v, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+int64_t LastLane(__m256i v) {
+  return _mm256_extract_epi64(v, 3);
+}
+
+__m256i HighHalves(__m256i v) { return _mm256_srli_epi64(v, 32); }
+
+__m256i LowHalves(__m256i v) {
+  return _mm256_and_si256(v, _mm256_set1_epi64x(0xFFFFFFFF));
+}
+#endif
+
+std::size_t CountBetter(const int64_t* prices, std::size_t count, int64_t price,
+                        bool is_increasing) {
+  std::size_t result = 0;
+  std::size_t i = 0;
+#if defined(__AVX2__)
+  const __m256i price_v = _mm256_set1_epi64x(price);
+  for (; i + 4 <= count; i += 4) {
+    const __m256i levels = Load(prices + i);
+    const __m256i better = is_increasing ? _mm256_cmpgt_epi64(price_v, levels)
+                                         : _mm256_cmpgt_epi64(levels, price_v);
+    result += CountLanes(_mm256_movemask_pd(_mm256_castsi256_pd(better)));
+  }
+#endif
+  for (; i < count; i++) {
+    result += IsBetter(prices[i], price, is_increasing) ? 1 : 0;
+  }
+  return result;
+}
+
+TicksSum Sum(const int64_t* values, std::size_t count) {
+  TicksSum result;
+  std::size_t i = 0;
+#if defined(__AVX2__)
+  __m256i high = _mm256_setzero_si256();
+  __m256i low = _mm256_setzero_si256();
+  for (; i + 4 <= count; i += 4) {
+    const __m256i v = Load(values + i);
+    high = _mm256_add_epi64(high, HighHalves(v));
+    low = _mm256_add_epi64(low, LowHalves(v));
+  }
+  result.high = HorizontalSum(high);
+  result.low = HorizontalSum(low);
+#endif
+  for (; i < count; i++) {
+    result.Add(values[i]);
+  }
+  return result;
+}
+
+struct DotProducts {
+  double local_reference{0.0};
+  double local_local{0.0};
+  double reference_reference{0.0};
+};
+
+DotProducts CalculateDotProducts(const double* local, const double* reference,
+                                 std::size_t count) {
+  DotProducts result;
+  std::size_t i = 0;
+#if defined(__AVX2__)
+  __m256d local_reference = _mm256_setzero_pd();
+  __m256d local_local = _mm256_setzero_pd();
+  __m256d reference_reference = _mm256_setzero_pd();
+  for (; i + 4 <= count; i += 4) {
+    const __m256d l = _mm256_loadu_pd(local + i);
+    const __m256d r = _mm256_loadu_pd(reference + i);
+    local_reference = _mm256_add_pd(local_reference, _mm256_mul_pd(l, r));
+    local_local = _mm256_add_pd(local_local, _mm256_mul_pd(l, l));
+    reference_reference = _mm256_add_pd(reference_reference, _mm256_mul_pd(r, r));
+  }
+  result.local_reference = HorizontalSum(local_reference);
+  result.local_local = HorizontalSum(local_local);
+  result.reference_reference = HorizontalSum(reference_reference);
+#endif
+  for (; i < count; i++) {
+    result.local_reference += local[i] * reference[i];
+    result.local_local += local[i] * local[i];
+    result.reference_reference += reference[i] * reference[i];
+  }
+  return result;
+}
+}  // namespace
+
+OrderBookLevels::OrderBookLevels(const OrderBook::Items& items, bool is_increasing)
+    : is_increasing_(is_increasing) {
+  prices_.reserve(items.size());
+  quantities_.reserve(items.size());
+  for (const auto& it : items) {
+    prices_.push_back(it.price.ticks());
+    quantities_.push_back(it.quantity.ticks());
+  }
+}
+
+std::size_t OrderBookLevels::CountLevelsBetterThan(FixedPoint price) const {
+  const int64_t price_ticks = price.ticks();
+  std::size_t first = 0;
+  std::size_t count = size();
+  while (count > gLevelsScanWindow) {
+    const std::size_t half = count / 2;
+    if (IsBetter(prices_[first + half], price_ticks, is_increasing_)) {
+      first += half + 1;
+      count -= half + 1;
+    } else {
+      count = half;
+    }
+  }
+  return first + CountBetter(prices_.data() + first, count, price_ticks, is_increasing_);
+}
+
+std::size_t OrderBookLevels::FindLevel(FixedPoint price) const {
+  const std::size_t level = CountLevelsBetterThan(price);
+  if (level < size() && prices_[level] == price.ticks()) {
+    return level;
+  }
+  return size();
+}
+
+double OrderBookLevels::Depth(std::size_t levels_count) const {
+  return Sum(quantities_.data(), std::min(levels_count, size())).ToDouble();
+}
+
+std::vector<double> OrderBookLevels::CumulativeDepth() const {
+  std::vector<double> result(size());
+  TicksSum running;
+  std::size_t i = 0;
+#if defined(__AVX2__)
+  __m256i high_carry = _mm256_setzero_si256();
+  __m256i low_carry = _mm256_setzero_si256();
+  alignas(32) int64_t high_lanes[4];
+  alignas(32) int64_t low_lanes[4];
+  for (; i + 4 <= size(); i += 4) {
+    const __m256i v = Load(quantities_.data() + i);
+    const __m256i high = _mm256_add_epi64(PrefixSum(HighHalves(v)), high_carry);
+    const __m256i low = _mm256_add_epi64(PrefixSum(LowHalves(v)), low_carry);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(high_lanes), high);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(low_lanes), low);
+    for (std::size_t lane = 0; lane < 4; lane++) {
+      result[i + lane] = TicksSum{high_lanes[lane], low_lanes[lane]}.ToDouble();
+    }
+    high_carry = BroadcastLast(high);
+    low_carry = BroadcastLast(low);
+  }
+  running.high = LastLane(high_carry);
+  running.low = LastLane(low_carry);
+#endif
+  for (; i < size(); i++) {
+    running.Add(quantities_[i]);
+    result[i] = running.ToDouble();
+  }
+  return result;
+}
+
+std::size_t OrderBookLevels::FindLevelForVolume(FixedPoint volume) const {
+  const int64_t volume_ticks = volume.ticks();
+  int64_t running = 0;
+  std::size_t i = 0;
+#if defined(__AVX2__)
+  const __m256i volume_v = _mm256_set1_epi64x(volume_ticks);
+  const __m256i max_safe_level_v = _mm256_set1_epi64x(gMaxSafeLevelTicks);
+  __m256i carry = _mm256_setzero_si256();
+  for (; i + 4 <= size(); i += 4) {
+    const __m256i levels = Load(quantities_.data() + i);
+    // Huge levels or totals are left to the overflow safe scalar loop
+    if (LastLane(carry) > gMaxSafeRunningTicks ||
+        0 != _mm256_movemask_pd(_mm256_castsi256_pd(
+                 _mm256_cmpgt_epi64(levels, max_safe_level_v)))) {
+      break;
+    }
+    const __m256i depth = _mm256_add_epi64(PrefixSum(levels), carry);
+    // Depth never decreases, so the levels short of volume are the leading lanes
+    const int short_of_volume =
+        _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(volume_v, depth)));
+    if (0x0F != short_of_volume) {
+      return i + CountLanes(short_of_volume);
+    }
+    carry = BroadcastLast(depth);
+  }
+  running = LastLane(carry);
+#endif
+  // running stays below volume_ticks, so it never overflows
+  for (; i < size(); i++) {
+    if (quantities_[i] >= volume_ticks - running) {
+      return i;
+    }
+    running += quantities_[i];
+  }
+  return size();
+}
+
+std::optional<double> OrderBookLevels::CosineSimilarity(const OrderBookLevels& local,
+                                                        const OrderBookLevels& reference,
+                                                        std::size_t levels_count) {
+  const std::size_t count = std::min(levels_count, reference.size());
+  const bool is_increasing = reference.is_increasing_;
+
+  // Quantities are compared as raw ticks, the scale cancels out
+  std::vector<double> local_quantities(count, 0.0);
+  std::vector<double> reference_quantities(count);
+  std::size_t j = 0;
+  for (std::size_t i = 0; i < count; i++) {
+    const int64_t price = reference.prices_[i];
+    reference_quantities[i] = static_cast<double>(reference.quantities_[i]);
+    while (j < local.size() && IsBetter(local.prices_[j], price, is_increasing)) {
+      ++j;
+    }
+    if (j < local.size() && local.prices_[j] == price) {
+      local_quantities[i] = static_cast<double>(local.quantities_[j]);
+    }
+  }
+
+  const auto dot = CalculateDotProducts(local_quantities.data(),
+                                        reference_quantities.data(), count);
+  if (0.0 == dot.local_local || 0.0 == dot.reference_reference) {
+    return std::nullopt;
+  }
+  return dot.local_reference /
+         (std::sqrt(dot.local_local) * std::sqrt(dot.reference_reference));
+}
+
+OrderBookColumns::OrderBookColumns(const OrderBook& order_book)
+    : timestamp(order_book.timestamp),
+      received_timestamp(order_book.received_timestamp),
+      bids(order_book.bids, false),
+      asks(order_book.asks, true) {}
+
+}  // namespace types
+
+}  // namespace market_stream
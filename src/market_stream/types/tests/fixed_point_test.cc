@@ -0,0 +1,85 @@
+#include "market_stream/types/fixed_point.h"
+
+#include <gtest/gtest.h>
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <sstream>
+
+using market_stream::types::DoubleType;
+using market_stream::types::FixedPoint;
+
+TEST(FixedPoint, GivenDecimals_WhenConverted_ThenExactTicks) {
+  // Given
+  const DoubleType price("27012.34000001");
+  const DoubleType quantity("0.00000001");
+
+  // When
+  const FixedPoint fixed_price(price);
+  const FixedPoint fixed_quantity(quantity);
+
+  // Then
+  EXPECT_EQ(fixed_price.ticks(), 2701234000001ll);
+  EXPECT_EQ(fixed_quantity.ticks(), 1);
+  EXPECT_EQ(fixed_price.ToDecimal(), price);
+  EXPECT_EQ(fixed_quantity.ToDecimal(), quantity);
+  EXPECT_EQ(FixedPoint(1.05), FixedPoint(DoubleType("1.05")));
+  EXPECT_EQ(FixedPoint(-1).ticks(), -FixedPoint::kScale);
+}
+
+TEST(FixedPoint, GivenValuesOutOfRange_WhenConverted_ThenSaturatedByBothConversions) {
+  // Given
+  const double max_value = 9.2e10;
+  const double too_large_value = 1e11;
+
+  // When
+  const FixedPoint from_double(too_large_value), from_negative_double(-too_large_value);
+  const FixedPoint from_decimal(DoubleType("1e11")),
+      from_negative_decimal(DoubleType("-1e11"));
+
+  // Then
+  EXPECT_EQ(FixedPoint(max_value).ticks(), 9200000000000000000ll);
+  EXPECT_EQ(FixedPoint(DoubleType("9.2e10")).ticks(), 9200000000000000000ll);
+  EXPECT_EQ(from_double.ticks(), FixedPoint::kMaxTicks);
+  EXPECT_EQ(from_decimal.ticks(), FixedPoint::kMaxTicks);
+  EXPECT_EQ(from_negative_double.ticks(), -FixedPoint::kMaxTicks);
+  EXPECT_EQ(from_negative_decimal.ticks(), -FixedPoint::kMaxTicks);
+}
+
+TEST(FixedPoint, GivenFixedPoints_WhenCompared_ThenComparedAsTicks) {
+  // Given
+  const FixedPoint a(120.1), b(120.10000001), zero;
+
+  // Then
+  EXPECT_LT(a, b);
+  EXPECT_GT(b, a);
+  EXPECT_NE(a, b);
+  EXPECT_EQ(b - a, FixedPoint::FromTicks(1));
+  EXPECT_EQ(a + (b - a), b);
+  EXPECT_TRUE(zero.is_zero());
+  EXPECT_TRUE((a - a).is_zero());
+}
+
+TEST(FixedPoint, GivenFixedPoint_WhenSerialized_ThenSameBytesAsDoubleType) {
+  // Given
+  const DoubleType decimal("134.2");
+  const FixedPoint fixed(decimal);
+  std::stringstream decimal_stream, fixed_stream;
+
+  // When
+  {
+    boost::archive::binary_oarchive decimal_archive(decimal_stream);
+    decimal_archive << decimal;
+    boost::archive::binary_oarchive fixed_archive(fixed_stream);
+    fixed_archive << fixed;
+  }
+  FixedPoint loaded;
+  {
+    boost::archive::binary_iarchive archive(decimal_stream);
+    archive >> loaded;
+  }
+
+  // Then
+  EXPECT_EQ(fixed_stream.str(), decimal_stream.str());
+  EXPECT_EQ(loaded, fixed);
+}
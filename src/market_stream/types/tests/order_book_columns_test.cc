@@ -0,0 +1,99 @@
+#include "market_stream/types/order_book_columns.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+
+using market_stream::types::FixedPoint;
+using market_stream::types::OrderBook;
+using market_stream::types::OrderBookLevels;
+
+namespace {
+// Enough levels to go through both the vectorised loops and their scalar tails
+OrderBook::Items MakeItems(int count, bool is_increasing) {
+  OrderBook::Items items;
+  for (int i = 0; i < count; i++) {
+    const int64_t price = is_increasing ? 1000 + i : 1000 - i;
+    items.emplace_back(FixedPoint::FromTicks(price), FixedPoint::FromTicks(i % 3 + 2));
+  }
+  return items;
+}
+}  // namespace
+
+TEST(OrderBookColumns, GivenLevels_WhenLookedUp_ThenFoundByPrice) {
+  // Given
+  const OrderBookLevels asks(MakeItems(103, true), true);
+  const OrderBookLevels bids(MakeItems(103, false), false);
+
+  // Then
+  for (int i = 0; i < 103; i++) {
+    EXPECT_EQ(asks.FindLevel(FixedPoint::FromTicks(1000 + i)), i);
+    EXPECT_EQ(bids.FindLevel(FixedPoint::FromTicks(1000 - i)), i);
+  }
+  EXPECT_EQ(asks.FindLevel(FixedPoint::FromTicks(999)), asks.size());
+  EXPECT_EQ(bids.FindLevel(FixedPoint::FromTicks(1001)), bids.size());
+  EXPECT_EQ(asks.CountLevelsBetterThan(FixedPoint::FromTicks(2000)), asks.size());
+  EXPECT_EQ(bids.CountLevelsBetterThan(FixedPoint::FromTicks(2000)), 0);
+  EXPECT_EQ(bids.CountLevelsBetterThan(FixedPoint::FromTicks(950)), 50);
+}
+
+TEST(OrderBookColumns, GivenLevels_WhenDepthCalculated_ThenRunningTotals) {
+  // Given
+  const auto items = MakeItems(103, true);
+  const OrderBookLevels asks(items, true);
+
+  // When
+  const auto cumulative_depth = asks.CumulativeDepth();
+
+  // Then
+  ASSERT_EQ(cumulative_depth.size(), items.size());
+  FixedPoint expected;
+  for (std::size_t i = 0; i < items.size(); i++) {
+    expected += items[i].quantity;
+    EXPECT_EQ(cumulative_depth[i], expected.ToDouble());
+    EXPECT_EQ(asks.Depth(i + 1), expected.ToDouble());
+    EXPECT_EQ(asks.FindLevelForVolume(expected), i);
+    EXPECT_EQ(asks.FindLevelForVolume(expected - FixedPoint::FromTicks(1)), i);
+  }
+  EXPECT_EQ(asks.Depth(1000), expected.ToDouble());
+  EXPECT_EQ(asks.FindLevelForVolume(expected + FixedPoint::FromTicks(1)), asks.size());
+}
+
+TEST(OrderBookColumns, GivenLowPricedSymbolLevels_WhenDepthCalculated_ThenNoOverflow) {
+  // Given
+  // 1e9 units per level, int64 ticks of the total overflow after 92 levels
+  const FixedPoint kQuantity = FixedPoint::FromTicks(100000000000000000);
+  OrderBook::Items items;
+  for (int i = 0; i < 103; i++) {
+    items.emplace_back(FixedPoint::FromTicks(1000 + i), kQuantity);
+  }
+  const OrderBookLevels asks(items, true);
+
+  // When
+  const auto cumulative_depth = asks.CumulativeDepth();
+
+  // Then
+  ASSERT_EQ(cumulative_depth.size(), items.size());
+  for (std::size_t i = 0; i < items.size(); i++) {
+    EXPECT_DOUBLE_EQ(cumulative_depth[i], 1e9 * (i + 1));
+  }
+  EXPECT_DOUBLE_EQ(asks.Depth(103), 1.03e11);
+  EXPECT_EQ(asks.FindLevelForVolume(FixedPoint::FromTicks(INT64_MAX)), 92);
+}
+
+TEST(OrderBookColumns, GivenBooks_WhenCompared_ThenCosineSimilarityOfMatchedLevels) {
+  // Given
+  const OrderBookLevels reference({{133.2, 2}, {133.1, 1}, {133.0, 2}, {132.9, 4}}, false);
+  const OrderBookLevels same(
+      {{133.3, 7}, {133.2, 2}, {133.1, 1}, {133.0, 2}, {132.9, 4}, {132.8, 3}}, false);
+  const OrderBookLevels partial({{133.2, 2}, {133.05, 5}, {132.9, 4}}, false);
+  const OrderBookLevels disjoint({{140, 2}, {100, 1}}, false);
+
+  // Then
+  EXPECT_NEAR(*OrderBookLevels::CosineSimilarity(same, reference, 4), 1.0, 1e-12);
+  EXPECT_NEAR(*OrderBookLevels::CosineSimilarity(partial, reference, 4),
+              (2.0 * 2 + 4 * 4) / (std::sqrt(2.0 * 2 + 4 * 4) * 5.0), 1e-12);
+  EXPECT_FALSE(OrderBookLevels::CosineSimilarity(disjoint, reference, 4));
+  EXPECT_NEAR(*OrderBookLevels::CosineSimilarity(partial, reference, 1), 1.0, 1e-12);
+}
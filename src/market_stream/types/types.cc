@@ -54,6 +54,55 @@ std::ostream& operator<<(std::ostream& os, const OrderBook::Items& o) {
   return os;
 }
 
+std::ostream& operator<<(std::ostream& os, const BestBidOffer& o) {
+  os << std::fixed << std::setprecision(6);
+  os << "BestBidOffer: [timestamp: " << o.timestamp
+     << " ms, r_timestamp: " << o.received_timestamp << " ms, bid: " << o.bid
+     << ", ask: " << o.ask << "]\n";
+  return os;
+}
+
+std::ostream& operator<<(std::ostream& os, const OrderBookDepth& o) {
+  os << std::fixed << std::setprecision(6);
+  os << "OrderBookDepth: [timestamp: " << o.timestamp
+     << " ms, r_timestamp: " << o.received_timestamp << " ms, ";
+  os << "bids: " << o.bids;
+  os << ", asks: " << o.asks;
+  os << "]\n";
+  return os;
+}
+
+std::ostream& operator<<(std::ostream& os, const OrderBookResync& o) {
+  os << "OrderBookResync: " << o.order_book;
+  return os;
+}
+
+std::ostream& operator<<(std::ostream& os, const OrderBookResyncMarker& o) {
+  os << "OrderBookResyncMarker: [timestamp: " << o.timestamp
+     << " ms, r_timestamp: " << o.received_timestamp << " ms]\n";
+  return os;
+}
+
+std::vector<int64_t> OrderBookState::ToTicks(const OrderBook::Items& items) {
+  std::vector<int64_t> ticks;
+  ticks.reserve(2 * items.size());
+  for (const auto& it : items) {
+    ticks.push_back(it.price.ticks());
+    ticks.push_back(it.quantity.ticks());
+  }
+  return ticks;
+}
+
+OrderBook::Items OrderBookState::FromTicks(const std::vector<int64_t>& ticks) {
+  OrderBook::Items items;
+  items.reserve(ticks.size() / 2);
+  for (std::size_t i = 0; i + 1 < ticks.size(); i += 2) {
+    items.emplace_back(FixedPoint::FromTicks(ticks[i]),
+                       FixedPoint::FromTicks(ticks[i + 1]));
+  }
+  return items;
+}
+
 Trade::Trade(binapi::ws::trade_t&& trade) noexcept
     : price(trade.p),
       quantity(trade.q),
@@ -89,6 +138,24 @@ bool operator==(const OrderBook::Item& a, const OrderBook::Item& b) noexcept {
   return a.price == b.price && a.quantity == b.quantity;
 }
 
+bool operator==(const BestBidOffer& a, const BestBidOffer& b) noexcept {
+  return a.timestamp == b.timestamp && a.received_timestamp == b.received_timestamp &&
+         a.bid == b.bid && a.ask == b.ask;
+}
+
+bool operator==(const OrderBookDepth& a, const OrderBookDepth& b) noexcept {
+  return a.timestamp == b.timestamp && a.received_timestamp == b.received_timestamp &&
+         a.bids == b.bids && a.asks == b.asks;
+}
+
+bool operator==(const OrderBookResyncMarker& a, const OrderBookResyncMarker& b) noexcept {
+  return a.timestamp == b.timestamp && a.received_timestamp == b.received_timestamp;
+}
+
+bool operator==(const OrderBookState& a, const OrderBookState& b) noexcept {
+  return a.last_update_id == b.last_update_id && a.order_book == b.order_book;
+}
+
 }  // namespace types
 
 }  // namespace market_stream
\ No newline at end of file